@@ -136,26 +136,32 @@ static std::string languageCodeToString(LanguageCode code) {
 
 struct ExplorerExtension;
 
-static std::optional<ExplorerItem> tryFetchFw(ExplorerExtension &ext,
-                                              const std::string &uri);
-static std::optional<ExplorerItem> tryFetchGame(ExplorerExtension &ext,
-                                                const std::string &uri);
-static std::optional<ExplorerItem> tryFetchPs3Game(ExplorerExtension &ext,
-                                                   const std::string &uri);
+static Task<std::optional<ExplorerItem>> tryFetchFw(ExplorerExtension &ext,
+                                                    const std::string &uri);
+static Task<std::optional<ExplorerItem>>
+tryFetchGame(ExplorerExtension &ext, const std::string &uri);
+static Task<std::optional<ExplorerItem>>
+tryFetchPs3Game(ExplorerExtension &ext, const std::string &uri);
 
 struct ExplorerDescriber : ExplorerDescriberInterface {
   ExplorerExtension &ext;
   ExplorerDescriber(ExplorerExtension &ext) : ext(ext) {}
 
-  ExplorerDescriberDescribeResponse
+  Task<ExplorerDescriberDescribeResponse>
   describe(const ExplorerDescriberDescribeRequest &request) override {
     ExplorerDescriberDescribeResponse result;
+    auto stopToken = Protocol::getRequestStopToken();
 
     unsigned index = -1;
     for (auto &uri : request.uris) {
       index++;
 
-      if (auto game = tryFetchGame(ext, uri)) {
+      // host gave up on this scan, results would be discarded
+      if (stopToken.stop_requested()) {
+        break;
+      }
+
+      if (auto game = co_await tryFetchGame(ext, uri)) {
         result.results.push_back({
             .item = std::move(*game),
             .uriIndex = int(index),
@@ -163,7 +169,7 @@ struct ExplorerDescriber : ExplorerDescriberInterface {
         continue;
       }
 
-      if (auto fw = tryFetchFw(ext, uri)) {
+      if (auto fw = co_await tryFetchFw(ext, uri)) {
         result.results.push_back({
             .item = std::move(*fw),
             .uriIndex = int(index),
@@ -171,7 +177,7 @@ struct ExplorerDescriber : ExplorerDescriberInterface {
         continue;
       }
 
-      if (auto game = tryFetchPs3Game(ext, uri)) {
+      if (auto game = co_await tryFetchPs3Game(ext, uri)) {
         result.results.push_back({
             .item = std::move(*game),
             .uriIndex = int(index),
@@ -180,7 +186,7 @@ struct ExplorerDescriber : ExplorerDescriberInterface {
       }
     }
 
-    return result;
+    co_return result;
   }
 };
 
@@ -237,110 +243,141 @@ fetchLocalizedString(const sfo::registry &registry, const std::string &key) {
   return result;
 }
 
-static bool isFile(ExplorerExtension &extension, const std::string &uri) {
-  if (auto statResult = extension.fsStat(uri).get();
-      statResult.has_value() && statResult->type == FsDirEntryType::File) {
-    return true;
+static Task<bool> isFile(ExplorerExtension &extension, std::string uri) {
+  auto statResult = co_await extension.fsStat(uri);
+  co_return statResult.has_value() &&
+      statResult->type == FsDirEntryType::File;
+}
+
+// Stats every uri with one batch instead of a round trip per probe
+static Task<std::vector<bool>>
+areFiles(ExplorerExtension &extension, const std::vector<std::string> &uris) {
+  std::vector<bool> result(uris.size());
+
+  if (Protocol::getRequestStopToken().stop_requested()) {
+    co_return result;
+  }
+
+  CallBatch<FsStatResponse> batch(extension.getProtocol());
+  for (auto &uri : uris) {
+    batch.add("fs/stat", uri);
+  }
+
+  auto responses = co_await std::move(batch);
+
+  for (std::size_t i = 0; i < responses.size(); ++i) {
+    result[i] = responses[i].has_value() &&
+                responses[i]->type == FsDirEntryType::File;
   }
 
-  return false;
+  co_return result;
 }
 
-static std::vector<LocalizedResource>
+static Task<std::vector<LocalizedResource>>
 fetchLocalizedResourceFile(ExplorerExtension &extension, const std::string &uri,
                            const std::string &name, const std::string &ext) {
   std::vector<LocalizedResource> result;
 
-  if (auto testPath = uri + "/" + name + ext; isFile(extension, testPath)) {
-    result.push_back(LocalizedResource{
-        .uri = std::move(testPath),
-    });
-  } else {
-    return {};
+  auto testPath = uri + "/" + name + ext;
+  if (!co_await isFile(extension, testPath)) {
+    co_return result;
   }
 
+  result.push_back(LocalizedResource{
+      .uri = std::move(testPath),
+  });
+
+  std::vector<std::string> testPaths;
+
   for (std::size_t i = 0; i < static_cast<int>(LanguageCode::_count); ++i) {
     std::string suffix = (i < 10 ? "_0" : "_");
     suffix += std::to_string(i);
+    testPaths.push_back(uri + "/" + name + suffix + ext);
+  }
 
-    if (auto testPath = uri + "/" + name + suffix + ext;
-        isFile(extension, testPath)) {
+  auto exists = co_await areFiles(extension, testPaths);
+
+  for (std::size_t i = 0; i < testPaths.size(); ++i) {
+    if (exists[i]) {
       result.push_back(LocalizedResource{
-          .uri = std::move(testPath),
+          .uri = std::move(testPaths[i]),
           .lang = languageCodeToString(static_cast<LanguageCode>(i)),
       });
     }
   }
 
-  return result;
+  co_return result;
 }
 
-static std::vector<LocalizedImage>
+static Task<std::vector<LocalizedImage>>
 fetchLocalizedImageFile(ExplorerExtension &extension, const std::string &uri,
                         const std::string &name, const std::string &ext) {
   std::vector<LocalizedImage> result;
 
-  if (auto testPath = uri + "/" + name + ext; isFile(extension, testPath)) {
-    result.push_back(LocalizedImage{
-        .uri = std::move(testPath),
-        .resolution = ImageResolution::Normal,
-    });
-  }
-
-  if (auto testPath = uri + "/" + name + "_4k" + ext;
-      isFile(extension, testPath)) {
-    result.push_back(LocalizedImage{
-        .uri = std::move(testPath),
-        .resolution = ImageResolution::High,
-    });
-  }
+  // default and 4k images, then the same pair for each language
+  std::vector<std::string> testPaths = {
+      uri + "/" + name + ext,
+      uri + "/" + name + "_4k" + ext,
+  };
 
   for (std::size_t i = 0; i < static_cast<int>(LanguageCode::_count); ++i) {
     std::string suffix = (i < 10 ? "_0" : "_");
     suffix += std::to_string(i);
+    testPaths.push_back(uri + "/" + name + suffix + ext);
+    testPaths.push_back(uri + "/" + name + "_4k" + suffix + ext);
+  }
 
-    if (auto testPath = uri + "/" + name + suffix + ext;
-        isFile(extension, testPath)) {
-      result.push_back(LocalizedImage{
-          .uri = std::move(testPath),
-          .lang = languageCodeToString(static_cast<LanguageCode>(i)),
-          .resolution = ImageResolution::Normal,
-      });
+  auto exists = co_await areFiles(extension, testPaths);
+
+  for (std::size_t i = 0; i < testPaths.size(); ++i) {
+    if (!exists[i]) {
+      continue;
     }
 
-    if (auto testPath = uri + "/" + name + "_4k" + suffix + ext;
-        isFile(extension, testPath)) {
-      result.push_back(LocalizedImage{
-          .uri = std::move(testPath),
-          .lang = languageCodeToString(static_cast<LanguageCode>(i)),
-          .resolution = ImageResolution::High,
-      });
+    LocalizedImage image{
+        .uri = std::move(testPaths[i]),
+        .resolution =
+            i % 2 == 0 ? ImageResolution::Normal : ImageResolution::High,
+    };
+
+    if (i >= 2) {
+      image.lang = languageCodeToString(static_cast<LanguageCode>(i / 2 - 1));
     }
+
+    result.push_back(std::move(image));
   }
 
-  return result;
+  co_return result;
 }
 
-static std::optional<ExplorerItem> tryFetchFw(ExplorerExtension &ext,
-                                              const std::string &uri) {
-  if (!isFile(ext, uri + "/mini-syscore.elf")) {
-    return {};
+static Task<std::optional<ExplorerItem>>
+tryFetchFw(ExplorerExtension &ext, const std::string &uri) {
+  auto sysPath = uri + "/system/sys";
+  auto miniSyscorePath = uri + "/mini-syscore.elf";
+  auto safemodePath = uri + "/safemode.elf";
+  auto sysCorePath = sysPath + "/SceSysCore.elf";
+  auto audiodPath = sysPath + "/orbis_audiod.elf";
+  auto gnmCompositorPath = sysPath + "/GnmCompositor.elf";
+  auto agcCompositorPath = sysPath + "/AgcCompositor.elf";
+
+  if (!co_await isFile(ext, miniSyscorePath)) {
+    co_return std::nullopt;
   }
 
-  if (!isFile(ext, uri + "/safemode.elf")) {
-    return {};
+  if (!co_await isFile(ext, safemodePath)) {
+    co_return std::nullopt;
   }
 
-  if (!isFile(ext, uri + "/system/sys/SceSysCore.elf")) {
-    return {};
+  if (!co_await isFile(ext, sysCorePath)) {
+    co_return std::nullopt;
   }
 
-  if (!isFile(ext, uri + "/system/sys/orbis_audiod.elf")) {
-    return {};
+  if (!co_await isFile(ext, audiodPath)) {
+    co_return std::nullopt;
   }
 
-  if (isFile(ext, uri + "/system/sys/GnmCompositor.elf")) {
-    return ExplorerItem{
+  if (co_await isFile(ext, gnmCompositorPath)) {
+    co_return ExplorerItem{
         .type = "firmware",
         .name = {LocalizedString{
             .text = "PS4 Firmware",
@@ -353,8 +390,8 @@ static std::optional<ExplorerItem> tryFetchFw(ExplorerExtension &ext,
     };
   }
 
-  if (isFile(ext, uri + "/system/sys/AgcCompositor.elf")) {
-    return ExplorerItem{
+  if (co_await isFile(ext, agcCompositorPath)) {
+    co_return ExplorerItem{
         .type = "firmware",
         .name = {LocalizedString{
             .text = "PS5 Firmware",
@@ -367,33 +404,34 @@ static std::optional<ExplorerItem> tryFetchFw(ExplorerExtension &ext,
     };
   }
 
-  return {};
+  co_return std::nullopt;
 }
 
-static std::optional<ExplorerItem> tryFetchGame(ExplorerExtension &ext,
-                                                const std::string &uri) {
+static Task<std::optional<ExplorerItem>>
+tryFetchGame(ExplorerExtension &ext, const std::string &uri) {
   auto sysPath = uri + "/sce_sys";
   auto paramSfoUri = sysPath + "/param.sfo";
+  auto ebootPath = uri + "/eboot.bin";
 
-  if (!isFile(ext, uri + "/eboot.bin")) {
-    return {};
+  if (!co_await isFile(ext, ebootPath)) {
+    co_return std::nullopt;
   }
 
-  if (!isFile(ext, paramSfoUri)) {
-    return {};
+  if (!co_await isFile(ext, paramSfoUri)) {
+    co_return std::nullopt;
   }
 
   auto data = sfo::load(toFilePath(paramSfoUri));
   if (data.errc != sfo::error::ok) {
     elog("%s: error %d", uri.c_str(), static_cast<int>(data.errc));
-    return {};
+    co_return std::nullopt;
   }
 
   auto category = sfo::get_string(data.sfo, "CATEGORY");
 
   if (category == "gdd" || category == "gdf" || category == "gdp" ||
       category == "gdg") {
-    return {};
+    co_return std::nullopt;
   }
 
   ExplorerItem info;
@@ -401,7 +439,7 @@ static std::optional<ExplorerItem> tryFetchGame(ExplorerExtension &ext,
   info.name = fetchLocalizedString(data.sfo, "TITLE");
 
   if (info.name.empty()) {
-    return {};
+    co_return std::nullopt;
   }
 
   info.titleId = sfo::get_string(data.sfo, "TITLE_ID");
@@ -411,10 +449,13 @@ static std::optional<ExplorerItem> tryFetchGame(ExplorerExtension &ext,
     info.version = sfo::get_string(data.sfo, "VERSION", "1.0");
   }
 
-  info.icon = fetchLocalizedImageFile(ext, sysPath, "icon0", ".png");
-  info.iconSound = fetchLocalizedResourceFile(ext, sysPath, "snd0", ".at9");
-  info.background = fetchLocalizedImageFile(ext, sysPath, "pic1", ".png");
-  info.overlayImage = fetchLocalizedImageFile(ext, sysPath, "pic2", ".png");
+  info.icon = co_await fetchLocalizedImageFile(ext, sysPath, "icon0", ".png");
+  info.iconSound =
+      co_await fetchLocalizedResourceFile(ext, sysPath, "snd0", ".at9");
+  info.background =
+      co_await fetchLocalizedImageFile(ext, sysPath, "pic1", ".png");
+  info.overlayImage =
+      co_await fetchLocalizedImageFile(ext, sysPath, "pic2", ".png");
 
   info.type = "game";
   info.launcher = LauncherInfo{
@@ -422,27 +463,27 @@ static std::optional<ExplorerItem> tryFetchGame(ExplorerExtension &ext,
                                 // "fself-ps5-prospero"
   };
   info.location = uri;
-  return std::move(info);
+  co_return info;
 }
 
-static std::optional<ExplorerItem> tryFetchPs3Game(ExplorerExtension &ext,
-                                                   const std::string &uri) {
+static Task<std::optional<ExplorerItem>>
+tryFetchPs3Game(ExplorerExtension &ext, const std::string &uri) {
   auto usrdirPath = uri + "/USRDIR";
   auto paramSfoUri = uri + "/PARAM.SFO";
   auto ebootPath = usrdirPath + "/EBOOT.BIN";
 
-  if (!isFile(ext, ebootPath)) {
-    return {};
+  if (!co_await isFile(ext, ebootPath)) {
+    co_return std::nullopt;
   }
 
-  if (!isFile(ext, paramSfoUri)) {
-    return {};
+  if (!co_await isFile(ext, paramSfoUri)) {
+    co_return std::nullopt;
   }
 
   auto data = sfo::load(toFilePath(paramSfoUri));
   if (data.errc != sfo::error::ok) {
     elog("%s: error %d", uri.c_str(), static_cast<int>(data.errc));
-    return {};
+    co_return std::nullopt;
   }
 
   auto titleId = sfo::get_string(data.sfo, "TITLE_ID");
@@ -450,7 +491,7 @@ static std::optional<ExplorerItem> tryFetchPs3Game(ExplorerExtension &ext,
   auto category = sfo::get_string(data.sfo, "CATEGORY");
 
   if (!bootable || titleId.empty()) {
-    return {};
+    co_return std::nullopt;
   }
 
   ExplorerItem info;
@@ -458,7 +499,7 @@ static std::optional<ExplorerItem> tryFetchPs3Game(ExplorerExtension &ext,
   info.name = fetchLocalizedString(data.sfo, "TITLE");
 
   if (info.name.empty()) {
-    return {};
+    co_return std::nullopt;
   }
 
   info.version = sfo::get_string(data.sfo, "APP_VER");
@@ -467,12 +508,16 @@ static std::optional<ExplorerItem> tryFetchPs3Game(ExplorerExtension &ext,
     info.version = sfo::get_string(data.sfo, "VERSION", "1.0");
   }
 
-  info.icon = fetchLocalizedImageFile(ext, uri, "ICON0", ".PNG");
-  info.iconSound = fetchLocalizedResourceFile(ext, uri, "SND0", ".AT3");
-  info.iconVideo = fetchLocalizedResourceFile(ext, uri, "ICON1", ".PAM");
-  info.overlayImageWide = fetchLocalizedImageFile(ext, uri, "PIC0", ".PNG");
-  info.background = fetchLocalizedImageFile(ext, uri, "PIC1", ".PNG");
-  info.overlayImage = fetchLocalizedImageFile(ext, uri, "PIC2", ".PNG");
+  info.icon = co_await fetchLocalizedImageFile(ext, uri, "ICON0", ".PNG");
+  info.iconSound =
+      co_await fetchLocalizedResourceFile(ext, uri, "SND0", ".AT3");
+  info.iconVideo =
+      co_await fetchLocalizedResourceFile(ext, uri, "ICON1", ".PAM");
+  info.overlayImageWide =
+      co_await fetchLocalizedImageFile(ext, uri, "PIC0", ".PNG");
+  info.background = co_await fetchLocalizedImageFile(ext, uri, "PIC1", ".PNG");
+  info.overlayImage =
+      co_await fetchLocalizedImageFile(ext, uri, "PIC2", ".PNG");
 
   info.type = "game";
   info.launcher = LauncherInfo{
@@ -480,7 +525,7 @@ static std::optional<ExplorerItem> tryFetchPs3Game(ExplorerExtension &ext,
   };
   info.location = uri;
 
-  return info;
+  co_return info;
 }
 
 ExtensionBuilder extension_main(int argc, const char *argv[]) {
@@ -0,0 +1,132 @@
+// Loopback echo benchmark of JSON-RPC protocol.
+//
+// Usage: ProtocolBenchmark [worker threads] [messages]
+//
+// rtt       - one request at a time, time per round trip
+// pipelined - requests sent in groups of 16, time per message
+// blocked   - time to answer burst of fast requests to different methods
+//             while all but one worker run slow handlers
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include "rpcsx/ui/LoopbackTransport.hpp"
+#include "rpcsx/ui/ProtocolFactory.hpp"
+#include "rpcsx/ui/extension.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace rpcsx::ui;
+using namespace std::chrono;
+
+static std::string makeFrame(std::size_t id, std::string_view method) {
+  auto body = R"({"jsonrpc":"2.0","id":)" + std::to_string(id) +
+              R"(,"method":")" + std::string(method) + R"("})";
+  return "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+int main(int argc, const char *argv[]) {
+  ProtocolOptions options;
+  int messageCount = 20000;
+
+  if (argc > 1) {
+    options.workerThreads = std::atoi(argv[1]);
+  }
+
+  if (argc > 2) {
+    messageCount = std::atoi(argv[2]);
+  }
+
+  auto [host, extension] = LoopbackTransport::createPair();
+  auto protocol = findProtocolFactory("json-rpc")(extension.get(), options);
+  ExtensionBase handlers;
+  protocol->setHandlers(&handlers);
+  Protocol::setDefault(protocol.get());
+
+  auto protocolPtr = protocol.get();
+  auto echo = [=](std::size_t id, json) { protocolPtr->sendResponse(id, 1); };
+  protocol->addMethodHandler("bench/echo", echo);
+
+  // methods without object run on strand of their name, distinct names
+  // spread requests over workers
+  constexpr int kGroupSize = 16;
+  for (int i = 0; i < kGroupSize; ++i) {
+    protocol->addMethodHandler("bench/echo" + std::to_string(i), echo);
+  }
+
+  auto slowCount = std::max<std::size_t>(options.workerThreads, 2) - 1;
+  for (std::size_t i = 0; i < slowCount; ++i) {
+    protocol->addMethodHandler(
+        "bench/slow" + std::to_string(i), [=](std::size_t id, json) {
+          std::this_thread::sleep_for(milliseconds(200));
+          protocolPtr->sendResponse(id, 0);
+        });
+  }
+
+  std::thread session([&] { protocol->processMessages(); });
+
+  FrameDecoder decoder;
+  auto send = [&](const std::string &frame) {
+    host->write(std::as_bytes(std::span(frame)));
+  };
+
+  auto single = makeFrame(1, "bench/echo");
+  auto start = steady_clock::now();
+  for (int i = 0; i < messageCount; ++i) {
+    send(single);
+    decoder.next(*host);
+  }
+
+  std::printf("rtt %.2f us\n",
+              duration<double, std::micro>(steady_clock::now() - start)
+                      .count() /
+                  messageCount);
+
+  std::string group;
+  for (int i = 0; i < kGroupSize; ++i) {
+    group += makeFrame(i + 1, "bench/echo");
+  }
+
+  start = steady_clock::now();
+  for (int i = 0; i < messageCount / kGroupSize; ++i) {
+    send(group);
+
+    for (int j = 0; j < kGroupSize; ++j) {
+      decoder.next(*host);
+    }
+  }
+
+  std::printf("pipelined %.2f us/msg\n",
+              duration<double, std::micro>(steady_clock::now() - start)
+                      .count() /
+                  (messageCount / kGroupSize * kGroupSize));
+
+  // slow handlers occupy all workers but one, fast requests must not queue
+  // behind them
+  for (std::size_t i = 0; i < slowCount; ++i) {
+    send(makeFrame(1000 + i, "bench/slow" + std::to_string(i)));
+  }
+
+  std::this_thread::sleep_for(milliseconds(20));
+
+  start = steady_clock::now();
+  for (int i = 0; i < kGroupSize; ++i) {
+    send(makeFrame(2000 + i, "bench/echo" + std::to_string(i)));
+  }
+
+  for (int i = 0; i < kGroupSize; ++i) {
+    decoder.next(*host);
+  }
+
+  std::printf("blocked %.2f us\n",
+              duration<double, std::micro>(steady_clock::now() - start)
+                  .count());
+
+  for (std::size_t i = 0; i < slowCount; ++i) {
+    decoder.next(*host);
+  }
+
+  host->shutdown();
+  session.join();
+  Protocol::setDefault(nullptr);
+}
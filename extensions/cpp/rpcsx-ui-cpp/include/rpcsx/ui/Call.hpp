@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <expected>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <rpcsx/ui/JsonReader.hpp>
+#include <rpcsx/ui/MessageArena.hpp>
+#include <rpcsx/ui/core/types.hpp>
+#include <stop_token>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rpcsx::ui {
+class Protocol;
+
+// Responses are decoded by walking their DOM with the same read_json() that
+// decodes params of inbound requests, types without it are converted from DOM
+template <typename T> std::optional<T> readResponse(const ArenaJson &response) {
+  T result;
+
+  if constexpr (requires(JsonReader &reader, T &value) {
+                  read_json(reader, value);
+                }) {
+    JsonReader reader(response);
+    if (!read_json(reader, result) || !reader.finish()) {
+      return std::nullopt;
+    }
+  } else {
+    try {
+      result = nlohmann::json(response).get<T>();
+    } catch (const nlohmann::json::exception &) {
+      return std::nullopt;
+    }
+  }
+
+  return result;
+}
+
+// Outbound call returned by generated API. Nothing is sent until it is
+// awaited or get() is called.
+//
+// Awaiting coroutine is resumed on protocol worker with stop token of the
+// request it was handling, so it does not occupy a thread while the call is
+// in flight. Non-reentrant handler resumes on its strand and keeps running
+// one at a time with other handlers of its object or method
+template <typename T, typename ProtocolT = Protocol> class [[nodiscard]] Call {
+public:
+  using Result = std::expected<T, ErrorInstance>;
+
+  Call(ProtocolT &protocol, std::string_view method, nlohmann::json params)
+      : mProtocol(&protocol), mMethod(method), mParams(std::move(params)) {}
+
+  static Result decode(const ArenaJson &response, bool isError) {
+    if (isError) {
+      return std::unexpected(readResponse<ErrorInstance>(response).value_or(
+          ErrorInstance{ErrorCode::InternalError, "malformed error"}));
+    }
+
+    if constexpr (std::is_void_v<T>) {
+      return {};
+    } else if (auto result = readResponse<T>(response)) {
+      return std::move(*result);
+    } else {
+      return std::unexpected(
+          ErrorInstance{ErrorCode::InternalError, "malformed response"});
+    }
+  }
+
+  // Blocks calling thread until response arrives
+  Result get() && {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::optional<Result> result;
+
+    mProtocol->call(mMethod, std::move(mParams),
+                    [&](const ArenaJson &response, bool isError) {
+                      std::lock_guard lock(mutex);
+                      result = decode(response, isError);
+                      cv.notify_one();
+                    });
+
+    std::unique_lock lock(mutex);
+    cv.wait(lock, [&] { return result.has_value(); });
+    return std::move(*result);
+  }
+
+  auto operator co_await() && {
+    struct Awaiter {
+      Call call;
+      std::optional<Result> result;
+      std::stop_token stopToken;
+      std::optional<std::uint64_t> strand;
+
+      bool await_ready() { return false; }
+
+      void await_suspend(std::coroutine_handle<> handle) {
+        auto protocol = call.mProtocol;
+        stopToken = ProtocolT::getRequestStopToken();
+        strand = ProtocolT::getRequestStrand();
+
+        // awaiter may be gone once handler posts resumption
+        protocol->call(call.mMethod, std::move(call.mParams),
+                       [this, protocol, handle](const ArenaJson &response,
+                                                bool isError) {
+                         result = decode(response, isError);
+                         protocol->post(strand, [this, handle] {
+                           typename ProtocolT::RequestScope scope(stopToken,
+                                                                  strand);
+                           handle.resume();
+                         });
+                       });
+      }
+
+      Result await_resume() { return std::move(*result); }
+    };
+
+    return Awaiter{std::move(*this)};
+  }
+
+private:
+  ProtocolT *mProtocol;
+  std::string_view mMethod;
+  nlohmann::json mParams;
+};
+
+// Calls sent together with Protocol::callBatch(), awaiting it yields results
+// in order calls were added. Results of type T are decoded as responses
+// arrive, untyped batch keeps them as json
+template <typename T = nlohmann::json, typename ProtocolT = Protocol>
+class [[nodiscard]] CallBatch {
+public:
+  using Result = typename Call<T, ProtocolT>::Result;
+
+  explicit CallBatch(ProtocolT &protocol) : mProtocol(&protocol) {}
+
+  void add(std::string_view method, nlohmann::json params) {
+    mCalls.push_back({method, std::move(params)});
+  }
+
+  std::size_t size() const { return mCalls.size(); }
+
+  auto operator co_await() && {
+    struct Awaiter {
+      CallBatch batch;
+      std::vector<Result> results;
+      std::atomic<std::size_t> pending;
+      std::stop_token stopToken;
+      std::optional<std::uint64_t> strand;
+
+      bool await_ready() { return batch.mCalls.empty(); }
+
+      void await_suspend(std::coroutine_handle<> handle) {
+        auto protocol = batch.mProtocol;
+        stopToken = ProtocolT::getRequestStopToken();
+        strand = ProtocolT::getRequestStrand();
+        results.resize(batch.mCalls.size());
+        pending = batch.mCalls.size();
+
+        std::vector<typename ProtocolT::BatchCall> calls;
+        calls.reserve(batch.mCalls.size());
+
+        for (std::size_t i = 0; i < batch.mCalls.size(); ++i) {
+          calls.push_back({
+              .method = batch.mCalls[i].method,
+              .params = std::move(batch.mCalls[i].params),
+              .responseHandler =
+                  [this, i, protocol, handle](const ArenaJson &response,
+                                              bool isError) {
+                    results[i] = Call<T, ProtocolT>::decode(response, isError);
+
+                    if (pending.fetch_sub(1, std::memory_order::acq_rel) ==
+                        1) {
+                      protocol->post(strand, [this, handle] {
+                        typename ProtocolT::RequestScope scope(stopToken,
+                                                               strand);
+                        handle.resume();
+                      });
+                    }
+                  },
+          });
+        }
+
+        protocol->callBatch(std::move(calls));
+      }
+
+      std::vector<Result> await_resume() { return std::move(results); }
+    };
+
+    return Awaiter{std::move(*this)};
+  }
+
+private:
+  struct Entry {
+    std::string_view method;
+    nlohmann::json params;
+  };
+
+  ProtocolT *mProtocol;
+  std::vector<Entry> mCalls;
+};
+} // namespace rpcsx::ui
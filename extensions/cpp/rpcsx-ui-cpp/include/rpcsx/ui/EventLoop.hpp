@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rpcsx::ui {
+// Single threaded reactor. Thread that calls run() owns watched descriptors
+// and timers, other threads hand work to it with post().
+//
+// On Linux it is built on epoll, wakeups use eventfd and timers use timerfd.
+// Other platforms get portable loop that supports post() and timers only.
+class EventLoop {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Callback = std::function<void()>;
+  using TimerId = std::uint64_t;
+
+  EventLoop();
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+  ~EventLoop();
+
+  // Runs callbacks until stop() is called
+  void run();
+  void stop();
+
+  // Thread safe
+  void post(Callback callback);
+  TimerId addTimer(Clock::time_point deadline, Callback callback);
+  void cancelTimer(TimerId id);
+
+  // Invokes onReadable from the loop thread while fd has data to read.
+  // Returns false if fd cannot be polled, caller should fall back to
+  // blocking reads from separate thread. Must be called from the loop
+  // thread or before run()
+  bool watch(int fd, Callback onReadable);
+  void unwatch(int fd);
+
+  bool isLoopThread() const {
+    return mLoopThread.load(std::memory_order::relaxed) ==
+           std::this_thread::get_id();
+  }
+
+private:
+  void wake();
+  void armTimer(Clock::time_point deadline);
+  void runPosted();
+  void runExpiredTimers();
+
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  std::vector<Callback> mPosted;
+  std::vector<Callback> mRunning;
+  std::vector<Callback> mDueTimers;
+  std::map<std::pair<Clock::time_point, TimerId>, Callback> mTimers;
+  std::unordered_map<TimerId, Clock::time_point> mTimerDeadlines;
+  TimerId mNextTimerId = 1;
+  bool mWakePending = false;
+  bool mStop = false;
+
+  std::unordered_map<int, Callback> mWatchers;
+  std::vector<int> mUnwatched;
+  std::atomic<std::thread::id> mLoopThread;
+
+  int mEpollFd = -1;
+  int mWakeFd = -1;
+  int mTimerFd = -1;
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rpcsx::ui {
+// Received bytes that frame bodies point into
+struct FrameBuffer {
+  std::vector<std::byte> bytes;
+
+  // number of leases, bytes may be moved or reused once it drops to zero
+  std::atomic<std::size_t> leases{0};
+};
+
+// Keeps bytes of frame valid while message is processed, possibly on another
+// thread. Decoder continues in another buffer instead of compacting one that
+// is leased
+class FrameLease {
+  std::shared_ptr<FrameBuffer> mBuffer;
+
+public:
+  FrameLease() = default;
+
+  explicit FrameLease(std::shared_ptr<FrameBuffer> buffer)
+      : mBuffer(std::move(buffer)) {
+    if (mBuffer != nullptr) {
+      mBuffer->leases.fetch_add(1, std::memory_order::relaxed);
+    }
+  }
+
+  FrameLease(const FrameLease &other) : FrameLease(other.mBuffer) {}
+  FrameLease(FrameLease &&other) noexcept = default;
+
+  FrameLease &operator=(FrameLease other) noexcept {
+    std::swap(mBuffer, other.mBuffer);
+    return *this;
+  }
+
+  ~FrameLease() {
+    if (mBuffer != nullptr) {
+      mBuffer->leases.fetch_sub(1, std::memory_order::release);
+    }
+  }
+
+  explicit operator bool() const { return mBuffer != nullptr; }
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace rpcsx::ui {
+// Serialization of JSON-RPC messages, marked with `Content-Type` header.
+// Frames without it are JSON
+enum class MessageFormat : std::uint8_t {
+  Json,
+  MsgPack,
+  Cbor,
+};
+
+std::string_view getMessageFormatName(MessageFormat format);
+std::optional<MessageFormat> parseMessageFormat(std::string_view name);
+
+std::string_view getMessageFormatContentType(MessageFormat format);
+std::optional<MessageFormat> parseMessageContentType(std::string_view type);
+
+// Frame body encodings, marked with `Content-Encoding` header. Codecs are
+// optional and compiled in when the library is found at configure time
+enum class FrameEncoding : std::uint8_t {
+  Identity,
+  Deflate,
+  Lz4,
+  Zstd,
+};
+
+// Encodings available in this build, fastest first
+std::span<const FrameEncoding> getSupportedFrameEncodings();
+
+std::string_view getFrameEncodingName(FrameEncoding encoding);
+std::optional<FrameEncoding> parseFrameEncoding(std::string_view name);
+
+// Append encoded or decoded bytes to output, return false on failure or if
+// encoding is not supported
+bool encodeFrame(FrameEncoding encoding, std::span<const std::byte> input,
+                 std::vector<std::byte> &output);
+bool decodeFrame(FrameEncoding encoding, std::span<const std::byte> input,
+                 std::vector<std::byte> &output);
+} // namespace rpcsx::ui
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "FrameCodec.hpp"
+#include "Transport.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace rpcsx::ui {
+struct FrameHeader {
+  std::size_t contentLength = 0;
+
+  // std::nullopt if body uses unknown encoding
+  std::optional<FrameEncoding> encoding = FrameEncoding::Identity;
+
+  // std::nullopt if body uses unknown content type
+  std::optional<MessageFormat> format = MessageFormat::Json;
+
+  // ids of descriptors sent alongside the frame, in order of arrival
+  std::vector<std::uint64_t> handleIds;
+};
+
+struct Frame {
+  FrameHeader header;
+  std::span<const std::byte> body;
+
+  // keeps body valid after the decoder moved on
+  FrameLease buffer;
+};
+
+// Splits a transport byte stream into `Content-Length` framed messages.
+//
+// Input is pulled from the transport in large chunks into a reusable buffer,
+// returned bodies point into that buffer. Body stays valid until the next call
+// of `next()` or `receive()`, or for as long as lease of the frame is held.
+//
+// Frame with invalid header is dropped together with the body it declares.
+// Without usable length decoder skips to the next `Content-Length` header.
+//
+// Event driven readers call `receive()` once the transport is readable and
+// then `decode()` until it returns std::nullopt.
+class FrameDecoder {
+  std::shared_ptr<FrameBuffer> mBuffer;
+
+  // buffers that were leased when decoder left them
+  std::vector<std::shared_ptr<FrameBuffer>> mSpareBuffers;
+
+  std::size_t mBegin = 0;
+  std::size_t mEnd = 0;
+  std::size_t mScanPos = 0;
+  std::size_t mRequired = 1;
+
+  // bytes of dropped frame that did not arrive yet
+  std::size_t mSkip = 0;
+  bool mResync = false;
+
+public:
+  static constexpr std::size_t kDefaultCapacity = 64 * 1024;
+  static constexpr std::size_t kMaxHeaderSize = 8 * 1024;
+
+  // frames with larger bodies are dropped as invalid
+  static constexpr std::size_t kMaxContentLength = 256 * 1024 * 1024;
+
+  explicit FrameDecoder(std::size_t capacity = kDefaultCapacity);
+
+  // Returns the next frame or std::nullopt on end of stream
+  std::optional<Frame> next(Transport &transport);
+
+  // Returns the next complete frame that is already buffered
+  std::optional<Frame> decode();
+
+  // Performs single read from transport, returns false on end of stream
+  bool receive(Transport &transport);
+
+  // True when no received bytes are waiting to be decoded
+  bool empty() const { return mBegin == mEnd; }
+
+  static std::optional<FrameHeader> parseHeader(std::string_view header);
+
+  // Value of the first `Content-Length` in header that fails to parse
+  static std::optional<std::size_t> findContentLength(std::string_view header);
+
+private:
+  std::optional<std::size_t> findHeaderEnd();
+  bool skipDropped();
+  void reserve(std::size_t required);
+  bool isLeased() const;
+};
+} // namespace rpcsx::ui
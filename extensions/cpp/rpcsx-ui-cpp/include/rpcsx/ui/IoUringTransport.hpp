@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Transport.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace rpcsx::ui {
+// Linux io_uring transport.
+//
+// Receives are kept in flight all the time: sockets use single multishot
+// receive into ring of provided buffers, other descriptors use READ_FIXED
+// into registered buffers. Sends are double buffered, write() copies data to
+// registered buffer and returns as soon as it is submitted.
+//
+// Transport cannot be polled, reads block in io_uring_enter.
+class IoUringTransport : public Transport {
+public:
+  static constexpr std::size_t kDefaultBufferSize = 64 * 1024;
+  static constexpr unsigned kRecvBufferCount = 16;
+  static constexpr unsigned kQueueDepth = 32;
+
+  IoUringTransport(const IoUringTransport &) = delete;
+  IoUringTransport &operator=(const IoUringTransport &) = delete;
+  ~IoUringTransport();
+
+  // Descriptors are not owned by transport and have to outlive it
+  static std::expected<std::unique_ptr<IoUringTransport>, std::error_code>
+  create(int inputFd, int outputFd,
+         std::size_t bufferSize = kDefaultBufferSize);
+
+  void write(std::span<const std::byte> bytes) override;
+  void writev(std::span<const std::span<const std::byte>> buffers) override;
+  void read(std::span<std::byte> &bytes) override;
+
+  bool isMultishot() const { return mMultishot; }
+
+private:
+  struct RecvChunk {
+    std::uint16_t bufferId;
+    std::uint32_t size;
+  };
+
+  struct SendBuffer {
+    std::byte *data = nullptr;
+    std::size_t size = 0;
+    std::size_t offset = 0;
+    bool inFlight = false;
+  };
+
+  IoUringTransport() = default;
+
+  io_uring_sqe *prepareSqe();
+  void commitSqe();
+  void flushSubmissions();
+  void submitRecv();
+  void submitSend(unsigned index);
+  void waitCompletions(std::unique_lock<std::mutex> &lock);
+  bool reapCompletions();
+  void handleCompletion(const io_uring_cqe &cqe);
+  void recycleRecvBuffer(std::uint16_t id);
+
+  int mRingFd = -1;
+  void *mRingMapping = nullptr;
+  std::size_t mRingMappingSize = 0;
+  io_uring_sqe *mSqes = nullptr;
+  std::size_t mSqesSize = 0;
+  unsigned *mSqHead = nullptr;
+  unsigned *mSqTail = nullptr;
+  unsigned *mSqArray = nullptr;
+  unsigned mSqMask = 0;
+  unsigned mSqEntries = 0;
+  unsigned mPendingSubmissions = 0;
+  unsigned *mCqHead = nullptr;
+  unsigned *mCqTail = nullptr;
+  io_uring_cqe *mCqes = nullptr;
+  unsigned mCqMask = 0;
+
+  void *mBuffers = nullptr;
+  std::size_t mBuffersSize = 0;
+  std::size_t mBufferSize = 0;
+  std::byte *mRecvBase = nullptr;
+  void *mBufRing = nullptr;
+  std::size_t mBufRingSize = 0;
+  std::uint16_t mBufRingTail = 0;
+  bool mMultishot = false;
+  bool mOutputIsSocket = false;
+
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  bool mWaiting = false;
+
+  std::deque<RecvChunk> mRecvChunks;
+  std::size_t mRecvOffset = 0;
+  std::vector<std::uint16_t> mFreeRecvBuffers;
+  std::uint64_t mRecvUserData = 0;
+  bool mRecvPending = false;
+  bool mEof = false;
+
+  SendBuffer mSend[2];
+  unsigned mCurrentSend = 0;
+  bool mSendFailed = false;
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "MessageArena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace rpcsx::ui {
+// Pull parser of JSON text. Generated read_json() overloads use it to decode
+// message params straight into request types without building DOM. Reader
+// of decoded message walks its DOM instead, so responses are not serialized
+// and parsed again.
+//
+// Read functions return false on failure, the first failure is kept in
+// error()
+class JsonReader {
+public:
+  enum class Error {
+    None,
+    // text is not valid JSON
+    Syntax,
+    // valid JSON that does not match type being read
+    Type,
+  };
+
+  enum class Kind {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object,
+    Invalid,
+  };
+
+  explicit JsonReader(std::string_view text) : mText(text) {}
+  explicit JsonReader(const ArenaJson &value) : mNext(&value), mDom(true) {}
+
+  // Kind of next value
+  Kind peek();
+
+  bool readNull();
+  bool readBool(bool &value);
+  bool readInteger(std::int64_t &value);
+  bool readString(std::string &value);
+
+  // Text of next value, it is validated but not decoded. Reader of DOM
+  // serializes the value, text is valid until the next call
+  bool readRaw(std::string_view &value);
+  bool readJson(nlohmann::json &value);
+  bool skip();
+
+  // Calls onMember(key) for each member, it has to read or skip the value.
+  // Key is valid until the value is read
+  template <typename F> bool readObject(F &&onMember) {
+    if (mDom) {
+      auto value = takeValue(Kind::Object);
+      if (value == nullptr) {
+        return false;
+      }
+
+      for (auto &[key, member] :
+           value->get_ref<const ArenaJson::object_t &>()) {
+        mNext = &member;
+        if (!onMember(std::string_view(key))) {
+          mNext = nullptr;
+          return false;
+        }
+      }
+
+      mNext = nullptr;
+      return mError == Error::None;
+    }
+
+    if (!enter('{')) {
+      return false;
+    }
+
+    std::string_view key;
+    for (bool first = true; nextMember(key, first);) {
+      if (!onMember(key)) {
+        leave();
+        return false;
+      }
+    }
+
+    leave();
+    return mError == Error::None;
+  }
+
+  // Calls onItem() for each item, it has to read or skip the item
+  template <typename F> bool readArray(F &&onItem) {
+    if (mDom) {
+      auto value = takeValue(Kind::Array);
+      if (value == nullptr) {
+        return false;
+      }
+
+      for (auto &item : value->get_ref<const ArenaJson::array_t &>()) {
+        mNext = &item;
+        if (!onItem()) {
+          mNext = nullptr;
+          return false;
+        }
+      }
+
+      mNext = nullptr;
+      return mError == Error::None;
+    }
+
+    if (!enter('[')) {
+      return false;
+    }
+
+    for (bool first = true; nextItem(first);) {
+      if (!onItem()) {
+        leave();
+        return false;
+      }
+    }
+
+    leave();
+    return mError == Error::None;
+  }
+
+  // Fails with Type error if required members were not found
+  bool require(bool found);
+
+  // Checks that nothing but whitespace is left
+  bool finish();
+
+  bool fail(Error error);
+  Error error() const { return mError; }
+
+private:
+  static constexpr std::size_t kMaxDepth = 512;
+
+  // Value of DOM that is read next, nullptr once it was read
+  const ArenaJson *takeValue(Kind kind);
+
+  bool enter(char open);
+  void leave() { mDepth--; }
+  bool nextMember(std::string_view &key, bool &first);
+  bool nextItem(bool &first);
+  bool readKey(std::string_view &key);
+  bool scanString(std::string *value);
+  bool scanNumber(std::string_view &value);
+  bool readLiteral(std::string_view literal);
+  void skipSpace();
+
+  std::string_view mText;
+  std::size_t mPos = 0;
+  std::size_t mDepth = 0;
+  Error mError = Error::None;
+  std::string mKey;
+
+  const ArenaJson *mNext = nullptr;
+  bool mDom = false;
+  std::string mRaw;
+};
+
+inline bool read_json(JsonReader &reader, std::string &value) {
+  return reader.readString(value);
+}
+
+inline bool read_json(JsonReader &reader, std::int64_t &value) {
+  return reader.readInteger(value);
+}
+
+inline bool read_json(JsonReader &reader, bool &value) {
+  return reader.readBool(value);
+}
+
+// Fields of JSON type are still parsed into DOM
+bool read_json(JsonReader &reader, nlohmann::json &value);
+bool read_json(JsonReader &reader, nlohmann::json::object_t &value);
+bool read_json(JsonReader &reader, nlohmann::json::array_t &value);
+
+template <typename T>
+  requires std::is_enum_v<T>
+bool read_json(JsonReader &reader, T &value) {
+  std::int64_t underlying;
+  if (!reader.readInteger(underlying)) {
+    return false;
+  }
+
+  value = static_cast<T>(underlying);
+  return true;
+}
+
+template <typename T>
+bool read_json(JsonReader &reader, std::optional<T> &value) {
+  if (reader.peek() == JsonReader::Kind::Null) {
+    value.reset();
+    return reader.readNull();
+  }
+
+  return read_json(reader, value.emplace());
+}
+
+template <typename T>
+bool read_json(JsonReader &reader, std::vector<T> &value) {
+  value.clear();
+  return reader.readArray(
+      [&] { return read_json(reader, value.emplace_back()); });
+}
+} // namespace rpcsx::ui
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace rpcsx::ui {
+// Member of object found by scanJsonObject(). Key is text between quotes,
+// value is raw JSON text
+struct JsonMember {
+  std::string_view key;
+  std::string_view value;
+
+  // key contains escape sequences and is not compared as is
+  bool escapedKey = false;
+};
+
+// Splits JSON object into members without building DOM. Values are skipped
+// by tracking strings and nesting, scalars and nested content are not
+// validated, parser that gets the value later reports them. Returns false if
+// text is not a single object
+bool scanJsonObject(std::string_view text, std::vector<JsonMember> &members);
+
+// Contents of string value without escape sequences
+std::optional<std::string_view> getJsonString(std::string_view value);
+
+std::optional<std::uint64_t> getJsonUnsigned(std::string_view value);
+bool isJsonNull(std::string_view value);
+
+// Length of UTF-8 sequence text starts with, 0 if it is invalid
+std::size_t getUtf8Length(std::string_view text);
+} // namespace rpcsx::ui
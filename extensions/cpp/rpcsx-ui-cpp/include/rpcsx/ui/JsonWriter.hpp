@@ -0,0 +1,96 @@
+#pragma once
+
+#include "MessageArena.hpp"
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace rpcsx::ui {
+// Append compact JSON text of value to output, invalid UTF-8 sequences are
+// replaced with U+FFFD. Unlike dump() it does not allocate in steady state
+void appendJsonText(std::string &output, const nlohmann::json &value);
+void appendJsonText(std::string &output, const ArenaJson &value);
+
+// Appends compact JSON to buffer. Generated write_json() overloads use it to
+// serialize types straight into frame without building DOM. Output matches
+// dump() of DOM, except member order follows declaration order
+class JsonWriter {
+public:
+  explicit JsonWriter(std::string &buffer) : mBuffer(buffer) {}
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  // Name of the next member value
+  void key(std::string_view name);
+
+  void writeNull();
+  void writeBool(bool value);
+  void writeInteger(std::int64_t value);
+  void writeUnsigned(std::uint64_t value);
+
+  // Invalid UTF-8 sequences are replaced with U+FFFD
+  void writeString(std::string_view value);
+  void writeJson(const nlohmann::json &value);
+
+private:
+  void separate();
+  void dump(const nlohmann::json &value);
+  void appendString(std::string_view value);
+  bool appendEscaped(std::string_view value);
+
+  std::string &mBuffer;
+  bool mNeedComma = false;
+};
+
+inline void write_json(JsonWriter &writer, const std::string &value) {
+  writer.writeString(value);
+}
+
+inline void write_json(JsonWriter &writer, std::int64_t value) {
+  writer.writeInteger(value);
+}
+
+inline void write_json(JsonWriter &writer, bool value) {
+  writer.writeBool(value);
+}
+
+inline void write_json(JsonWriter &writer, const nlohmann::json &value) {
+  writer.writeJson(value);
+}
+
+void write_json(JsonWriter &writer, const nlohmann::json::object_t &value);
+void write_json(JsonWriter &writer, const nlohmann::json::array_t &value);
+
+template <typename T>
+  requires std::is_enum_v<T>
+void write_json(JsonWriter &writer, T value) {
+  writer.writeInteger(static_cast<std::int64_t>(value));
+}
+
+template <typename T>
+void write_json(JsonWriter &writer, const std::optional<T> &value) {
+  if (value) {
+    write_json(writer, *value);
+  } else {
+    writer.writeNull();
+  }
+}
+
+template <typename T>
+void write_json(JsonWriter &writer, const std::vector<T> &value) {
+  writer.beginArray();
+
+  for (auto &item : value) {
+    write_json(writer, item);
+  }
+
+  writer.endArray();
+}
+} // namespace rpcsx::ui
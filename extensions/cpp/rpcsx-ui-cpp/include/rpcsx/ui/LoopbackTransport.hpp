@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SpscRing.hpp"
+#include "Transport.hpp"
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace rpcsx::ui {
+// In-process transport pair over two SPSC rings in heap memory. Lets host
+// side driver and protocol run in one process, e.g. for tests and
+// benchmarks, without kernel pipes in the way.
+//
+// Each end has single writer and single reader thread. Destroying an end or
+// calling shutdown() closes both directions, peer reads return end of stream
+// once remaining data is drained.
+class LoopbackTransport : public Transport {
+public:
+  static constexpr std::size_t kDefaultRingSize = 1024 * 1024;
+
+  LoopbackTransport(const LoopbackTransport &) = delete;
+  LoopbackTransport &operator=(const LoopbackTransport &) = delete;
+  ~LoopbackTransport();
+
+  // Ring size must be power of two
+  static std::pair<std::unique_ptr<LoopbackTransport>,
+                   std::unique_ptr<LoopbackTransport>>
+  createPair(std::size_t ringSize = kDefaultRingSize);
+
+  void write(std::span<const std::byte> bytes) override;
+  void read(std::span<std::byte> &bytes) override;
+
+  void shutdown();
+
+private:
+  struct Channel;
+
+  LoopbackTransport(std::shared_ptr<Channel> channel, SpscRing input,
+                    SpscRing output)
+      : mChannel(std::move(channel)), mInput(input), mOutput(output) {}
+
+  std::shared_ptr<Channel> mChannel;
+  SpscRing mInput;
+  SpscRing mOutput;
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rpcsx::ui {
+// Monotonic memory for JSON values that live while one inbound message is
+// handled. reset() frees everything at once, memory is kept and merged into
+// single block, so the next message of similar size does not allocate.
+//
+// Only inbound DOM is built here. It is reset once the message is routed,
+// handlers queued for workers get params as text and never see it. Outbound
+// messages are built as heap json, they are out of scope of the arena
+class MessageArena {
+public:
+  MessageArena() = default;
+  MessageArena(const MessageArena &) = delete;
+  MessageArena &operator=(const MessageArena &) = delete;
+
+  void *allocate(std::size_t size, std::size_t alignment);
+  bool owns(const void *pointer) const;
+  void reset();
+
+  std::size_t getCapacity() const;
+
+  // ArenaAllocator reports values it creates and destroys in arena. Debug
+  // builds count them, reset() asserts that none of them outlived the
+  // message, for example by being moved into queued work
+  void retain() noexcept {
+#ifndef NDEBUG
+    mLiveAllocations.fetch_add(1, std::memory_order::relaxed);
+#endif
+  }
+
+  void release() noexcept {
+#ifndef NDEBUG
+    mLiveAllocations.fetch_sub(1, std::memory_order::relaxed);
+#endif
+  }
+
+  // Makes arena current for ArenaAllocator on calling thread
+  class Scope {
+    MessageArena *mPrevious;
+
+  public:
+    explicit Scope(MessageArena &arena);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+  };
+
+  static MessageArena *getCurrent();
+
+private:
+  static constexpr std::size_t kMinBlockSize = 4 * 1024;
+
+  // larger blocks are freed on reset, huge message does not pin its memory
+  static constexpr std::size_t kMaxRetainedSize = 1024 * 1024;
+
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t size;
+  };
+
+  std::vector<Block> mBlocks;
+  std::size_t mOffset = 0;
+
+#ifndef NDEBUG
+  std::atomic<std::size_t> mLiveAllocations{0};
+#endif
+};
+
+// Allocates from current arena of calling thread, from heap if there is
+// none. Every allocation records arena it came from, so values are released
+// right on any thread and with any arena current. Memory of arena is
+// released by reset(), values created while it was current must not be used
+// after it
+template <typename T> struct ArenaAllocator {
+  using value_type = T;
+
+  ArenaAllocator() = default;
+  template <typename U> ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+  T *allocate(std::size_t count) {
+    if (count >
+        (std::numeric_limits<std::size_t>::max() - kHeaderSize) / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+
+    auto size = count * sizeof(T) + kHeaderSize;
+    auto arena = MessageArena::getCurrent();
+    std::byte *memory;
+
+    if (arena != nullptr) {
+      memory = static_cast<std::byte *>(arena->allocate(size, alignof(T)));
+      arena->retain();
+    } else {
+      memory = static_cast<std::byte *>(
+          ::operator new(size, std::align_val_t{alignof(T)}));
+    }
+
+    std::memcpy(memory + kHeaderSize - sizeof(arena), &arena, sizeof(arena));
+    return reinterpret_cast<T *>(memory + kHeaderSize);
+  }
+
+  void deallocate(T *pointer, std::size_t count) noexcept {
+    auto memory = reinterpret_cast<std::byte *>(pointer) - kHeaderSize;
+    MessageArena *arena;
+    std::memcpy(&arena, memory + kHeaderSize - sizeof(arena), sizeof(arena));
+
+    if (arena != nullptr) {
+      arena->release();
+    } else {
+      ::operator delete(memory, count * sizeof(T) + kHeaderSize,
+                        std::align_val_t{alignof(T)});
+    }
+  }
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &) const {
+    return true;
+  }
+
+private:
+  // arena or nullptr for heap is stored right before value, header keeps
+  // value aligned
+  static constexpr std::size_t kHeaderSize =
+      std::max(alignof(T), sizeof(MessageArena *));
+};
+
+// DOM of inbound message that is dropped once its handlers return. Nodes
+// come from arena, strings keep std::string since binary readers of
+// nlohmann::json require it, only long ones reach heap
+using ArenaJson =
+    nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                         std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+// JSON text of value in buffer of calling thread, valid until the next call
+std::string_view toJsonText(const ArenaJson &value);
+} // namespace rpcsx::ui
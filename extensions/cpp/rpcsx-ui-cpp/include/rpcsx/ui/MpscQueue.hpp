@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+namespace rpcsx::ui {
+struct MpscNode {
+  MpscNode *next = nullptr;
+};
+
+// Intrusive multiple producer single consumer queue. Producers link nodes
+// with single CAS and never wait for the consumer, the consumer detaches
+// everything pushed so far at once.
+class MpscQueue {
+public:
+  // Returns true if the queue was empty, producer that observes it is
+  // responsible for waking the consumer
+  bool push(MpscNode *node) {
+    auto head = mHead.load(std::memory_order::relaxed);
+
+    do {
+      node->next = head;
+    } while (!mHead.compare_exchange_weak(head, node,
+                                          std::memory_order::seq_cst,
+                                          std::memory_order::relaxed));
+
+    return head == nullptr;
+  }
+
+  // Consumer only. Returns detached nodes linked in push order
+  MpscNode *popAll() {
+    auto node = mHead.exchange(nullptr, std::memory_order::seq_cst);
+    MpscNode *result = nullptr;
+
+    while (node != nullptr) {
+      auto next = node->next;
+      node->next = result;
+      result = node;
+      node = next;
+    }
+
+    return result;
+  }
+
+  bool empty() const {
+    return mHead.load(std::memory_order::seq_cst) == nullptr;
+  }
+
+private:
+  std::atomic<MpscNode *> mHead{nullptr};
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "EventLoop.hpp"
+#include "ProtocolStats.hpp"
+#include "Transport.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace rpcsx::ui {
+// Coalesces frames produced by one processing burst into single transport
+// write. Batch is written when it grows above size threshold, when protocol
+// reaches idle point or when oldest frame waited longer than maxDelay.
+//
+// Frames can be pushed from any thread, transport is written only from event
+// loop thread. Remaining frames are written by destructor.
+class OutboundBatcher {
+public:
+  enum class FlushReason { Size, Idle, Deadline, Call };
+
+  struct Config {
+    std::size_t sizeThreshold = 64 * 1024;
+    std::chrono::microseconds maxDelay{200};
+  };
+
+  OutboundBatcher(Transport *transport, EventLoop &loop, Config config);
+  OutboundBatcher(const OutboundBatcher &) = delete;
+  OutboundBatcher &operator=(const OutboundBatcher &) = delete;
+  ~OutboundBatcher();
+
+  // Handles are owned by batcher and sent with the batch that contains frame
+  void push(std::span<const std::byte> frame,
+            std::span<const int> handles = {});
+
+  // Schedules write of batched frames. Called from the loop thread it writes
+  // immediately
+  void flush(FlushReason reason);
+
+  void collectStats(ProtocolStats &stats);
+
+private:
+  void write();
+
+  Transport *mTransport;
+  EventLoop &mLoop;
+  Config mConfig;
+
+  std::mutex mBatchMutex;
+  std::vector<std::byte> mBatch;
+  std::vector<int> mBatchHandles;
+  std::size_t mBatchFrames = 0;
+  std::optional<FlushReason> mPendingFlush;
+  EventLoop::TimerId mDeadlineTimer = 0;
+
+  std::mutex mWriteMutex;
+  std::vector<std::byte> mWriteBuffer;
+  std::vector<int> mWriteHandles;
+  ProtocolStats mStats;
+};
+} // namespace rpcsx::ui
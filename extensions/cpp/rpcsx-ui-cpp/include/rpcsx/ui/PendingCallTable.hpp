@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MessageArena.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace rpcsx::ui {
+// Response handlers of outbound calls.
+//
+// Call id encodes slot and its generation, so completion finds the slot
+// directly and ids of completed calls never match a reused slot. Slots are
+// split into shards picked by the calling thread, threads that issue calls
+// concurrently rarely share a lock. Ids stay below 2^53 to be exact in
+// JavaScript numbers.
+class PendingCallTable {
+public:
+  using Handler = std::function<void(const ArenaJson &, bool isError)>;
+
+  static constexpr unsigned kShardBits = 4;
+  static constexpr unsigned kIndexBits = 20;
+  static constexpr unsigned kGenerationBits = 53 - kShardBits - kIndexBits;
+
+  // Returns std::nullopt and leaves handler intact if calling thread's shard
+  // has no free slots
+  std::optional<std::uint64_t> add(Handler &&handler);
+
+  // Returns empty handler if id is unknown or was already taken
+  Handler take(std::uint64_t id);
+
+private:
+  struct Slot {
+    Handler handler;
+    std::uint32_t generation = 1;
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+  };
+
+  std::array<Shard, 1u << kShardBits> mShards;
+};
+} // namespace rpcsx::ui
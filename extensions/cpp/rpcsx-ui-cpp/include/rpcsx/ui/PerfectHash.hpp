@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace rpcsx::ui {
+// Seeded FNV-1a
+constexpr std::uint32_t hashName(std::string_view name, std::uint32_t seed) {
+  std::uint32_t hash = 2166136261u ^ seed;
+
+  for (char c : name) {
+    hash ^= static_cast<std::uint8_t>(c);
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+// Power of two with at least two slots per name. Chance of a seed to have no
+// collisions drops with square of count, large tables are sparser to keep
+// the search short
+constexpr std::size_t getPerfectHashSize(std::size_t count) {
+  return std::bit_ceil(
+      std::max<std::size_t>({1, count * 2, count * count / 16}));
+}
+
+// Seed that puts every name to its own slot of table of given size
+constexpr std::optional<std::uint32_t>
+findPerfectHashSeed(std::span<const std::string_view> names,
+                    std::size_t size, std::uint32_t maxSeed = 1u << 16) {
+  std::vector<bool> used(size);
+
+  for (std::uint32_t seed = 0; seed < maxSeed; ++seed) {
+    bool collides = false;
+    used.assign(size, false);
+
+    for (auto name : names) {
+      auto slot = hashName(name, seed) & (size - 1);
+
+      if (used[slot]) {
+        collides = true;
+        break;
+      }
+
+      used[slot] = true;
+    }
+
+    if (!collides) {
+      return seed;
+    }
+  }
+
+  return std::nullopt;
+}
+
+// Compile time name to index map, lookup is one hash and one compare
+template <std::size_t N> struct PerfectHashTable {
+  static constexpr std::size_t kSize = getPerfectHashSize(N);
+
+  std::array<std::string_view, N> names{};
+  std::array<int, kSize> slots{};
+  // names by slot, empty names are unused slots
+  std::array<std::string_view, kSize> slotNames{};
+  std::uint32_t seed = 0;
+
+  static constexpr std::size_t size() { return N; }
+
+  // Returns -1 if name is not in the table
+  constexpr int find(std::string_view name) const {
+    int index = slots[hashName(name, seed) & (kSize - 1)];
+    return index >= 0 && names[index] == name ? index : -1;
+  }
+};
+
+template <std::size_t N>
+consteval PerfectHashTable<N>
+makePerfectHashTable(const std::string_view (&names)[N]) {
+  PerfectHashTable<N> result;
+
+  auto seed = findPerfectHashSeed(names, result.kSize);
+  if (!seed) {
+    throw "no perfect hash seed for names";
+  }
+
+  result.seed = *seed;
+  result.slots.fill(-1);
+
+  for (std::size_t i = 0; i < N; ++i) {
+    result.names[i] = names[i];
+    auto slot = hashName(names[i], *seed) & (result.kSize - 1);
+    result.slots[slot] = int(i);
+    result.slotNames[slot] = names[i];
+  }
+
+  return result;
+}
+} // namespace rpcsx::ui
@@ -1,25 +1,69 @@
 #pragma once
 
+#include "MessageArena.hpp"
+#include "ProtocolStats.hpp"
+#include "RequestParams.hpp"
+#include "ResponseResult.hpp"
+#include "Task.hpp"
 #include "Transport.hpp"
+#include "UniqueFunction.hpp"
+#include "file.hpp"
 #include "json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <expected>
 #include <functional>
+#include <optional>
 #include <rpcsx-ui.hpp>
+#include <span>
+#include <stop_token>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace rpcsx::ui {
 struct ExtensionBase;
 
+// Handlers of an object run one at a time in order of arrival. Reentrant
+// handlers opt out of it and may run in parallel with any other handler of
+// the same object
 struct InterfaceBuilder {
   virtual ~InterfaceBuilder() = default;
+
+  // Generated builders pass slotNames of their PerfectHashTable before adding
+  // handlers, so that the table does not need to be built at runtime
+  virtual void setMethodTable(std::uint32_t seed,
+                              std::span<const std::string_view> slots) {}
+  virtual void setNotificationTable(std::uint32_t seed,
+                                    std::span<const std::string_view> slots) {}
+
+  // Handlers decode params into their request type, RequestParamsError
+  // thrown by decoding is reported to caller
   virtual void addMethodHandler(std::string_view method,
-                                json (*handler)(void *, const json &)) = 0;
+                                ResponseResult (*handler)(
+                                    void *, const RequestParams &),
+                                bool reentrant = false) = 0;
+
+  // Response is sent when task completes, handler does not hold the object
+  // between suspensions
+  virtual void addAsyncMethodHandler(std::string_view method,
+                                     Task<ResponseResult> (*handler)(
+                                         void *, const RequestParams &),
+                                     bool reentrant = false) = 0;
   virtual void addNotificationHandler(std::string_view notification,
                                       void (*handler)(void *,
-                                                      const json &)) = 0;
+                                                      const RequestParams &),
+                                      bool reentrant = false) = 0;
 };
 
 using ProtocolObject = std::unique_ptr<void, void (*)(void *)>;
 
+// Response of outbound call is decoded into arena of the inbound message and
+// is valid until handler returns. Handlers that keep it copy it, copies come
+// from heap
+using ResponseHandler =
+    std::function<void(const ArenaJson &response, bool isError)>;
+
 class Protocol {
   Transport *mTransport = nullptr;
   ExtensionBase *mHandlers = nullptr;
@@ -39,38 +83,149 @@ public:
   virtual ~Protocol() = default;
 
   virtual void call(std::string_view method, json params,
-                    std::function<void(json, bool isError)> responseHandler) = 0;
+                    ResponseHandler responseHandler) = 0;
+
+  // Handler gets TimedOut error if response does not arrive by deadline
+  virtual void
+  callUntil(std::string_view method, json params,
+            ResponseHandler responseHandler,
+            std::chrono::steady_clock::time_point deadline) {
+    call(method, std::move(params), std::move(responseHandler));
+  }
+
+  struct BatchCall {
+    std::string_view method;
+    json params;
+    ResponseHandler responseHandler;
+  };
+
+  // Sends calls together, JSON-RPC sends them in one batch frame. Each
+  // response is passed to its handler as it is received
+  virtual void callBatch(std::vector<BatchCall> calls) {
+    for (auto &batchCall : calls) {
+      call(batchCall.method, std::move(batchCall.params),
+           std::move(batchCall.responseHandler));
+    }
+  }
+
   virtual void notify(std::string_view method, json params) = 0;
   virtual void onEvent(std::string_view method,
                        std::function<void(json)> eventHandler) = 0;
   virtual int processMessages() = 0;
   virtual void sendLogMessage(LogLevel level, std::string_view message) = 0;
 
+  // Runs task on protocol worker, coroutines resume here after awaited call
+  virtual void post(UniqueFunction<void()> task) { task(); }
+
+  // Runs task after tasks posted to the same strand, so coroutine of
+  // non-reentrant handler resumes in order with other handlers of its object
+  // or method. Tasks without strand may run on any worker
+  virtual void post(std::optional<std::uint64_t> strand,
+                    UniqueFunction<void()> task) {
+    post(std::move(task));
+  }
+  virtual ProtocolStats getStats() { return {}; }
+
+  // Bulk payloads. shareFile() returns reference to put into message instead
+  // of file contents, the file is sent with the first message that contains
+  // it. std::nullopt if transport cannot pass descriptors
+  virtual std::optional<json> shareFile(File file) { return std::nullopt; }
+
+  // Claims file referenced by message that is being handled, references
+  // that are not claimed by handler are closed
+  virtual std::expected<File, std::error_code> takeFile(const json &ref) {
+    return std::unexpected(
+        std::make_error_code(std::errc::function_not_supported));
+  }
+
   virtual void sendResponse(std::size_t id, json result) = 0;
   virtual void sendErrorResponse(std::size_t id, ErrorInstance error) = 0;
   virtual void sendErrorResponse(ErrorInstance error) = 0;
 
-  virtual void addMethodHandler(
-      std::string_view method,
-      std::function<void(std::size_t id, json body)> handler) = 0;
+  // Handlers of the same top level method or notification run one at a time
+  // in order of arrival, reentrant ones may run in parallel
+  virtual void
+  addMethodHandler(std::string_view method,
+                   std::function<void(std::size_t id, json body)> handler,
+                   bool reentrant = false) = 0;
 
   virtual void
   addNotificationHandler(std::string_view notification,
-                         std::function<void(json body)> handler) = 0;
+                         std::function<void(json body)> handler,
+                         bool reentrant = false) = 0;
 
   virtual void addObject(std::string_view interfaceName,
                          void (*builder)(InterfaceBuilder &builder),
                          unsigned id, ProtocolObject object) = 0;
 
-  static Protocol *getDefault() { return *getImpl(); }
+  // Protocol of session that calling thread serves, threads outside of
+  // sessions get process wide default. Logging goes to it
+  static Protocol *getDefault() {
+    auto protocol = *getThreadDefaultImpl();
+    return protocol != nullptr ? protocol : *getImpl();
+  }
+
   static void setDefault(Protocol *protocol) { *getImpl() = protocol; }
 
+  // Sessions set it on threads that run their loop and handlers, so
+  // extension serving several clients answers each on its own connection
+  static void setThreadDefault(Protocol *protocol) {
+    *getThreadDefaultImpl() = protocol;
+  }
+
+  // Stop is requested when client cancels request that calling thread
+  // handles. Long running handlers may poll it and return early
+  static std::stop_token getRequestStopToken() {
+    return *getRequestStopTokenImpl();
+  }
+
+  // Strand handler that calling thread runs was posted to, std::nullopt for
+  // reentrant handlers and threads outside of handlers
+  static std::optional<std::uint64_t> getRequestStrand() {
+    return *getRequestStrandImpl();
+  }
+
+  // Sets token getRequestStopToken() and strand getRequestStrand() return
+  // while in scope
+  class RequestScope {
+    std::stop_token mPreviousToken;
+    std::optional<std::uint64_t> mPreviousStrand;
+
+  public:
+    RequestScope(std::stop_token token,
+                 std::optional<std::uint64_t> strand = std::nullopt)
+        : mPreviousToken(std::exchange(*getRequestStopTokenImpl(), token)),
+          mPreviousStrand(std::exchange(*getRequestStrandImpl(), strand)) {}
+    RequestScope(const RequestScope &) = delete;
+    RequestScope &operator=(const RequestScope &) = delete;
+    ~RequestScope() {
+      *getRequestStopTokenImpl() = std::move(mPreviousToken);
+      *getRequestStrandImpl() = mPreviousStrand;
+    }
+  };
+
   Transport *getTransport() { return mTransport; }
 
+protected:
+  static std::stop_token *getRequestStopTokenImpl() {
+    thread_local std::stop_token token;
+    return &token;
+  }
+
+  static std::optional<std::uint64_t> *getRequestStrandImpl() {
+    thread_local std::optional<std::uint64_t> strand;
+    return &strand;
+  }
+
 private:
   static Protocol **getImpl() {
     static Protocol *protocol = nullptr;
     return &protocol;
   }
+
+  static Protocol **getThreadDefaultImpl() {
+    thread_local Protocol *protocol = nullptr;
+    return &protocol;
+  }
 };
 } // namespace rpcsx::ui
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "OutboundBatcher.hpp"
+#include "Protocol.hpp"
+#include "Transport.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace rpcsx::ui {
+struct ProtocolOptions {
+  static constexpr std::size_t kDefaultCompressionThreshold = 8 * 1024;
+  static constexpr std::size_t kDefaultWorkerThreads = 4;
+  static constexpr std::chrono::milliseconds kDefaultCallTimeout{30'000};
+
+  OutboundBatcher::Config outbound;
+  std::size_t compressionThreshold = kDefaultCompressionThreshold;
+
+  // threads that run method and notification handlers
+  std::size_t workerThreads = kDefaultWorkerThreads;
+
+  // outbound calls that get no response in time complete with TimedOut
+  // error, zero disables the limit
+  std::chrono::milliseconds callTimeout = kDefaultCallTimeout;
+};
+
+using ProtocolFactory =
+    std::unique_ptr<Protocol> (*)(Transport *, const ProtocolOptions &);
+
+// Returns nullptr if protocol id is unknown
+ProtocolFactory findProtocolFactory(std::string_view protocolId);
+} // namespace rpcsx::ui
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace rpcsx::ui {
+struct ProtocolStats {
+  std::uint64_t sentFrames = 0;
+  std::uint64_t sentBytes = 0;
+  std::uint64_t sentBatches = 0;
+  std::uint64_t flushesBySize = 0;
+  std::uint64_t flushesByIdle = 0;
+  std::uint64_t flushesByDeadline = 0;
+  std::uint64_t flushesByCall = 0;
+
+  // frames sent with Content-Encoding, sizes of bodies before and after
+  std::uint64_t encodedFrames = 0;
+  std::uint64_t encodedInputBytes = 0;
+  std::uint64_t encodedOutputBytes = 0;
+
+  // heap allocations made to queue inbound messages for workers, stops
+  // growing once enough messages were in flight at the same time
+  std::uint64_t dispatchAllocations = 0;
+
+  // batchSizeHistogram[i] counts batches of [2^i, 2^(i+1)) frames
+  std::array<std::uint64_t, 16> batchSizeHistogram{};
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "JsonReader.hpp"
+#include <cstring>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+namespace rpcsx::ui {
+// Thrown by RequestParams::get() when params cannot be decoded
+class RequestParamsError : public std::runtime_error {
+  JsonReader::Error mError;
+
+public:
+  explicit RequestParamsError(JsonReader::Error error)
+      : std::runtime_error(error == JsonReader::Error::Syntax
+                               ? "malformed params"
+                               : "invalid params"),
+        mError(error) {}
+
+  // Params are not valid JSON, rather than valid but of wrong type
+  bool isSyntaxError() const { return mError == JsonReader::Error::Syntax; }
+};
+
+// Params of inbound request. JSON text of the message is decoded straight
+// into request type, params of binary frames come as DOM. Text stays in the
+// received frame, which is leased until params are released
+class RequestParams {
+  struct Text {
+    std::string_view text;
+    FrameLease buffer;
+  };
+
+  std::variant<nlohmann::json, Text> mValue;
+
+public:
+  RequestParams() = default;
+  RequestParams(nlohmann::json value) : mValue(std::move(value)) {}
+
+  // Empty text means params were omitted
+  static RequestParams fromText(std::string_view text, FrameLease buffer) {
+    RequestParams result;
+    if (!text.empty()) {
+      result.mValue = Text{text, std::move(buffer)};
+    }
+    return result;
+  }
+
+  // Text that is not part of received frame is copied
+  static RequestParams fromText(std::string_view text) {
+    auto buffer = std::make_shared<FrameBuffer>();
+    buffer->bytes.resize(text.size());
+    std::memcpy(buffer->bytes.data(), text.data(), text.size());
+
+    std::string_view copy(reinterpret_cast<const char *>(buffer->bytes.data()),
+                          text.size());
+    return fromText(copy, FrameLease(std::move(buffer)));
+  }
+
+  std::optional<std::string_view> getText() const {
+    if (auto text = std::get_if<Text>(&mValue)) {
+      return text->text;
+    }
+
+    return std::nullopt;
+  }
+
+  // Params that are part of text of these params, they share its frame
+  RequestParams getPart(std::string_view part) const {
+    if (auto text = std::get_if<Text>(&mValue)) {
+      return fromText(part, text->buffer);
+    }
+
+    return fromText(part);
+  }
+
+  bool isNull() const {
+    if (auto text = getText()) {
+      return JsonReader(*text).peek() == JsonReader::Kind::Null;
+    }
+
+    return std::get<nlohmann::json>(mValue).is_null();
+  }
+
+  // Throws RequestParamsError
+  template <typename T> T get() const {
+    if (auto text = getText()) {
+      T result;
+      JsonReader reader(*text);
+
+      if (!read_json(reader, result) || !reader.finish()) {
+        throw RequestParamsError(reader.error());
+      }
+
+      return result;
+    }
+
+    try {
+      return std::get<nlohmann::json>(mValue).get<T>();
+    } catch (const nlohmann::json::exception &) {
+      throw RequestParamsError(JsonReader::Error::Type);
+    }
+  }
+
+  // Parses text, std::nullopt if it is malformed
+  std::optional<nlohmann::json> toJson() && {
+    auto text = getText();
+    if (!text) {
+      return std::move(std::get<nlohmann::json>(mValue));
+    }
+
+    auto result = nlohmann::json::parse(*text, nullptr, false);
+    if (result.is_discarded()) {
+      return std::nullopt;
+    }
+
+    return result;
+  }
+};
+} // namespace rpcsx::ui
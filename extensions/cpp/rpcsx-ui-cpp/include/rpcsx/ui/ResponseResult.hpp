@@ -0,0 +1,67 @@
+#pragma once
+
+#include "JsonWriter.hpp"
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace rpcsx::ui {
+// Result returned by handler. Values of generated types are serialized when
+// response is sent: JSON frames are written straight from the value, other
+// formats get DOM
+class ResponseResult {
+  struct Value {
+    virtual ~Value() = default;
+    virtual void write(JsonWriter &writer) const = 0;
+    virtual nlohmann::json toJson() const = 0;
+  };
+
+  template <typename T> struct TypedValue final : Value {
+    T value;
+
+    TypedValue(T value) : value(std::move(value)) {}
+
+    void write(JsonWriter &writer) const override {
+      write_json(writer, value);
+    }
+
+    nlohmann::json toJson() const override { return value; }
+  };
+
+  std::variant<nlohmann::json, std::unique_ptr<Value>> mValue;
+
+public:
+  ResponseResult() = default;
+  ResponseResult(nlohmann::json value) : mValue(std::move(value)) {}
+
+  template <typename T>
+    requires(!std::is_same_v<std::remove_cvref_t<T>, nlohmann::json> &&
+             !std::is_same_v<std::remove_cvref_t<T>, ResponseResult>)
+  explicit ResponseResult(T &&value)
+      : mValue(std::make_unique<TypedValue<std::remove_cvref_t<T>>>(
+            std::forward<T>(value))) {}
+
+  // Result that was given as DOM
+  const nlohmann::json *getJson() const {
+    return std::get_if<nlohmann::json>(&mValue);
+  }
+
+  void write(JsonWriter &writer) const {
+    if (auto json = getJson()) {
+      writer.writeJson(*json);
+    } else {
+      std::get<std::unique_ptr<Value>>(mValue)->write(writer);
+    }
+  }
+
+  nlohmann::json toJson() && {
+    if (auto json = std::get_if<nlohmann::json>(&mValue)) {
+      return std::move(*json);
+    }
+
+    return std::get<std::unique_ptr<Value>>(mValue)->toJson();
+  }
+};
+} // namespace rpcsx::ui
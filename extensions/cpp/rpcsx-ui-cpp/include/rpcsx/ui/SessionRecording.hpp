@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Transport.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace rpcsx::ui {
+// Session recording file.
+//
+// Starts with 8 byte header: magic "RPSR" and little endian uint32 version.
+// Every record is direction byte, LEB128 nanoseconds since previous record,
+// LEB128 payload size and payload. Payloads are raw transport chunks.
+struct SessionRecording {
+  static constexpr char kMagic[4] = {'R', 'P', 'S', 'R'};
+  static constexpr std::uint32_t kVersion = 1;
+
+  enum class Direction : std::uint8_t { Inbound, Outbound };
+};
+
+// Forwards to wrapped transport and appends every chunk that passes through
+// it to recording file
+class RecordingTransport : public Transport {
+public:
+  RecordingTransport(const RecordingTransport &) = delete;
+  RecordingTransport &operator=(const RecordingTransport &) = delete;
+  ~RecordingTransport();
+
+  static std::expected<std::unique_ptr<RecordingTransport>, std::error_code>
+  create(std::unique_ptr<Transport> transport,
+         const std::filesystem::path &path);
+
+  void write(std::span<const std::byte> bytes) override;
+  void writev(std::span<const std::span<const std::byte>> buffers) override;
+  void read(std::span<std::byte> &bytes) override;
+  void flush() override;
+
+  bool canPassHandles() const override;
+  void writeWithHandles(std::span<const std::span<const std::byte>> buffers,
+                        std::span<const int> handles) override;
+  int takeHandle() override;
+  int getPollHandle() const override;
+
+private:
+  RecordingTransport(std::unique_ptr<Transport> transport, std::FILE *file);
+
+  void record(SessionRecording::Direction direction,
+              std::span<const std::span<const std::byte>> buffers);
+
+  std::unique_ptr<Transport> mTransport;
+  std::FILE *mFile = nullptr;
+  std::mutex mMutex;
+  std::chrono::steady_clock::time_point mLastRecord;
+};
+
+// Feeds inbound frames of recorded session to extension. Inbound frames are
+// delivered either at recorded pacing or as fast as extension reads them.
+//
+// Ids of outbound calls are not reproducible, so output of extension is read
+// for the calls it makes. Recorded responses get ids of live calls with the
+// same method and params, repeated calls are matched in order. Response to
+// call extension did not make in time keeps its recorded id
+class ReplayTransport : public Transport {
+public:
+  enum class Pacing { Original, Fast };
+
+  // how long response waits for extension to make its call
+  static constexpr std::chrono::seconds kCallWait{1};
+
+  ReplayTransport(const ReplayTransport &) = delete;
+  ReplayTransport &operator=(const ReplayTransport &) = delete;
+
+  static std::expected<std::unique_ptr<ReplayTransport>, std::error_code>
+  open(const std::filesystem::path &path, Pacing pacing = Pacing::Original);
+
+  void write(std::span<const std::byte> bytes) override;
+  void read(std::span<std::byte> &bytes) override;
+
+private:
+  struct Segment {
+    std::span<const std::byte> bytes;
+    std::chrono::nanoseconds time;
+    bool isResponse;
+  };
+
+  // Call is identified by method and params, repeated calls by their order
+  struct CallKey {
+    std::string key;
+    std::size_t occurrence;
+  };
+
+  explicit ReplayTransport(Pacing pacing) : mPacing(pacing) {}
+
+  void index(std::span<const std::byte> data);
+  std::span<const std::byte> rewriteResponse(std::span<const std::byte> frame);
+  std::optional<std::uint64_t> waitCall(const CallKey &call);
+
+  Pacing mPacing;
+  std::vector<std::byte> mInbound;
+  std::vector<Segment> mSegments;
+  std::size_t mNextSegment = 0;
+  std::span<const std::byte> mChunk;
+  std::vector<std::byte> mRewritten;
+  std::chrono::steady_clock::time_point mStart;
+  bool mStarted = false;
+
+  // calls extension made while session was recorded, by recorded id
+  std::unordered_map<std::uint64_t, CallKey> mRecordedCalls;
+
+  // calls extension makes on replay
+  std::mutex mCallsMutex;
+  std::condition_variable mCallsChanged;
+  std::vector<std::byte> mOutbound;
+  std::unordered_map<std::string, std::vector<std::uint64_t>> mLiveCalls;
+};
+} // namespace rpcsx::ui
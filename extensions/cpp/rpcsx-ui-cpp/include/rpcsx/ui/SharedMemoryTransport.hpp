@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SpscRing.hpp"
+#include "Transport.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+namespace rpcsx::ui {
+// Transport over two SPSC rings placed to memfd shared with host.
+//
+// Host creates memory object with SharedMemoryTransport::create() and passes
+// its descriptor with `--rpcsx-ui/transport shm --rpcsx-ui/transport-fd <fd>`.
+// First page contains SharedMemoryTransport::Layout, host to extension ring
+// data starts at kDataOffset, extension to host ring data follows it.
+class SharedMemoryTransport : public Transport {
+public:
+  static constexpr std::uint32_t kMagic = 0x4d535052; // RPSM
+  static constexpr std::uint32_t kVersion = 1;
+  static constexpr std::size_t kDataOffset = 4096;
+  static constexpr std::size_t kDefaultRingSize = 1024 * 1024;
+
+  struct Layout {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t ringSize;
+    std::uint32_t reserved;
+    SpscRingControl hostToExtension;
+    SpscRingControl extensionToHost;
+  };
+
+  static_assert(sizeof(Layout) <= kDataOffset);
+
+  enum class Side { Host, Extension };
+
+  SharedMemoryTransport(const SharedMemoryTransport &) = delete;
+  SharedMemoryTransport &operator=(const SharedMemoryTransport &) = delete;
+  ~SharedMemoryTransport();
+
+  // Creates new memory object, returns host side of transport and descriptor
+  // to pass to extension
+  static std::expected<std::pair<std::unique_ptr<SharedMemoryTransport>, int>,
+                       std::error_code>
+  create(std::size_t ringSize = kDefaultRingSize);
+
+  // Opens extension side of memory object created by host
+  static std::expected<std::unique_ptr<SharedMemoryTransport>, std::error_code>
+  open(int fd);
+
+  void write(std::span<const std::byte> bytes) override;
+  void read(std::span<std::byte> &bytes) override;
+
+private:
+  SharedMemoryTransport(int fd, void *mapping, std::size_t size, Side side);
+
+  int mFd = -1;
+  void *mMapping = nullptr;
+  std::size_t mMappingSize = 0;
+  SpscRing mInput;
+  SpscRing mOutput;
+};
+} // namespace rpcsx::ui
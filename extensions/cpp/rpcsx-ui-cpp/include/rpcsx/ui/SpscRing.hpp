@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace rpcsx::ui {
+// Control block of single producer single consumer byte ring. It has fixed
+// layout and can be placed to memory shared between processes, counters are
+// used as futex words
+struct SpscRingControl {
+  alignas(64) std::atomic<std::uint32_t> head{0};
+  std::atomic<std::uint32_t> consumerWaiting{0};
+  alignas(64) std::atomic<std::uint32_t> tail{0};
+  std::atomic<std::uint32_t> producerWaiting{0};
+  alignas(64) std::atomic<std::uint32_t> closed{0};
+};
+
+void futexWait(std::atomic<std::uint32_t> &word, std::uint32_t expected);
+void futexWake(std::atomic<std::uint32_t> &word);
+
+class SpscRing {
+  SpscRingControl *mControl = nullptr;
+  std::byte *mData = nullptr;
+  std::uint32_t mMask = 0;
+
+public:
+  static constexpr int kSpinCount = 512;
+
+  SpscRing() = default;
+
+  // data size must be power of two
+  SpscRing(SpscRingControl *control, std::span<std::byte> data)
+      : mControl(control), mData(data.data()),
+        mMask(static_cast<std::uint32_t>(data.size() - 1)) {}
+
+  std::size_t capacity() const { return std::size_t(mMask) + 1; }
+
+  // Blocks until every byte is written, returns false if ring was closed
+  bool write(std::span<const std::byte> bytes);
+
+  // Blocks until at least one byte is available, returns 0 if ring was
+  // closed and drained
+  std::size_t read(std::span<std::byte> bytes);
+
+  void close();
+  bool isClosed() const {
+    return mControl->closed.load(std::memory_order::acquire) != 0;
+  }
+
+private:
+  void wait(std::atomic<std::uint32_t> &word,
+            std::atomic<std::uint32_t> &waiting, std::uint32_t observed);
+  void notify(std::atomic<std::uint32_t> &word,
+              std::atomic<std::uint32_t> &waiting);
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace rpcsx::ui {
+template <typename T = void> class Task;
+
+template <typename T> struct TaskResult {
+  std::optional<T> value;
+
+  template <typename U> void return_value(U &&result) {
+    value.emplace(std::forward<U>(result));
+  }
+
+  T take() { return std::move(*value); }
+};
+
+template <> struct TaskResult<void> {
+  void return_void() {}
+  void take() {}
+};
+
+// Coroutine that starts right away and frees itself when done, exceptions
+// must not escape its body
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Lazy coroutine. Starts when it is awaited and resumes awaiting coroutine
+// when it completes, on the thread that completed it
+template <typename T> class [[nodiscard]] Task {
+public:
+  struct promise_type : TaskResult<T> {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() { return {}; }
+
+    auto final_suspend() noexcept {
+      struct Awaiter {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+          if (auto continuation = handle.promise().continuation) {
+            return continuation;
+          }
+
+          return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+      };
+
+      return Awaiter{};
+    }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+  };
+
+  Task() = default;
+  Task(Task &&other) noexcept : mHandle(std::exchange(other.mHandle, {})) {}
+  Task &operator=(Task &&other) noexcept {
+    std::swap(mHandle, other.mHandle);
+    return *this;
+  }
+
+  ~Task() {
+    if (mHandle) {
+      mHandle.destroy();
+    }
+  }
+
+  auto operator co_await() && {
+    struct Awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      bool await_ready() { return false; }
+
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> continuation) {
+        handle.promise().continuation = continuation;
+        return handle;
+      }
+
+      T await_resume() {
+        if (handle.promise().exception) {
+          std::rethrow_exception(handle.promise().exception);
+        }
+
+        return handle.promise().take();
+      }
+    };
+
+    return Awaiter{mHandle};
+  }
+
+private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle) {}
+
+  std::coroutine_handle<promise_type> mHandle;
+};
+
+// Runs task without awaiting it. Its result is passed to onDone, exception
+// it fails with is passed to onError
+template <typename T, typename F, typename E>
+void spawn(Task<T> task, F onDone, E onError) {
+  [](Task<T> task, F onDone, E onError) -> DetachedTask {
+    std::optional<TaskResult<T>> result;
+    std::exception_ptr exception;
+
+    try {
+      if constexpr (std::is_void_v<T>) {
+        co_await std::move(task);
+        result.emplace();
+      } else {
+        result.emplace().return_value(co_await std::move(task));
+      }
+    } catch (...) {
+      exception = std::current_exception();
+    }
+
+    if (exception) {
+      onError(std::move(exception));
+    } else if constexpr (std::is_void_v<T>) {
+      onDone();
+    } else {
+      onDone(result->take());
+    }
+  }(std::move(task), std::move(onDone), std::move(onError));
+}
+} // namespace rpcsx::ui
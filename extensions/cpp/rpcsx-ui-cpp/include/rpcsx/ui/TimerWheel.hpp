@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace rpcsx::ui {
+// Hierarchical timing wheel of ids with expiry ticks.
+//
+// Level L slot covers 64^L ticks. Entry goes to the lowest level where its
+// expiry shares every higher slot digit with current tick and is moved one
+// level down when current tick reaches start of its slot, so insert is O(1)
+// and each entry is touched at most once per level. Occupied slots are
+// tracked in bit masks, advance() jumps over ticks that have nothing to do.
+// Entries too far ahead wait in overflow list until the top level wraps.
+//
+// Entries cannot be removed, owner ignores ids that already completed.
+// Not thread safe.
+class TimerWheel {
+public:
+  using Tick = std::uint64_t;
+
+  static constexpr unsigned kSlotBits = 6;
+  static constexpr unsigned kLevels = 4;
+
+  explicit TimerWheel(Tick now = 0) : mNow(now) {}
+
+  Tick now() const { return mNow; }
+  bool empty() const { return mSize == 0; }
+  std::size_t size() const { return mSize; }
+
+  // Expiry in the past fires on the next tick
+  void add(std::uint64_t id, Tick expiry);
+
+  // Moves current tick to now and appends ids that expired by then
+  void advance(Tick now, std::vector<std::uint64_t> &expired);
+
+  // The earliest tick advance() has work at, std::nullopt if empty
+  std::optional<Tick> nextEvent() const;
+
+  void clear();
+
+private:
+  static constexpr std::size_t kSlots = std::size_t(1) << kSlotBits;
+  static constexpr Tick kSlotMask = kSlots - 1;
+
+  struct Entry {
+    std::uint64_t id;
+    Tick expiry;
+  };
+
+  void insert(Entry entry);
+
+  std::array<std::array<std::vector<Entry>, kSlots>, kLevels> mSlots;
+  std::array<std::uint64_t, kLevels> mOccupied{};
+  std::vector<Entry> mOverflow;
+  Tick mNow;
+  std::size_t mSize = 0;
+};
+} // namespace rpcsx::ui
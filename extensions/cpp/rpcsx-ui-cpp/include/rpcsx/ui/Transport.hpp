@@ -1,4 +1,5 @@
 #pragma once
+#include "file.hpp"
 #include <span>
 
 namespace rpcsx::ui {
@@ -6,7 +7,46 @@ class Transport {
 public:
   virtual ~Transport() = default;
   virtual void write(std::span<const std::byte> bytes) = 0;
+
+  // Writes buffers in order, transports override it to submit them with
+  // single system call
+  virtual void writev(std::span<const std::span<const std::byte>> buffers) {
+    for (auto buffer : buffers) {
+      write(buffer);
+    }
+  }
+
+  // Reads at most bytes.size() bytes, blocks until at least one byte is
+  // available. On return `bytes` refers to received data, empty span means
+  // end of stream
   virtual void read(std::span<std::byte> &bytes) = 0;
   virtual void flush() {}
+
+  // Descriptor passing, e.g. SCM_RIGHTS over unix sockets. Handles are
+  // delivered to the peer together with the first byte of buffers, transport
+  // takes ownership of them and closes after they were sent
+  virtual bool canPassHandles() const { return false; }
+  virtual void writeWithHandles(
+      std::span<const std::span<const std::byte>> buffers,
+      std::span<const int> handles) {
+    writev(buffers);
+
+    // handles cannot be sent, they are still owned by transport
+    for (int handle : handles) {
+      [[maybe_unused]] auto file = File::adopt(handle);
+    }
+  }
+
+  // Returns the oldest received handle that was not taken yet, -1 if there
+  // is none. Caller owns returned handle
+  virtual int takeHandle() { return -1; }
+
+  // Descriptor that becomes readable when read() would not block, -1 if
+  // transport cannot be polled
+  virtual int getPollHandle() const { return -1; }
+
+  // Descriptor write() sends bytes to, -1 if transport does not write to
+  // single descriptor
+  virtual int getOutputHandle() const { return -1; }
 };
 } // namespace rpcsx::ui
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rpcsx::ui {
+template <typename Signature> class UniqueFunction;
+
+// Move-only std::function. Callables that are small and nothrow movable are
+// stored inline, so wrapping lambda that captures a few pointers does not
+// allocate
+template <typename R, typename... Args> class UniqueFunction<R(Args...)> {
+  static constexpr std::size_t kInlineSize = 4 * sizeof(void *);
+
+  template <typename F>
+  static constexpr bool kStoredInline =
+      sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<F>;
+
+  struct Ops {
+    R (*invoke)(void *storage, Args &&...args);
+
+    // moves callable to empty storage and destroys source
+    void (*relocate)(void *target, void *source) noexcept;
+    void (*destroy)(void *storage) noexcept;
+  };
+
+  template <typename F> static F *get(void *storage) {
+    if constexpr (kStoredInline<F>) {
+      return std::launder(static_cast<F *>(storage));
+    } else {
+      return *static_cast<F **>(storage);
+    }
+  }
+
+  template <typename F>
+  static constexpr Ops kOps = {
+      [](void *storage, Args &&...args) -> R {
+        return std::invoke(*get<F>(storage), std::forward<Args>(args)...);
+      },
+      [](void *target, void *source) noexcept {
+        if constexpr (kStoredInline<F>) {
+          auto callable = get<F>(source);
+          new (target) F(std::move(*callable));
+          callable->~F();
+        } else {
+          *static_cast<F **>(target) = get<F>(source);
+        }
+      },
+      [](void *storage) noexcept {
+        if constexpr (kStoredInline<F>) {
+          get<F>(storage)->~F();
+        } else {
+          delete get<F>(storage);
+        }
+      },
+  };
+
+public:
+  UniqueFunction() = default;
+  UniqueFunction(std::nullptr_t) {}
+
+  template <typename F, typename T = std::remove_cvref_t<F>>
+    requires(!std::is_same_v<T, UniqueFunction> &&
+             std::is_invocable_r_v<R, T &, Args...>)
+  UniqueFunction(F &&callable) {
+    if constexpr (std::is_pointer_v<T> || std::is_member_pointer_v<T>) {
+      if (callable == nullptr) {
+        return;
+      }
+    }
+
+    if constexpr (kStoredInline<T>) {
+      new (mStorage) T(std::forward<F>(callable));
+    } else {
+      *reinterpret_cast<T **>(mStorage) = new T(std::forward<F>(callable));
+    }
+
+    mOps = &kOps<T>;
+  }
+
+  UniqueFunction(UniqueFunction &&other) noexcept { take(other); }
+
+  UniqueFunction &operator=(UniqueFunction &&other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+
+    return *this;
+  }
+
+  UniqueFunction &operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  ~UniqueFunction() { reset(); }
+
+  explicit operator bool() const { return mOps != nullptr; }
+
+  // Like std::function, const call invokes non-const callable
+  R operator()(Args... args) const {
+    return mOps->invoke(mStorage, std::forward<Args>(args)...);
+  }
+
+private:
+  void take(UniqueFunction &other) noexcept {
+    if (other.mOps != nullptr) {
+      other.mOps->relocate(mStorage, other.mStorage);
+      mOps = std::exchange(other.mOps, nullptr);
+    }
+  }
+
+  void reset() noexcept {
+    if (auto ops = std::exchange(mOps, nullptr)) {
+      ops->destroy(mStorage);
+    }
+  }
+
+  alignas(std::max_align_t) mutable std::byte mStorage[kInlineSize];
+  const Ops *mOps = nullptr;
+};
+} // namespace rpcsx::ui
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Transport.hpp"
+#include <cstddef>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+namespace rpcsx::ui {
+class UnixSocketTransport : public Transport {
+  int mSocket = -1;
+  std::deque<int> mReceivedHandles;
+
+public:
+  static constexpr std::size_t kDefaultBufferSize = 4 * 1024 * 1024;
+
+  // Kernel limit of descriptors attached to single message (SCM_MAX_FD)
+  static constexpr std::size_t kMaxHandlesPerMessage = 253;
+
+  explicit UnixSocketTransport(int socket) : mSocket(socket) {}
+  UnixSocketTransport(const UnixSocketTransport &) = delete;
+  UnixSocketTransport &operator=(const UnixSocketTransport &) = delete;
+  ~UnixSocketTransport();
+
+  // Takes ownership of already connected socket, e.g. inherited from host
+  static std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+  adopt(int socket, std::size_t bufferSize = kDefaultBufferSize);
+
+  static std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+  connect(const std::filesystem::path &path,
+          std::size_t bufferSize = kDefaultBufferSize);
+
+  void write(std::span<const std::byte> bytes) override;
+  void writev(std::span<const std::span<const std::byte>> buffers) override;
+  void read(std::span<std::byte> &bytes) override;
+  int getPollHandle() const override { return mSocket; }
+  int getOutputHandle() const override { return mSocket; }
+
+  bool canPassHandles() const override { return true; }
+  void writeWithHandles(std::span<const std::span<const std::byte>> buffers,
+                        std::span<const int> handles) override;
+  int takeHandle() override;
+
+  int getNativeHandle() const { return mSocket; }
+
+private:
+  void send(std::span<const std::span<const std::byte>> buffers,
+            std::span<const int> handles);
+};
+
+// Listening socket, every accepted connection is a separate transport
+class UnixSocketListener {
+  int mSocket = -1;
+  int mWakeRead = -1;
+  int mWakeWrite = -1;
+  std::filesystem::path mPath;
+
+public:
+  UnixSocketListener() = default;
+  UnixSocketListener(const UnixSocketListener &) = delete;
+  UnixSocketListener &operator=(const UnixSocketListener &) = delete;
+  UnixSocketListener(UnixSocketListener &&other)
+      : mSocket(std::exchange(other.mSocket, -1)),
+        mWakeRead(std::exchange(other.mWakeRead, -1)),
+        mWakeWrite(std::exchange(other.mWakeWrite, -1)),
+        mPath(std::move(other.mPath)) {}
+  UnixSocketListener &operator=(UnixSocketListener &&other) {
+    std::swap(mSocket, other.mSocket);
+    std::swap(mWakeRead, other.mWakeRead);
+    std::swap(mWakeWrite, other.mWakeWrite);
+    std::swap(mPath, other.mPath);
+    return *this;
+  }
+  ~UnixSocketListener();
+
+  static std::expected<UnixSocketListener, std::error_code>
+  listen(const std::filesystem::path &path);
+
+  // Blocks until new connection arrives or interrupt() was called
+  std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+  accept(std::size_t bufferSize = UnixSocketTransport::kDefaultBufferSize);
+
+  void interrupt();
+};
+} // namespace rpcsx::ui
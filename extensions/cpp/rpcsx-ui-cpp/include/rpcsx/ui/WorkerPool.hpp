@@ -0,0 +1,131 @@
+#pragma once
+
+#include "MpscQueue.hpp"
+#include "UniqueFunction.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace rpcsx::ui {
+// Fixed set of threads that run posted tasks. Tasks posted to the same strand
+// run one at a time in posting order, different strands and tasks without
+// strand run in parallel.
+//
+// Job is handed straight to a parked worker when there is one. When every
+// worker is busy it goes to shared overflow queue, workers take jobs from it
+// one at a time between tasks, so slow task delays only its own worker.
+// Posting a task without strand never waits for a lock, workers lock only to
+// take jobs from overflow.
+//
+// Strand is a mailbox that is scheduled to a worker while it has tasks, a
+// strand that ran its batch goes to the back of the queue, so busy strand
+// cannot starve others. Strands are looked up by exact id and exist only
+// while they have tasks.
+//
+// Finished jobs are recycled, posting a task that fits into Task's inline
+// storage does not allocate once enough jobs were created. Each worker keeps
+// its own cache of free jobs, threads outside of the pool share another one.
+class WorkerPool {
+public:
+  using Task = UniqueFunction<void()>;
+  using StrandId = std::uint64_t;
+
+  // onIdle is invoked from worker thread when the last pending task finishes,
+  // onStart on every worker thread before it runs any task
+  explicit WorkerPool(std::size_t threadCount, Task onIdle = {},
+                      Task onStart = {});
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+  ~WorkerPool();
+
+  // Waits for running tasks, queued tasks are discarded
+  void stop();
+
+  void post(Task task);
+  void post(StrandId strand, Task task);
+
+  std::size_t getThreadCount() const { return mWorkers.size(); }
+
+  // Number of jobs allocated so far, stays flat once the pool is warm
+  std::uint64_t getAllocatedJobs() const {
+    return mAllocatedJobs.load(std::memory_order::relaxed);
+  }
+
+private:
+  struct Strand;
+
+  // Free jobs owned by one posting thread
+  struct JobCache {
+    MpscNode *head = nullptr;
+  };
+
+  struct Job : MpscNode {
+    Task task;
+
+    // set for strand activation
+    Strand *strand = nullptr;
+  };
+
+  struct alignas(64) Strand {
+    StrandId id = 0;
+    MpscQueue tasks;
+    Job activation;
+  };
+
+  struct Worker {
+    WorkerPool *pool = nullptr;
+
+    // job of producer that claimed parked worker
+    std::atomic<Job *> handoff{nullptr};
+    std::atomic<std::uint32_t> state{0};
+    JobCache jobs;
+    std::thread thread;
+  };
+
+  using StrandMap = std::unordered_map<StrandId, std::unique_ptr<Strand>>;
+
+  Job *acquire();
+  Job *acquire(JobCache *cache);
+  void recycle(Job *job);
+  void run(Worker &worker);
+  void execute(Job *job);
+  void runStrand(Strand &strand);
+  Strand *createStrand(StrandId id);
+  void schedule(Job *job);
+  Job *takeOverflow();
+  void complete();
+
+  // Frees detached jobs, strand activations are owned by the pool
+  static void release(MpscNode *node);
+
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+
+  // strands that have tasks, idle ones are kept for reuse
+  std::mutex mStrandsMutex;
+  StrandMap mStrands;
+  std::vector<StrandMap::node_type> mFreeStrands;
+
+  MpscQueue mOverflow;
+  std::mutex mOverflowMutex;
+  MpscNode *mOverflowTaken = nullptr;
+  std::atomic<std::size_t> mOverflowSize{0};
+
+  MpscQueue mFreeJobs;
+  std::mutex mExternalJobsMutex;
+  JobCache mExternalJobs;
+  std::atomic<std::uint64_t> mAllocatedJobs{0};
+  std::atomic<std::size_t> mNextWorker{0};
+  std::atomic<std::size_t> mPending{0};
+  std::atomic<bool> mStopping{false};
+  Task mOnIdle;
+  Task mOnStart;
+
+  // worker that runs on calling thread, jobs it posts come from its cache
+  static thread_local Worker *gCurrentWorker;
+};
+} // namespace rpcsx::ui
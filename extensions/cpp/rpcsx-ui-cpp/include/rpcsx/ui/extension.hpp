@@ -80,6 +80,10 @@ public:
 using ExtensionBuilder =
     std::function<std::unique_ptr<ExtensionBase>(Protocol *)>;
 
+// Builds extension on top of protocol and dispatches messages until
+// transport reaches end of stream
+int runSession(const ExtensionBuilder &extensionBuilder, Protocol *protocol);
+
 template <typename T> ExtensionBuilder createExtension() {
   auto builder = [](Protocol *protocol) {
     return std::make_unique<T>(protocol);
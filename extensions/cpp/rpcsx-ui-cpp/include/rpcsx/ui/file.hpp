@@ -88,10 +88,21 @@ struct File {
 
   std::expected<FileData, std::error_code> map();
 
+  // Gives up ownership of native handle, -1 if file has none
+  int release();
+
   static std::expected<File, std::error_code>
   open(const std::filesystem::path &path,
        std::ios::openmode mode = std::ios::binary | std::ios::in);
 
+  // Takes ownership of native file descriptor
+  static std::expected<File, std::error_code> adopt(int handle);
+
+  // Anonymous sealed in-memory file with a copy of data. It can be shared
+  // with other processes and mapped there read-only
+  static std::expected<File, std::error_code>
+  createMemory(std::span<const std::byte> data);
+
 private:
   Impl *m_impl = nullptr;
 };
@@ -1,8 +1,19 @@
 #pragma once
 #include "Protocol.hpp"
 #include <cstdarg>
+#include <cstdio>
 
 namespace rpcsx::ui {
+// Threads outside of sessions have no protocol to log to when extension
+// serves several clients
+inline void sendLogMessage(LogLevel level, const char *message) {
+  if (auto protocol = Protocol::getDefault()) {
+    protocol->sendLogMessage(level, message);
+  } else {
+    std::fprintf(stderr, "%s\n", message);
+  }
+}
+
 [[gnu::format(__printf__, 2, 3)]]
 inline void log(LogLevel level, const char *fmt, ...) {
   char buffer[256];
@@ -14,7 +25,7 @@ inline void log(LogLevel level, const char *fmt, ...) {
 
   buffer[255] = 0;
 
-  Protocol::getDefault()->sendLogMessage(level, buffer);
+  sendLogMessage(level, buffer);
 }
 
 [[gnu::format(__printf__, 1, 2)]]
@@ -28,7 +39,7 @@ inline void ilog(const char *fmt, ...) {
 
   buffer[255] = 0;
 
-  Protocol::getDefault()->sendLogMessage(LogLevel::Info, buffer);
+  sendLogMessage(LogLevel::Info, buffer);
 }
 
 [[gnu::format(__printf__, 1, 2)]]
@@ -42,7 +53,7 @@ inline void elog(const char *fmt, ...) {
 
   buffer[255] = 0;
 
-  Protocol::getDefault()->sendLogMessage(LogLevel::Error, buffer);
+  sendLogMessage(LogLevel::Error, buffer);
 }
 
 [[gnu::format(__printf__, 1, 2)]] inline void wlog(const char *fmt, ...) {
@@ -55,7 +66,7 @@ inline void elog(const char *fmt, ...) {
 
   buffer[255] = 0;
 
-  Protocol::getDefault()->sendLogMessage(LogLevel::Warning, buffer);
+  sendLogMessage(LogLevel::Warning, buffer);
 }
 
 [[gnu::format(__printf__, 1, 2), noreturn]] inline void fatal(const char *fmt,
@@ -69,7 +80,7 @@ inline void elog(const char *fmt, ...) {
 
   buffer[255] = 0;
 
-  Protocol::getDefault()->sendLogMessage(LogLevel::Fatal, buffer);
+  sendLogMessage(LogLevel::Fatal, buffer);
 
   std::exit(1);
 }
@@ -0,0 +1,303 @@
+#include "rpcsx/ui/EventLoop.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+
+#if defined(__linux)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+EventLoop::EventLoop() {
+#if defined(__linux)
+  mEpollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  mWakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  mTimerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+
+  bool valid = mEpollFd >= 0 && mWakeFd >= 0 && mTimerFd >= 0;
+
+  for (int fd : {mWakeFd, mTimerFd}) {
+    if (!valid) {
+      break;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    valid = ::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+  }
+
+  if (!valid) {
+    // fall back to portable loop
+    for (int *fd : {&mEpollFd, &mWakeFd, &mTimerFd}) {
+      if (*fd >= 0) {
+        ::close(*fd);
+        *fd = -1;
+      }
+    }
+  }
+#endif
+}
+
+EventLoop::~EventLoop() {
+#if defined(__linux)
+  for (int fd : {mEpollFd, mWakeFd, mTimerFd}) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+#endif
+}
+
+void EventLoop::run() {
+  mLoopThread.store(std::this_thread::get_id(), std::memory_order::relaxed);
+
+#if defined(__linux)
+  if (mEpollFd >= 0) {
+    while (true) {
+      {
+        std::lock_guard lock(mMutex);
+        if (mStop) {
+          break;
+        }
+      }
+
+      runPosted();
+
+      for (int fd : mUnwatched) {
+        mWatchers.erase(fd);
+      }
+
+      mUnwatched.clear();
+
+      epoll_event events[32];
+      int count = ::epoll_wait(mEpollFd, events, std::size(events), -1);
+
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        break;
+      }
+
+      for (int i = 0; i < count; ++i) {
+        int fd = events[i].data.fd;
+
+        if (fd == mWakeFd || fd == mTimerFd) {
+          std::uint64_t value;
+          [[maybe_unused]] auto result = ::read(fd, &value, sizeof(value));
+
+          if (fd == mTimerFd) {
+            runExpiredTimers();
+          }
+
+          continue;
+        }
+
+        if (std::ranges::find(mUnwatched, fd) != mUnwatched.end()) {
+          continue;
+        }
+
+        if (auto it = mWatchers.find(fd); it != mWatchers.end()) {
+          it->second();
+        }
+      }
+    }
+
+    mLoopThread.store({}, std::memory_order::relaxed);
+    return;
+  }
+#endif
+
+  std::unique_lock lock(mMutex);
+
+  while (!mStop) {
+    if (!mPosted.empty()) {
+      lock.unlock();
+      runPosted();
+      lock.lock();
+      continue;
+    }
+
+    if (mTimers.empty()) {
+      mCv.wait(lock);
+      continue;
+    }
+
+    auto deadline = mTimers.begin()->first.first;
+
+    if (deadline <= Clock::now()) {
+      lock.unlock();
+      runExpiredTimers();
+      lock.lock();
+      continue;
+    }
+
+    mCv.wait_until(lock, deadline);
+  }
+
+  mLoopThread.store({}, std::memory_order::relaxed);
+}
+
+void EventLoop::stop() {
+  {
+    std::lock_guard lock(mMutex);
+    mStop = true;
+  }
+
+  wake();
+}
+
+void EventLoop::post(Callback callback) {
+  bool needWake;
+
+  {
+    std::lock_guard lock(mMutex);
+    mPosted.push_back(std::move(callback));
+    needWake = !std::exchange(mWakePending, true);
+  }
+
+  if (needWake) {
+    wake();
+  }
+}
+
+EventLoop::TimerId EventLoop::addTimer(Clock::time_point deadline,
+                                       Callback callback) {
+  std::lock_guard lock(mMutex);
+  TimerId id = mNextTimerId++;
+  bool earliest =
+      mTimers.empty() || deadline < mTimers.begin()->first.first;
+
+  mTimers.emplace(std::pair{deadline, id}, std::move(callback));
+  mTimerDeadlines.emplace(id, deadline);
+
+  if (earliest) {
+    armTimer(deadline);
+  }
+
+  return id;
+}
+
+void EventLoop::cancelTimer(TimerId id) {
+  // timer is not rearmed, loop tolerates spurious expiration
+  std::lock_guard lock(mMutex);
+
+  if (auto it = mTimerDeadlines.find(id); it != mTimerDeadlines.end()) {
+    mTimers.erase(std::pair{it->second, id});
+    mTimerDeadlines.erase(it);
+  }
+}
+
+bool EventLoop::watch(int fd, Callback onReadable) {
+#if defined(__linux)
+  if (mEpollFd < 0) {
+    return false;
+  }
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+
+  // epoll rejects regular files, they are always readable anyway
+  if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    return false;
+  }
+
+  std::erase(mUnwatched, fd);
+  mWatchers[fd] = std::move(onReadable);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void EventLoop::unwatch(int fd) {
+  if (!mWatchers.contains(fd)) {
+    return;
+  }
+
+#if defined(__linux)
+  ::epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+
+  // callback can unwatch itself, it is destroyed after dispatch is finished
+  mUnwatched.push_back(fd);
+}
+
+void EventLoop::wake() {
+#if defined(__linux)
+  if (mWakeFd >= 0) {
+    std::uint64_t value = 1;
+    [[maybe_unused]] auto result = ::write(mWakeFd, &value, sizeof(value));
+    return;
+  }
+#endif
+
+  mCv.notify_one();
+}
+
+void EventLoop::armTimer(Clock::time_point deadline) {
+#if defined(__linux)
+  if (mTimerFd >= 0) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  deadline.time_since_epoch())
+                  .count();
+
+    // zero value disarms timer
+    if (ns <= 0) {
+      ns = 1;
+    }
+
+    itimerspec spec{};
+    spec.it_value.tv_sec = ns / 1'000'000'000;
+    spec.it_value.tv_nsec = ns % 1'000'000'000;
+    ::timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    return;
+  }
+#endif
+
+  mCv.notify_one();
+}
+
+void EventLoop::runPosted() {
+  {
+    std::lock_guard lock(mMutex);
+    std::swap(mPosted, mRunning);
+    mWakePending = false;
+  }
+
+  for (auto &callback : mRunning) {
+    callback();
+  }
+
+  mRunning.clear();
+}
+
+void EventLoop::runExpiredTimers() {
+  {
+    std::lock_guard lock(mMutex);
+    auto now = Clock::now();
+
+    while (!mTimers.empty() && mTimers.begin()->first.first <= now) {
+      auto node = mTimers.extract(mTimers.begin());
+      mTimerDeadlines.erase(node.key().second);
+      mDueTimers.push_back(std::move(node.mapped()));
+    }
+
+    if (!mTimers.empty()) {
+      armTimer(mTimers.begin()->first.first);
+    }
+  }
+
+  for (auto &callback : mDueTimers) {
+    callback();
+  }
+
+  mDueTimers.clear();
+}
@@ -0,0 +1,444 @@
+#include "rpcsx/ui/FrameCodec.hpp"
+#include <algorithm>
+#include <climits>
+#include <memory>
+
+#if defined(RPCSX_UI_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(RPCSX_UI_HAVE_LZ4)
+#include <lz4frame.h>
+#endif
+
+#if defined(RPCSX_UI_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+// Upper bound for decoded body, protects against decompression bombs
+static constexpr std::size_t kMaxDecodedSize = 256 * 1024 * 1024;
+static constexpr std::size_t kMinDecodeChunk = 16 * 1024;
+
+static constexpr FrameEncoding kSupportedEncodings[] = {
+#if defined(RPCSX_UI_HAVE_LZ4)
+    FrameEncoding::Lz4,
+#endif
+#if defined(RPCSX_UI_HAVE_ZSTD)
+    FrameEncoding::Zstd,
+#endif
+#if defined(RPCSX_UI_HAVE_ZLIB)
+    FrameEncoding::Deflate,
+#endif
+    FrameEncoding::Identity,
+};
+
+namespace {
+enum class DecodeStatus {
+  Done,
+  More,
+  Error,
+};
+} // namespace
+
+// Runs streaming decoder step until it reports end of stream. Step receives
+// free space of output and returns number of bytes written to it
+template <typename Step>
+static bool decodeStream(std::vector<std::byte> &output, std::size_t sizeHint,
+                         Step &&step) {
+  std::size_t begin = output.size();
+  std::size_t end = begin;
+  output.resize(begin +
+                std::clamp(sizeHint, kMinDecodeChunk, kMaxDecodedSize));
+
+  while (true) {
+    if (end == output.size()) {
+      std::size_t decoded = end - begin;
+      if (decoded >= kMaxDecodedSize) {
+        break;
+      }
+
+      output.resize(begin + std::min(decoded * 2, kMaxDecodedSize));
+    }
+
+    std::size_t written = 0;
+    auto status = step(std::span(output).subspan(end), written);
+    end += written;
+
+    if (status == DecodeStatus::Done) {
+      output.resize(end);
+      return true;
+    }
+
+    if (status == DecodeStatus::Error) {
+      break;
+    }
+  }
+
+  output.resize(begin);
+  return false;
+}
+
+#if defined(RPCSX_UI_HAVE_ZLIB)
+namespace {
+struct DeflateStream {
+  z_stream stream{};
+  bool valid = deflateInit(&stream, Z_BEST_SPEED) == Z_OK;
+
+  ~DeflateStream() { deflateEnd(&stream); }
+};
+
+struct InflateStream {
+  z_stream stream{};
+  bool valid = inflateInit(&stream) == Z_OK;
+
+  ~InflateStream() { inflateEnd(&stream); }
+};
+} // namespace
+
+static bool encodeDeflate(std::span<const std::byte> input,
+                          std::vector<std::byte> &output) {
+  thread_local DeflateStream deflater;
+  auto &stream = deflater.stream;
+
+  if (!deflater.valid || input.size() > UINT_MAX ||
+      deflateReset(&stream) != Z_OK) {
+    return false;
+  }
+
+  std::size_t offset = output.size();
+  std::size_t bound = deflateBound(&stream, input.size());
+  output.resize(offset + bound);
+
+  stream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<std::byte *>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+  stream.avail_out = bound;
+
+  if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+    output.resize(offset);
+    return false;
+  }
+
+  output.resize(offset + bound - stream.avail_out);
+  return true;
+}
+
+static bool decodeDeflate(std::span<const std::byte> input,
+                          std::vector<std::byte> &output) {
+  thread_local InflateStream inflater;
+  auto &stream = inflater.stream;
+
+  if (!inflater.valid || input.size() > UINT_MAX ||
+      inflateReset(&stream) != Z_OK) {
+    return false;
+  }
+
+  stream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<std::byte *>(input.data()));
+  stream.avail_in = input.size();
+
+  return decodeStream(
+      output, input.size() * 4,
+      [&](std::span<std::byte> free, std::size_t &written) {
+        stream.next_out = reinterpret_cast<Bytef *>(free.data());
+        stream.avail_out = std::min<std::size_t>(free.size(), UINT_MAX);
+        auto available = stream.avail_out;
+        int result = inflate(&stream, Z_NO_FLUSH);
+        written = available - stream.avail_out;
+
+        if (result == Z_STREAM_END) {
+          return DecodeStatus::Done;
+        }
+
+        if ((result == Z_OK || result == Z_BUF_ERROR) &&
+            stream.avail_out == 0) {
+          return DecodeStatus::More;
+        }
+
+        return DecodeStatus::Error;
+      });
+}
+#endif
+
+#if defined(RPCSX_UI_HAVE_LZ4)
+static bool encodeLz4(std::span<const std::byte> input,
+                      std::vector<std::byte> &output) {
+  LZ4F_preferences_t preferences{};
+  preferences.frameInfo.contentSize = input.size();
+
+  std::size_t offset = output.size();
+  std::size_t bound = LZ4F_compressFrameBound(input.size(), &preferences);
+  output.resize(offset + bound);
+
+  auto size = LZ4F_compressFrame(output.data() + offset, bound, input.data(),
+                                 input.size(), &preferences);
+
+  if (LZ4F_isError(size)) {
+    output.resize(offset);
+    return false;
+  }
+
+  output.resize(offset + size);
+  return true;
+}
+
+static bool decodeLz4(std::span<const std::byte> input,
+                      std::vector<std::byte> &output) {
+  struct Context {
+    LZ4F_dctx *context = nullptr;
+    Context() { LZ4F_createDecompressionContext(&context, LZ4F_VERSION); }
+    ~Context() { LZ4F_freeDecompressionContext(context); }
+  };
+
+  thread_local Context decompressor;
+  auto context = decompressor.context;
+
+  if (context == nullptr) {
+    return false;
+  }
+
+  LZ4F_resetDecompressionContext(context);
+
+  return decodeStream(
+      output, input.size() * 4,
+      [&](std::span<std::byte> free, std::size_t &written) {
+        std::size_t consumed = input.size();
+        written = free.size();
+        auto result = LZ4F_decompress(context, free.data(), &written,
+                                      input.data(), &consumed, nullptr);
+        input = input.subspan(consumed);
+
+        if (LZ4F_isError(result)) {
+          return DecodeStatus::Error;
+        }
+
+        if (result == 0) {
+          return DecodeStatus::Done;
+        }
+
+        // truncated frame
+        if (input.empty() && written < free.size()) {
+          return DecodeStatus::Error;
+        }
+
+        return DecodeStatus::More;
+      });
+}
+#endif
+
+#if defined(RPCSX_UI_HAVE_ZSTD)
+static bool encodeZstd(std::span<const std::byte> input,
+                       std::vector<std::byte> &output) {
+  thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context{
+      ZSTD_createCCtx(), ZSTD_freeCCtx};
+
+  if (context == nullptr) {
+    return false;
+  }
+
+  std::size_t offset = output.size();
+  std::size_t bound = ZSTD_compressBound(input.size());
+  output.resize(offset + bound);
+
+  auto size = ZSTD_compressCCtx(context.get(), output.data() + offset, bound,
+                                input.data(), input.size(), 1);
+
+  if (ZSTD_isError(size)) {
+    output.resize(offset);
+    return false;
+  }
+
+  output.resize(offset + size);
+  return true;
+}
+
+static bool decodeZstd(std::span<const std::byte> input,
+                       std::vector<std::byte> &output) {
+  thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context{
+      ZSTD_createDCtx(), ZSTD_freeDCtx};
+
+  if (context == nullptr) {
+    return false;
+  }
+
+  ZSTD_DCtx_reset(context.get(), ZSTD_reset_session_only);
+
+  // unknown size and errors are reported as huge values
+  auto contentSize = ZSTD_getFrameContentSize(input.data(), input.size());
+  if (contentSize > kMaxDecodedSize) {
+    contentSize = input.size() * 4;
+  }
+
+  ZSTD_inBuffer in{input.data(), input.size(), 0};
+
+  return decodeStream(
+      output, contentSize,
+      [&](std::span<std::byte> free, std::size_t &written) {
+        ZSTD_outBuffer out{free.data(), free.size(), 0};
+        auto result = ZSTD_decompressStream(context.get(), &out, &in);
+        written = out.pos;
+
+        if (ZSTD_isError(result)) {
+          return DecodeStatus::Error;
+        }
+
+        if (result == 0) {
+          return DecodeStatus::Done;
+        }
+
+        if (in.pos == in.size && out.pos < out.size) {
+          return DecodeStatus::Error;
+        }
+
+        return DecodeStatus::More;
+      });
+}
+#endif
+
+static constexpr MessageFormat kMessageFormats[] = {
+    MessageFormat::Json,
+    MessageFormat::MsgPack,
+    MessageFormat::Cbor,
+};
+
+std::string_view rpcsx::ui::getMessageFormatName(MessageFormat format) {
+  switch (format) {
+  case MessageFormat::Json:
+    return "json";
+  case MessageFormat::MsgPack:
+    return "msgpack";
+  case MessageFormat::Cbor:
+    return "cbor";
+  }
+
+  return {};
+}
+
+std::optional<MessageFormat>
+rpcsx::ui::parseMessageFormat(std::string_view name) {
+  for (auto format : kMessageFormats) {
+    if (getMessageFormatName(format) == name) {
+      return format;
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::string_view rpcsx::ui::getMessageFormatContentType(MessageFormat format) {
+  switch (format) {
+  case MessageFormat::Json:
+    return "application/json";
+  case MessageFormat::MsgPack:
+    return "application/msgpack";
+  case MessageFormat::Cbor:
+    return "application/cbor";
+  }
+
+  return {};
+}
+
+std::optional<MessageFormat>
+rpcsx::ui::parseMessageContentType(std::string_view type) {
+  // parameters like charset do not change the format
+  type = type.substr(0, type.find(';'));
+
+  while (!type.empty() && type.back() == ' ') {
+    type.remove_suffix(1);
+  }
+
+  // LSP style type used by JSON-RPC peers
+  if (type == "application/vscode-jsonrpc") {
+    return MessageFormat::Json;
+  }
+
+  for (auto format : kMessageFormats) {
+    if (getMessageFormatContentType(format) == type) {
+      return format;
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::span<const FrameEncoding> rpcsx::ui::getSupportedFrameEncodings() {
+  return kSupportedEncodings;
+}
+
+std::string_view rpcsx::ui::getFrameEncodingName(FrameEncoding encoding) {
+  switch (encoding) {
+  case FrameEncoding::Identity:
+    return "identity";
+  case FrameEncoding::Deflate:
+    return "deflate";
+  case FrameEncoding::Lz4:
+    return "lz4";
+  case FrameEncoding::Zstd:
+    return "zstd";
+  }
+
+  return {};
+}
+
+std::optional<FrameEncoding>
+rpcsx::ui::parseFrameEncoding(std::string_view name) {
+  for (auto encoding : {FrameEncoding::Identity, FrameEncoding::Deflate,
+                        FrameEncoding::Lz4, FrameEncoding::Zstd}) {
+    if (getFrameEncodingName(encoding) == name) {
+      return encoding;
+    }
+  }
+
+  return std::nullopt;
+}
+
+bool rpcsx::ui::encodeFrame(FrameEncoding encoding,
+                            std::span<const std::byte> input,
+                            std::vector<std::byte> &output) {
+  switch (encoding) {
+  case FrameEncoding::Identity:
+    output.insert(output.end(), input.begin(), input.end());
+    return true;
+#if defined(RPCSX_UI_HAVE_ZLIB)
+  case FrameEncoding::Deflate:
+    return encodeDeflate(input, output);
+#endif
+#if defined(RPCSX_UI_HAVE_LZ4)
+  case FrameEncoding::Lz4:
+    return encodeLz4(input, output);
+#endif
+#if defined(RPCSX_UI_HAVE_ZSTD)
+  case FrameEncoding::Zstd:
+    return encodeZstd(input, output);
+#endif
+  default:
+    return false;
+  }
+}
+
+bool rpcsx::ui::decodeFrame(FrameEncoding encoding,
+                            std::span<const std::byte> input,
+                            std::vector<std::byte> &output) {
+  switch (encoding) {
+  case FrameEncoding::Identity:
+    output.insert(output.end(), input.begin(), input.end());
+    return true;
+#if defined(RPCSX_UI_HAVE_ZLIB)
+  case FrameEncoding::Deflate:
+    return decodeDeflate(input, output);
+#endif
+#if defined(RPCSX_UI_HAVE_LZ4)
+  case FrameEncoding::Lz4:
+    return decodeLz4(input, output);
+#endif
+#if defined(RPCSX_UI_HAVE_ZSTD)
+  case FrameEncoding::Zstd:
+    return decodeZstd(input, output);
+#endif
+  default:
+    return false;
+  }
+}
@@ -0,0 +1,349 @@
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+using namespace rpcsx::ui;
+
+static constexpr std::string_view kHeaderEnd = "\r\n\r\n";
+static constexpr std::size_t kMinReadSize = 4 * 1024;
+
+static std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+
+  return text;
+}
+
+static bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+  return std::ranges::equal(lhs, rhs, [](char a, char b) {
+    return std::tolower(static_cast<unsigned char>(a)) ==
+           std::tolower(static_cast<unsigned char>(b));
+  });
+}
+
+// Calls onField(name, value) for header lines, stops once it returns false
+template <typename F>
+static bool parseFields(std::string_view header, F &&onField) {
+  while (!header.empty()) {
+    auto lineEnd = header.find("\r\n");
+    auto line = header.substr(0, lineEnd);
+    header = lineEnd == std::string_view::npos ? std::string_view{}
+                                               : header.substr(lineEnd + 2);
+
+    auto separator = line.find(':');
+    if (separator == std::string_view::npos) {
+      continue;
+    }
+
+    if (!onField(trim(line.substr(0, separator)),
+                 trim(line.substr(separator + 1)))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static std::optional<std::size_t> parseContentLength(std::string_view value) {
+  std::size_t result;
+  auto [ptr, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), result);
+
+  if (ec != std::errc{} || ptr != value.data() + value.size() ||
+      result > FrameDecoder::kMaxContentLength) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+FrameDecoder::FrameDecoder(std::size_t capacity)
+    : mBuffer(std::make_shared<FrameBuffer>()) {
+  mBuffer->bytes.resize(capacity);
+}
+
+std::optional<FrameHeader> FrameDecoder::parseHeader(std::string_view header) {
+  FrameHeader result;
+  bool hasContentLength = false;
+
+  bool valid = parseFields(header, [&](std::string_view name,
+                                       std::string_view value) {
+    if (equalsIgnoreCase(name, "Content-Length")) {
+      auto length = parseContentLength(value);
+      if (!length) {
+        return false;
+      }
+
+      result.contentLength = *length;
+      hasContentLength = true;
+    } else if (equalsIgnoreCase(name, "Content-Encoding")) {
+      // body still has to be skipped, keep the header valid
+      result.encoding = parseFrameEncoding(value);
+    } else if (equalsIgnoreCase(name, "Content-Type")) {
+      result.format = parseMessageContentType(value);
+    } else if (equalsIgnoreCase(name, "Content-Handles")) {
+      while (!value.empty()) {
+        auto idEnd = value.find(',');
+        auto idText = trim(value.substr(0, idEnd));
+        value = idEnd == std::string_view::npos ? std::string_view{}
+                                                : value.substr(idEnd + 1);
+
+        std::uint64_t id;
+        auto [ptr, ec] =
+            std::from_chars(idText.data(), idText.data() + idText.size(), id);
+
+        if (ec != std::errc{} || ptr != idText.data() + idText.size()) {
+          return false;
+        }
+
+        result.handleIds.push_back(id);
+      }
+    }
+
+    return true;
+  });
+
+  if (!valid || !hasContentLength) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+std::optional<std::size_t>
+FrameDecoder::findContentLength(std::string_view header) {
+  std::optional<std::size_t> result;
+
+  parseFields(header, [&](std::string_view name, std::string_view value) {
+    if (!equalsIgnoreCase(name, "Content-Length")) {
+      return true;
+    }
+
+    result = parseContentLength(value);
+    return false;
+  });
+
+  return result;
+}
+
+std::optional<std::size_t> FrameDecoder::findHeaderEnd() {
+  auto data = reinterpret_cast<const char *>(mBuffer->bytes.data());
+  std::size_t pos = std::max(mScanPos, mBegin);
+
+  while (pos < mEnd) {
+    auto found =
+        static_cast<const char *>(std::memchr(data + pos, '\r', mEnd - pos));
+
+    if (found == nullptr) {
+      pos = mEnd;
+      break;
+    }
+
+    pos = found - data;
+
+    if (mEnd - pos < kHeaderEnd.size()) {
+      break;
+    }
+
+    if (std::memcmp(found, kHeaderEnd.data(), kHeaderEnd.size()) == 0) {
+      mScanPos = pos;
+      return pos;
+    }
+
+    ++pos;
+  }
+
+  mScanPos = pos;
+  return std::nullopt;
+}
+
+bool FrameDecoder::isLeased() const {
+  return mBuffer->leases.load(std::memory_order::acquire) != 0;
+}
+
+// Bytes after mEnd are not part of any frame, so input is appended to leased
+// buffer in place. Moving or growing it would invalidate leased bodies, the
+// unread bytes go to free buffer instead
+void FrameDecoder::reserve(std::size_t required) {
+  if (mBuffer->bytes.size() - mBegin >= required &&
+      mBuffer->bytes.size() - mEnd >= kMinReadSize) {
+    return;
+  }
+
+  std::size_t size = mEnd - mBegin;
+
+  if (isLeased()) {
+    auto spare = std::ranges::find_if(mSpareBuffers, [](auto &buffer) {
+      return buffer->leases.load(std::memory_order::acquire) == 0;
+    });
+
+    auto next = spare != mSpareBuffers.end()
+                    ? std::move(*spare)
+                    : std::make_shared<FrameBuffer>();
+
+    if (next->bytes.size() < mBuffer->bytes.size()) {
+      next->bytes.resize(mBuffer->bytes.size());
+    }
+
+    std::memcpy(next->bytes.data(), mBuffer->bytes.data() + mBegin, size);
+
+    if (spare != mSpareBuffers.end()) {
+      *spare = std::exchange(mBuffer, std::move(next));
+    } else {
+      mSpareBuffers.push_back(std::exchange(mBuffer, std::move(next)));
+    }
+  } else if (mBegin > 0) {
+    std::memmove(mBuffer->bytes.data(), mBuffer->bytes.data() + mBegin, size);
+  }
+
+  mScanPos -= std::min(mScanPos, mBegin);
+  mBegin = 0;
+  mEnd = size;
+
+  auto &bytes = mBuffer->bytes;
+  if (bytes.size() < required || bytes.size() - mEnd < kMinReadSize) {
+    bytes.resize(std::max(required, bytes.size() * 2));
+  }
+}
+
+bool FrameDecoder::receive(Transport &transport) {
+  reserve(mRequired);
+
+  std::span bytes = std::span(mBuffer->bytes).subspan(mEnd);
+  transport.read(bytes);
+
+  if (bytes.empty()) {
+    return false;
+  }
+
+  mEnd += bytes.size();
+  return true;
+}
+
+std::optional<Frame> FrameDecoder::next(Transport &transport) {
+  while (true) {
+    if (auto frame = decode()) {
+      return frame;
+    }
+
+    if (!receive(transport)) {
+      return std::nullopt;
+    }
+  }
+}
+
+// Drops the rest of invalid frame, returns false while more input is needed
+bool FrameDecoder::skipDropped() {
+  if (mSkip != 0) {
+    auto count = std::min(mSkip, mEnd - mBegin);
+    mBegin += count;
+    mScanPos = mBegin;
+    mSkip -= count;
+
+    if (mSkip != 0) {
+      return false;
+    }
+  }
+
+  if (!mResync) {
+    return true;
+  }
+
+  // writers spell the header name this way, other spellings are not found
+  constexpr std::string_view kContentLength = "Content-Length";
+  std::string_view text(
+      reinterpret_cast<const char *>(mBuffer->bytes.data()) + mBegin,
+      mEnd - mBegin);
+
+  auto pos = text.find(kContentLength);
+  if (pos == std::string_view::npos) {
+    // name can be split between reads
+    mBegin = mEnd - std::min(text.size(), kContentLength.size() - 1);
+    mScanPos = mBegin;
+    return false;
+  }
+
+  mBegin += pos;
+  mScanPos = mBegin;
+  mResync = false;
+  return true;
+}
+
+std::optional<Frame> FrameDecoder::decode() {
+  if (mBegin == mEnd && !isLeased()) {
+    mBegin = 0;
+    mEnd = 0;
+    mScanPos = 0;
+  }
+
+  while (true) {
+    if (!skipDropped()) {
+      mRequired = mEnd - mBegin + 1;
+      return std::nullopt;
+    }
+
+    auto headerEnd = findHeaderEnd();
+
+    if (!headerEnd) {
+      if (mScanPos - mBegin > kMaxHeaderSize) {
+        std::fprintf(stderr, "frame header is too long, %zu bytes dropped\n",
+                     mScanPos - mBegin);
+        mBegin = mScanPos;
+        mResync = true;
+        continue;
+      }
+
+      mRequired = mEnd - mBegin + 1;
+      return std::nullopt;
+    }
+
+    std::string_view headerText(
+        reinterpret_cast<const char *>(mBuffer->bytes.data() + mBegin),
+        *headerEnd - mBegin);
+    std::size_t bodyOffset = *headerEnd + kHeaderEnd.size() - mBegin;
+
+    auto header = parseHeader(headerText);
+    if (!header || header->contentLength >
+                       std::numeric_limits<std::size_t>::max() - bodyOffset) {
+      std::fprintf(stderr, "invalid frame header\n");
+      mBegin += bodyOffset;
+      mScanPos = mBegin;
+
+      // body that follows is not taken for headers
+      if (auto length = findContentLength(headerText); length && !header) {
+        mSkip = *length;
+      } else {
+        mResync = true;
+      }
+
+      continue;
+    }
+
+    std::size_t frameSize = bodyOffset + header->contentLength;
+    if (mEnd - mBegin < frameSize) {
+      mRequired = frameSize;
+      return std::nullopt;
+    }
+
+    Frame frame{
+        .header = *header,
+        .body = std::span(mBuffer->bytes)
+                    .subspan(mBegin + bodyOffset, header->contentLength),
+        .buffer = FrameLease(mBuffer),
+    };
+
+    mBegin += frameSize;
+    mScanPos = mBegin;
+    return frame;
+  }
+}
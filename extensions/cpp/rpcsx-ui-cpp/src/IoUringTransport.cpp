@@ -0,0 +1,550 @@
+#include "rpcsx/ui/IoUringTransport.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+#if defined(__linux)
+static_assert(std::has_single_bit(IoUringTransport::kRecvBufferCount));
+
+// registered file indices
+static constexpr int kInputFile = 0;
+static constexpr int kOutputFile = 1;
+static constexpr std::uint16_t kBufferGroup = 0;
+
+// user_data keeps operation kind in high half and buffer index in low half
+enum : std::uint64_t {
+  kRecvTag = 1,
+  kSendTag = 2,
+  kCancelTag = 3,
+};
+
+static std::uint64_t makeUserData(std::uint64_t tag, std::uint32_t index) {
+  return (tag << 32) | index;
+}
+
+static std::error_code lastError() {
+  return std::make_error_code(std::errc{errno});
+}
+
+static int ioUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                        unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+static int ioUringRegister(int fd, unsigned opcode, const void *arg,
+                           unsigned count) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+static bool isSocket(int fd) {
+  struct stat info;
+  return ::fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+}
+
+static void *mapAnonymous(std::size_t size) {
+  void *result = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return result == MAP_FAILED ? nullptr : result;
+}
+
+IoUringTransport::~IoUringTransport() {
+  if (mRingFd >= 0 && mSqes != nullptr) {
+    std::unique_lock lock(mMutex);
+
+    // let queued frames reach the peer, then cancel pending receive
+    while ((mSend[0].inFlight || mSend[1].inFlight ||
+            mSend[mCurrentSend].size > 0) &&
+           !mSendFailed) {
+      if (!mSend[0].inFlight && !mSend[1].inFlight) {
+        submitSend(mCurrentSend);
+        mCurrentSend ^= 1;
+      }
+
+      waitCompletions(lock);
+    }
+
+    mEof = true;
+
+    if (mRecvPending) {
+      auto sqe = prepareSqe();
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->addr = mRecvUserData;
+      sqe->user_data = makeUserData(kCancelTag, 0);
+      commitSqe();
+
+      while (mRecvPending) {
+        waitCompletions(lock);
+      }
+    }
+  }
+
+  if (mRingFd >= 0) {
+    ::close(mRingFd);
+  }
+
+  if (mBufRing != nullptr) {
+    ::munmap(mBufRing, mBufRingSize);
+  }
+
+  if (mBuffers != nullptr) {
+    ::munmap(mBuffers, mBuffersSize);
+  }
+
+  if (mSqes != nullptr) {
+    ::munmap(mSqes, mSqesSize);
+  }
+
+  if (mRingMapping != nullptr) {
+    ::munmap(mRingMapping, mRingMappingSize);
+  }
+}
+
+std::expected<std::unique_ptr<IoUringTransport>, std::error_code>
+IoUringTransport::create(int inputFd, int outputFd, std::size_t bufferSize) {
+  if (inputFd < 0 || outputFd < 0 || bufferSize == 0 ||
+      bufferSize > (1u << 30)) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  std::unique_ptr<IoUringTransport> result(new IoUringTransport());
+  auto &transport = *result;
+
+  io_uring_params params{};
+  transport.mRingFd = ioUringSetup(kQueueDepth, &params);
+  if (transport.mRingFd < 0) {
+    return std::unexpected(lastError());
+  }
+
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 ||
+      (params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+    return std::unexpected(
+        std::make_error_code(std::errc::function_not_supported));
+  }
+
+  transport.mRingMappingSize =
+      std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+  void *ring = ::mmap(nullptr, transport.mRingMappingSize,
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      transport.mRingFd, IORING_OFF_SQ_RING);
+  if (ring == MAP_FAILED) {
+    return std::unexpected(lastError());
+  }
+
+  transport.mRingMapping = ring;
+
+  transport.mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = ::mmap(nullptr, transport.mSqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, transport.mRingFd,
+                      IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return std::unexpected(lastError());
+  }
+
+  transport.mSqes = static_cast<io_uring_sqe *>(sqes);
+
+  auto field = [ring](std::uint32_t offset) {
+    return reinterpret_cast<unsigned *>(static_cast<std::byte *>(ring) +
+                                        offset);
+  };
+
+  transport.mSqHead = field(params.sq_off.head);
+  transport.mSqTail = field(params.sq_off.tail);
+  transport.mSqArray = field(params.sq_off.array);
+  transport.mSqMask = *field(params.sq_off.ring_mask);
+  transport.mSqEntries = params.sq_entries;
+  transport.mCqHead = field(params.cq_off.head);
+  transport.mCqTail = field(params.cq_off.tail);
+  transport.mCqes = reinterpret_cast<io_uring_cqe *>(field(params.cq_off.cqes));
+  transport.mCqMask = *field(params.cq_off.ring_mask);
+
+  int files[] = {inputFd, outputFd};
+  if (ioUringRegister(transport.mRingFd, IORING_REGISTER_FILES, files,
+                      std::size(files)) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  // two send buffers followed by receive buffers
+  constexpr unsigned kBufferCount = 2 + kRecvBufferCount;
+  transport.mBufferSize = bufferSize;
+  transport.mBuffersSize = bufferSize * kBufferCount;
+  transport.mBuffers = mapAnonymous(transport.mBuffersSize);
+  if (transport.mBuffers == nullptr) {
+    return std::unexpected(lastError());
+  }
+
+  auto buffers = static_cast<std::byte *>(transport.mBuffers);
+  iovec iov[kBufferCount];
+  for (unsigned i = 0; i < kBufferCount; ++i) {
+    iov[i] = {.iov_base = buffers + i * bufferSize, .iov_len = bufferSize};
+  }
+
+  if (ioUringRegister(transport.mRingFd, IORING_REGISTER_BUFFERS, iov,
+                      kBufferCount) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  transport.mSend[0].data = buffers;
+  transport.mSend[1].data = buffers + bufferSize;
+  transport.mRecvBase = buffers + 2 * bufferSize;
+  transport.mOutputIsSocket = isSocket(outputFd);
+
+  if (isSocket(inputFd)) {
+    // multishot receive needs provided buffer ring, available since 6.0
+    transport.mBufRingSize = kRecvBufferCount * sizeof(io_uring_buf);
+    transport.mBufRing = mapAnonymous(transport.mBufRingSize);
+
+    if (transport.mBufRing != nullptr) {
+      io_uring_buf_reg registration{};
+      registration.ring_addr = reinterpret_cast<std::uint64_t>(
+          transport.mBufRing);
+      registration.ring_entries = kRecvBufferCount;
+      registration.bgid = kBufferGroup;
+
+      transport.mMultishot =
+          ioUringRegister(transport.mRingFd, IORING_REGISTER_PBUF_RING,
+                          &registration, 1) == 0;
+
+      if (!transport.mMultishot) {
+        ::munmap(transport.mBufRing, transport.mBufRingSize);
+        transport.mBufRing = nullptr;
+      }
+    }
+  }
+
+  for (std::uint16_t id = 0; id < kRecvBufferCount; ++id) {
+    transport.recycleRecvBuffer(id);
+  }
+
+  std::lock_guard lock(transport.mMutex);
+  transport.submitRecv();
+  transport.flushSubmissions();
+  return result;
+}
+
+void IoUringTransport::write(std::span<const std::byte> bytes) {
+  writev({&bytes, 1});
+}
+
+void IoUringTransport::writev(
+    std::span<const std::span<const std::byte>> buffers) {
+  std::unique_lock lock(mMutex);
+
+  for (auto buffer : buffers) {
+    while (!buffer.empty() && !mSendFailed) {
+      auto &send = mSend[mCurrentSend];
+
+      if (send.inFlight || send.size == mBufferSize) {
+        waitCompletions(lock);
+        continue;
+      }
+
+      auto count = std::min(buffer.size(), mBufferSize - send.size);
+      std::memcpy(send.data + send.size, buffer.data(), count);
+      send.size += count;
+      buffer = buffer.subspan(count);
+
+      // only one send is in flight to keep stream ordered, next buffer is
+      // submitted on completion
+      if (send.size == mBufferSize && !mSend[mCurrentSend ^ 1].inFlight) {
+        submitSend(mCurrentSend);
+        mCurrentSend ^= 1;
+      }
+    }
+  }
+
+  if (mSend[mCurrentSend].size > 0 && !mSend[0].inFlight &&
+      !mSend[1].inFlight) {
+    submitSend(mCurrentSend);
+    mCurrentSend ^= 1;
+  }
+
+  flushSubmissions();
+}
+
+void IoUringTransport::read(std::span<std::byte> &bytes) {
+  std::unique_lock lock(mMutex);
+
+  while (mRecvChunks.empty()) {
+    if (mEof) {
+      bytes = bytes.subspan(0, 0);
+      return;
+    }
+
+    submitRecv();
+    waitCompletions(lock);
+  }
+
+  auto &chunk = mRecvChunks.front();
+  auto count = std::min<std::size_t>(bytes.size(), chunk.size - mRecvOffset);
+  std::memcpy(bytes.data(),
+              mRecvBase + chunk.bufferId * mBufferSize + mRecvOffset, count);
+  bytes = bytes.subspan(0, count);
+  mRecvOffset += count;
+
+  if (mRecvOffset == chunk.size) {
+    auto id = chunk.bufferId;
+    mRecvChunks.pop_front();
+    mRecvOffset = 0;
+    recycleRecvBuffer(id);
+    submitRecv();
+  }
+}
+
+io_uring_sqe *IoUringTransport::prepareSqe() {
+  unsigned tail = *mSqTail;
+  unsigned head = std::atomic_ref(*mSqHead).load(std::memory_order::acquire);
+
+  if (tail - head >= mSqEntries) {
+    flushSubmissions();
+  }
+
+  unsigned index = tail & mSqMask;
+  auto sqe = mSqes + index;
+  std::memset(sqe, 0, sizeof(*sqe));
+  mSqArray[index] = index;
+  return sqe;
+}
+
+void IoUringTransport::commitSqe() {
+  std::atomic_ref(*mSqTail).store(*mSqTail + 1, std::memory_order::release);
+  ++mPendingSubmissions;
+}
+
+void IoUringTransport::flushSubmissions() {
+  while (mPendingSubmissions > 0) {
+    int result = ioUringEnter(mRingFd, mPendingSubmissions, 0, 0);
+
+    if (result < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+
+      return;
+    }
+
+    mPendingSubmissions -= std::min<unsigned>(result, mPendingSubmissions);
+  }
+}
+
+void IoUringTransport::submitRecv() {
+  if (mRecvPending || mEof) {
+    return;
+  }
+
+  if (mMultishot ? mRecvChunks.size() >= kRecvBufferCount
+                 : mFreeRecvBuffers.empty()) {
+    return;
+  }
+
+  auto sqe = prepareSqe();
+  sqe->fd = kInputFile;
+  sqe->flags = IOSQE_FIXED_FILE;
+
+  if (mMultishot) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    mRecvUserData = makeUserData(kRecvTag, 0);
+  } else {
+    auto id = mFreeRecvBuffers.back();
+    mFreeRecvBuffers.pop_back();
+
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->addr = reinterpret_cast<std::uint64_t>(mRecvBase + id * mBufferSize);
+    sqe->len = mBufferSize;
+    sqe->off = ~std::uint64_t(0);
+    sqe->buf_index = 2 + id;
+    mRecvUserData = makeUserData(kRecvTag, id);
+  }
+
+  sqe->user_data = mRecvUserData;
+  commitSqe();
+  mRecvPending = true;
+}
+
+void IoUringTransport::submitSend(unsigned index) {
+  auto &send = mSend[index];
+  auto sqe = prepareSqe();
+  sqe->fd = kOutputFile;
+  sqe->flags = IOSQE_FIXED_FILE;
+  sqe->addr = reinterpret_cast<std::uint64_t>(send.data + send.offset);
+  sqe->len = send.size - send.offset;
+
+  if (mOutputIsSocket) {
+    sqe->opcode = IORING_OP_SEND;
+    sqe->msg_flags = MSG_NOSIGNAL;
+  } else {
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->off = ~std::uint64_t(0);
+    sqe->buf_index = index;
+  }
+
+  sqe->user_data = makeUserData(kSendTag, index);
+  commitSqe();
+  send.inFlight = true;
+}
+
+void IoUringTransport::waitCompletions(std::unique_lock<std::mutex> &lock) {
+  if (reapCompletions()) {
+    flushSubmissions();
+    mCv.notify_all();
+    return;
+  }
+
+  // other thread sleeps in the kernel, it reaps completions for both
+  if (mWaiting) {
+    flushSubmissions();
+    mCv.wait(lock);
+    return;
+  }
+
+  mWaiting = true;
+  unsigned toSubmit = std::exchange(mPendingSubmissions, 0);
+  lock.unlock();
+
+  int result = ioUringEnter(mRingFd, toSubmit, 1, IORING_ENTER_GETEVENTS);
+
+  lock.lock();
+  mWaiting = false;
+
+  if (result < 0) {
+    mPendingSubmissions += toSubmit;
+  } else if (unsigned(result) < toSubmit) {
+    mPendingSubmissions += toSubmit - result;
+  }
+
+  reapCompletions();
+  flushSubmissions();
+  mCv.notify_all();
+}
+
+bool IoUringTransport::reapCompletions() {
+  unsigned head = *mCqHead;
+  unsigned tail = std::atomic_ref(*mCqTail).load(std::memory_order::acquire);
+
+  if (head == tail) {
+    return false;
+  }
+
+  for (; head != tail; ++head) {
+    handleCompletion(mCqes[head & mCqMask]);
+  }
+
+  std::atomic_ref(*mCqHead).store(head, std::memory_order::release);
+  return true;
+}
+
+void IoUringTransport::handleCompletion(const io_uring_cqe &cqe) {
+  auto index = static_cast<std::uint32_t>(cqe.user_data);
+
+  switch (cqe.user_data >> 32) {
+  case kRecvTag: {
+    if (!mMultishot || (cqe.flags & IORING_CQE_F_MORE) == 0) {
+      mRecvPending = false;
+    }
+
+    std::uint16_t id = mMultishot ? cqe.flags >> IORING_CQE_BUFFER_SHIFT
+                                  : static_cast<std::uint16_t>(index);
+
+    if (cqe.res > 0) {
+      mRecvChunks.push_back({.bufferId = id,
+                             .size = static_cast<std::uint32_t>(cqe.res)});
+    } else {
+      if (!mMultishot || (cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+        recycleRecvBuffer(id);
+      }
+
+      // multishot receive stops when it runs out of buffers, it is rearmed
+      // after consumer returns them
+      if (cqe.res != -ENOBUFS && cqe.res != -EINTR && cqe.res != -EAGAIN) {
+        mEof = true;
+      }
+    }
+
+    submitRecv();
+    break;
+  }
+
+  case kSendTag: {
+    auto &send = mSend[index & 1];
+
+    if (cqe.res > 0) {
+      send.offset += cqe.res;
+    } else if (cqe.res != -EINTR && cqe.res != -EAGAIN) {
+      mSendFailed = true;
+    }
+
+    if (!mSendFailed && send.offset < send.size) {
+      submitSend(index & 1);
+      break;
+    }
+
+    send.size = 0;
+    send.offset = 0;
+    send.inFlight = false;
+
+    auto &next = mSend[(index & 1) ^ 1];
+    if (!mSendFailed && next.size > 0 && !next.inFlight) {
+      submitSend((index & 1) ^ 1);
+      mCurrentSend = index & 1;
+    }
+    break;
+  }
+  }
+}
+
+void IoUringTransport::recycleRecvBuffer(std::uint16_t id) {
+  if (!mMultishot) {
+    mFreeRecvBuffers.push_back(id);
+    return;
+  }
+
+  // entries are indexed directly, in C++ flexible array member of
+  // io_uring_buf_ring is placed after empty struct and gets wrong offset
+  auto ring = static_cast<io_uring_buf_ring *>(mBufRing);
+  auto entries = static_cast<io_uring_buf *>(mBufRing);
+  auto &buffer = entries[mBufRingTail & (kRecvBufferCount - 1)];
+  buffer.addr = reinterpret_cast<std::uint64_t>(mRecvBase + id * mBufferSize);
+  buffer.len = mBufferSize;
+  buffer.bid = id;
+  ++mBufRingTail;
+  std::atomic_ref(ring->tail).store(mBufRingTail, std::memory_order::release);
+}
+#else
+IoUringTransport::~IoUringTransport() = default;
+
+std::expected<std::unique_ptr<IoUringTransport>, std::error_code>
+IoUringTransport::create(int, int, std::size_t) {
+  return std::unexpected(
+      std::make_error_code(std::errc::function_not_supported));
+}
+
+void IoUringTransport::write(std::span<const std::byte>) {}
+void IoUringTransport::writev(std::span<const std::span<const std::byte>>) {}
+void IoUringTransport::read(std::span<std::byte> &bytes) {
+  bytes = bytes.subspan(0, 0);
+}
+#endif
@@ -0,0 +1,637 @@
+#include "rpcsx/ui/JsonReader.hpp"
+#include "rpcsx/ui/JsonScanner.hpp"
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+using namespace rpcsx::ui;
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+static std::optional<std::uint32_t> parseHex4(std::string_view text) {
+  std::uint32_t result = 0;
+  if (text.size() < 4) {
+    return std::nullopt;
+  }
+
+  auto [end, ec] = std::from_chars(text.data(), text.data() + 4, result, 16);
+  if (ec != std::errc{} || end != text.data() + 4) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+static void appendUtf8(std::string &result, std::uint32_t codePoint) {
+  if (codePoint < 0x80) {
+    result.push_back(static_cast<char>(codePoint));
+  } else if (codePoint < 0x800) {
+    result.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+    result.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+  } else if (codePoint < 0x10000) {
+    result.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+    result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+    result.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+  } else {
+    result.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+    result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+    result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+    result.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+  }
+}
+
+JsonReader::Kind JsonReader::peek() {
+  if (mDom) {
+    if (mNext == nullptr) {
+      return Kind::Invalid;
+    }
+
+    switch (mNext->type()) {
+    case nlohmann::json::value_t::null:
+      return Kind::Null;
+    case nlohmann::json::value_t::boolean:
+      return Kind::Boolean;
+    case nlohmann::json::value_t::number_integer:
+    case nlohmann::json::value_t::number_unsigned:
+    case nlohmann::json::value_t::number_float:
+      return Kind::Number;
+    case nlohmann::json::value_t::string:
+      return Kind::String;
+    case nlohmann::json::value_t::array:
+      return Kind::Array;
+    case nlohmann::json::value_t::object:
+      return Kind::Object;
+    default:
+      return Kind::Invalid;
+    }
+  }
+
+  skipSpace();
+
+  if (mPos >= mText.size()) {
+    return Kind::Invalid;
+  }
+
+  switch (mText[mPos]) {
+  case 'n':
+    return Kind::Null;
+  case 't':
+  case 'f':
+    return Kind::Boolean;
+  case '"':
+    return Kind::String;
+  case '[':
+    return Kind::Array;
+  case '{':
+    return Kind::Object;
+  case '-':
+    return Kind::Number;
+  default:
+    return isDigit(mText[mPos]) ? Kind::Number : Kind::Invalid;
+  }
+}
+
+bool JsonReader::readNull() {
+  if (mDom) {
+    return takeValue(Kind::Null) != nullptr;
+  }
+
+  auto kind = peek();
+  if (kind != Kind::Null) {
+    return fail(kind == Kind::Invalid ? Error::Syntax : Error::Type);
+  }
+
+  return readLiteral("null");
+}
+
+bool JsonReader::readBool(bool &value) {
+  if (mDom) {
+    auto node = takeValue(Kind::Boolean);
+    if (node == nullptr) {
+      return false;
+    }
+
+    value = node->get<bool>();
+    return true;
+  }
+
+  auto kind = peek();
+  if (kind != Kind::Boolean) {
+    return fail(kind == Kind::Invalid ? Error::Syntax : Error::Type);
+  }
+
+  value = mText[mPos] == 't';
+  return readLiteral(value ? "true" : "false");
+}
+
+bool JsonReader::readInteger(std::int64_t &value) {
+  if (mDom) {
+    auto node = takeValue(Kind::Number);
+    if (node == nullptr) {
+      return false;
+    }
+
+    if (node->is_number_integer() && !node->is_number_unsigned()) {
+      value = node->get<std::int64_t>();
+      return true;
+    }
+
+    if (node->is_number_unsigned()) {
+      auto number = node->get<std::uint64_t>();
+      if (number > static_cast<std::uint64_t>(
+                         std::numeric_limits<std::int64_t>::max())) {
+        return fail(Error::Type);
+      }
+
+      value = static_cast<std::int64_t>(number);
+      return true;
+    }
+
+    // fractions are truncated like for text
+    auto number = node->get<double>();
+    if (!(number >= -0x1p63) || !(number < 0x1p63)) {
+      return fail(Error::Type);
+    }
+
+    value = static_cast<std::int64_t>(number);
+    return true;
+  }
+
+  auto kind = peek();
+  if (kind != Kind::Number) {
+    return fail(kind == Kind::Invalid ? Error::Syntax : Error::Type);
+  }
+
+  std::string_view text;
+  if (!scanNumber(text)) {
+    return false;
+  }
+
+  auto begin = text.data();
+  auto end = text.data() + text.size();
+
+  if (auto [ptr, ec] = std::from_chars(begin, end, value);
+      ec == std::errc{} && ptr == end) {
+    return true;
+  }
+
+  // fractions are truncated like DOM conversion does
+  double number;
+  if (auto [ptr, ec] = std::from_chars(begin, end, number);
+      ec != std::errc{} || ptr != end || !(number >= -0x1p63) ||
+      !(number < 0x1p63)) {
+    return fail(Error::Type);
+  }
+
+  value = static_cast<std::int64_t>(number);
+  return true;
+}
+
+bool JsonReader::readString(std::string &value) {
+  if (mDom) {
+    auto node = takeValue(Kind::String);
+    if (node == nullptr) {
+      return false;
+    }
+
+    value = node->get_ref<const std::string &>();
+    return true;
+  }
+
+  auto kind = peek();
+  if (kind != Kind::String) {
+    return fail(kind == Kind::Invalid ? Error::Syntax : Error::Type);
+  }
+
+  value.clear();
+  return scanString(&value);
+}
+
+bool JsonReader::readRaw(std::string_view &value) {
+  if (mDom) {
+    auto node = takeValue(peek());
+    if (node == nullptr) {
+      return false;
+    }
+
+    mRaw = toJsonText(*node);
+    value = mRaw;
+    return true;
+  }
+
+  skipSpace();
+  auto begin = mPos;
+
+  if (!skip()) {
+    return false;
+  }
+
+  value = mText.substr(begin, mPos - begin);
+  return true;
+}
+
+bool JsonReader::readJson(nlohmann::json &value) {
+  if (mDom) {
+    auto node = takeValue(peek());
+    if (node == nullptr) {
+      return false;
+    }
+
+    value = nlohmann::json(*node);
+    return true;
+  }
+
+  std::string_view text;
+  if (!readRaw(text)) {
+    return false;
+  }
+
+  value = nlohmann::json::parse(text, nullptr, false);
+  return !value.is_discarded() || fail(Error::Syntax);
+}
+
+bool JsonReader::skip() {
+  if (mDom) {
+    return takeValue(peek()) != nullptr;
+  }
+
+  switch (peek()) {
+  case Kind::Null:
+    return readNull();
+
+  case Kind::Boolean: {
+    bool value;
+    return readBool(value);
+  }
+
+  case Kind::Number: {
+    std::string_view value;
+    return scanNumber(value);
+  }
+
+  case Kind::String:
+    return scanString(nullptr);
+
+  case Kind::Array:
+    return readArray([this] { return skip(); });
+
+  case Kind::Object:
+    return readObject([this](std::string_view) { return skip(); });
+
+  case Kind::Invalid:
+    break;
+  }
+
+  return fail(Error::Syntax);
+}
+
+bool JsonReader::require(bool found) { return found || fail(Error::Type); }
+
+bool JsonReader::finish() {
+  if (mDom) {
+    return mError == Error::None;
+  }
+
+  skipSpace();
+  return mPos == mText.size() || fail(Error::Syntax);
+}
+
+bool JsonReader::fail(Error error) {
+  if (mError == Error::None) {
+    mError = error;
+  }
+
+  return false;
+}
+
+const ArenaJson *JsonReader::takeValue(Kind kind) {
+  auto actual = peek();
+  if (actual == Kind::Invalid) {
+    fail(Error::Syntax);
+    return nullptr;
+  }
+
+  if (actual != kind) {
+    fail(Error::Type);
+    return nullptr;
+  }
+
+  return std::exchange(mNext, nullptr);
+}
+
+bool JsonReader::enter(char open) {
+  auto kind = peek();
+
+  if (kind == Kind::Invalid) {
+    return fail(Error::Syntax);
+  }
+
+  if (mText[mPos] != open) {
+    return fail(Error::Type);
+  }
+
+  if (mDepth >= kMaxDepth) {
+    return fail(Error::Syntax);
+  }
+
+  mPos++;
+  mDepth++;
+  return true;
+}
+
+bool JsonReader::nextMember(std::string_view &key, bool &first) {
+  skipSpace();
+
+  if (mPos >= mText.size()) {
+    return fail(Error::Syntax);
+  }
+
+  if (mText[mPos] == '}') {
+    mPos++;
+    return false;
+  }
+
+  if (!first) {
+    if (mText[mPos] != ',') {
+      return fail(Error::Syntax);
+    }
+
+    mPos++;
+    skipSpace();
+  }
+
+  first = false;
+
+  if (!readKey(key)) {
+    return false;
+  }
+
+  skipSpace();
+  if (mPos >= mText.size() || mText[mPos] != ':') {
+    return fail(Error::Syntax);
+  }
+
+  mPos++;
+  return true;
+}
+
+bool JsonReader::nextItem(bool &first) {
+  skipSpace();
+
+  if (mPos >= mText.size()) {
+    return fail(Error::Syntax);
+  }
+
+  if (mText[mPos] == ']') {
+    mPos++;
+    return false;
+  }
+
+  if (!first) {
+    if (mText[mPos] != ',') {
+      return fail(Error::Syntax);
+    }
+
+    mPos++;
+  }
+
+  first = false;
+  return true;
+}
+
+bool JsonReader::readKey(std::string_view &key) {
+  if (mPos >= mText.size() || mText[mPos] != '"') {
+    return fail(Error::Syntax);
+  }
+
+  // ASCII keys without escapes are referenced in place
+  auto end = mPos + 1;
+  while (end < mText.size() && mText[end] != '"' && mText[end] != '\\' &&
+         static_cast<unsigned char>(mText[end]) >= 0x20 &&
+         static_cast<unsigned char>(mText[end]) < 0x80) {
+    end++;
+  }
+
+  if (end < mText.size() && mText[end] == '"') {
+    key = mText.substr(mPos + 1, end - mPos - 1);
+    mPos = end + 1;
+    return true;
+  }
+
+  mKey.clear();
+  if (!scanString(&mKey)) {
+    return false;
+  }
+
+  key = mKey;
+  return true;
+}
+
+// mPos is at opening quote
+bool JsonReader::scanString(std::string *value) {
+  mPos++;
+
+  while (true) {
+    auto run = mPos;
+    while (mPos < mText.size()) {
+      auto c = static_cast<unsigned char>(mText[mPos]);
+      if (c == '"' || c == '\\' || c < 0x20) {
+        break;
+      }
+
+      auto length = c < 0x80 ? 1 : getUtf8Length(mText.substr(mPos));
+      if (length == 0) {
+        return fail(Error::Syntax);
+      }
+
+      mPos += length;
+    }
+
+    if (value != nullptr) {
+      value->append(mText.substr(run, mPos - run));
+    }
+
+    if (mPos >= mText.size() || mText[mPos] != '\\') {
+      break;
+    }
+
+    if (++mPos >= mText.size()) {
+      break;
+    }
+
+    char c = mText[mPos++];
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      break;
+    case 'b':
+      c = '\b';
+      break;
+    case 'f':
+      c = '\f';
+      break;
+    case 'n':
+      c = '\n';
+      break;
+    case 'r':
+      c = '\r';
+      break;
+    case 't':
+      c = '\t';
+      break;
+
+    case 'u': {
+      auto codePoint = parseHex4(mText.substr(mPos));
+      if (!codePoint || (*codePoint >= 0xdc00 && *codePoint < 0xe000)) {
+        return fail(Error::Syntax);
+      }
+
+      mPos += 4;
+
+      if (*codePoint >= 0xd800 && *codePoint < 0xdc00) {
+        auto low = mText.substr(mPos).starts_with("\\u")
+                       ? parseHex4(mText.substr(mPos + 2))
+                       : std::nullopt;
+
+        if (!low || *low < 0xdc00 || *low >= 0xe000) {
+          return fail(Error::Syntax);
+        }
+
+        mPos += 6;
+        *codePoint = 0x10000 + ((*codePoint - 0xd800) << 10) + (*low - 0xdc00);
+      }
+
+      if (value != nullptr) {
+        appendUtf8(*value, *codePoint);
+      }
+      continue;
+    }
+
+    default:
+      return fail(Error::Syntax);
+    }
+
+    if (value != nullptr) {
+      value->push_back(c);
+    }
+  }
+
+  if (mPos >= mText.size() || mText[mPos] != '"') {
+    return fail(Error::Syntax);
+  }
+
+  mPos++;
+  return true;
+}
+
+bool JsonReader::scanNumber(std::string_view &value) {
+  auto begin = mPos;
+  auto digits = [this] {
+    auto start = mPos;
+    while (mPos < mText.size() && isDigit(mText[mPos])) {
+      mPos++;
+    }
+    return mPos - start;
+  };
+
+  if (mPos < mText.size() && mText[mPos] == '-') {
+    mPos++;
+  }
+
+  if (mPos < mText.size() && mText[mPos] == '0') {
+    mPos++;
+  } else if (digits() == 0) {
+    return fail(Error::Syntax);
+  }
+
+  bool isInteger = true;
+  bool negativeExponent = false;
+
+  if (mPos < mText.size() && mText[mPos] == '.') {
+    mPos++;
+    isInteger = false;
+
+    if (digits() == 0) {
+      return fail(Error::Syntax);
+    }
+  }
+
+  if (mPos < mText.size() && (mText[mPos] == 'e' || mText[mPos] == 'E')) {
+    mPos++;
+    isInteger = false;
+
+    if (mPos < mText.size() && (mText[mPos] == '+' || mText[mPos] == '-')) {
+      negativeExponent = mText[mPos] == '-';
+      mPos++;
+    }
+
+    if (digits() == 0) {
+      return fail(Error::Syntax);
+    }
+  }
+
+  value = mText.substr(begin, mPos - begin);
+
+  // like DOM parser, reject numbers that overflow double
+  if (!isInteger && !negativeExponent) {
+    double number;
+    auto [ptr, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc{}) {
+      return fail(Error::Syntax);
+    }
+  }
+
+  return true;
+}
+
+bool JsonReader::readLiteral(std::string_view literal) {
+  if (!mText.substr(mPos).starts_with(literal)) {
+    return fail(Error::Syntax);
+  }
+
+  mPos += literal.size();
+  return true;
+}
+
+void JsonReader::skipSpace() {
+  while (mPos < mText.size() &&
+         (mText[mPos] == ' ' || mText[mPos] == '\t' || mText[mPos] == '\n' ||
+          mText[mPos] == '\r')) {
+    mPos++;
+  }
+}
+
+bool rpcsx::ui::read_json(JsonReader &reader, nlohmann::json &value) {
+  return reader.readJson(value);
+}
+
+bool rpcsx::ui::read_json(JsonReader &reader, nlohmann::json::object_t &value) {
+  if (reader.peek() != JsonReader::Kind::Object) {
+    return reader.fail(JsonReader::Error::Type);
+  }
+
+  nlohmann::json object;
+  if (!read_json(reader, object)) {
+    return false;
+  }
+
+  value = std::move(object.get_ref<nlohmann::json::object_t &>());
+  return true;
+}
+
+bool rpcsx::ui::read_json(JsonReader &reader, nlohmann::json::array_t &value) {
+  if (reader.peek() != JsonReader::Kind::Array) {
+    return reader.fail(JsonReader::Error::Type);
+  }
+
+  nlohmann::json array;
+  if (!read_json(reader, array)) {
+    return false;
+  }
+
+  value = std::move(array.get_ref<nlohmann::json::array_t &>());
+  return true;
+}
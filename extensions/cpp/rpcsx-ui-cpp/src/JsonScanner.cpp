@@ -0,0 +1,219 @@
+#include "rpcsx/ui/JsonScanner.hpp"
+#include <charconv>
+
+using namespace rpcsx::ui;
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static std::size_t skipSpace(std::string_view text, std::size_t pos) {
+  while (pos < text.size() && isSpace(text[pos])) {
+    pos++;
+  }
+
+  return pos;
+}
+
+// pos is at opening quote, returns position after closing quote
+static std::optional<std::size_t>
+skipString(std::string_view text, std::size_t pos, bool *escaped = nullptr) {
+  for (pos++; pos < text.size(); pos++) {
+    if (text[pos] == '"') {
+      return pos + 1;
+    }
+
+    if (text[pos] == '\\') {
+      if (escaped != nullptr) {
+        *escaped = true;
+      }
+
+      pos++;
+    }
+  }
+
+  return std::nullopt;
+}
+
+static std::optional<std::size_t> skipValue(std::string_view text,
+                                            std::size_t pos) {
+  if (pos >= text.size()) {
+    return std::nullopt;
+  }
+
+  if (text[pos] == '"') {
+    return skipString(text, pos);
+  }
+
+  if (text[pos] != '{' && text[pos] != '[') {
+    auto begin = pos;
+    while (pos < text.size() && !isSpace(text[pos]) && text[pos] != ',' &&
+           text[pos] != '}' && text[pos] != ']') {
+      pos++;
+    }
+
+    if (pos == begin) {
+      return std::nullopt;
+    }
+
+    return pos;
+  }
+
+  std::size_t depth = 0;
+
+  while (pos < text.size()) {
+    switch (text[pos]) {
+    case '"':
+      if (auto end = skipString(text, pos)) {
+        pos = *end;
+        continue;
+      }
+      return std::nullopt;
+
+    case '{':
+    case '[':
+      depth++;
+      break;
+
+    case '}':
+    case ']':
+      if (--depth == 0) {
+        return pos + 1;
+      }
+      break;
+    }
+
+    pos++;
+  }
+
+  return std::nullopt;
+}
+
+bool rpcsx::ui::scanJsonObject(std::string_view text,
+                               std::vector<JsonMember> &members) {
+  members.clear();
+
+  auto pos = skipSpace(text, 0);
+  if (pos >= text.size() || text[pos] != '{') {
+    return false;
+  }
+
+  pos = skipSpace(text, pos + 1);
+  if (pos < text.size() && text[pos] == '}') {
+    return skipSpace(text, pos + 1) == text.size();
+  }
+
+  while (pos < text.size()) {
+    if (text[pos] != '"') {
+      return false;
+    }
+
+    JsonMember member;
+    auto keyEnd = skipString(text, pos, &member.escapedKey);
+    if (!keyEnd) {
+      return false;
+    }
+
+    member.key = text.substr(pos + 1, *keyEnd - pos - 2);
+
+    pos = skipSpace(text, *keyEnd);
+    if (pos >= text.size() || text[pos] != ':') {
+      return false;
+    }
+
+    pos = skipSpace(text, pos + 1);
+    auto valueEnd = skipValue(text, pos);
+    if (!valueEnd) {
+      return false;
+    }
+
+    member.value = text.substr(pos, *valueEnd - pos);
+    members.push_back(member);
+
+    pos = skipSpace(text, *valueEnd);
+    if (pos >= text.size()) {
+      return false;
+    }
+
+    if (text[pos] == '}') {
+      return skipSpace(text, pos + 1) == text.size();
+    }
+
+    if (text[pos] != ',') {
+      return false;
+    }
+
+    pos = skipSpace(text, pos + 1);
+  }
+
+  return false;
+}
+
+std::optional<std::string_view>
+rpcsx::ui::getJsonString(std::string_view value) {
+  if (value.size() < 2 || value.front() != '"' || value.back() != '"') {
+    return std::nullopt;
+  }
+
+  value = value.substr(1, value.size() - 2);
+
+  if (value.find('\\') != std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  return value;
+}
+
+std::optional<std::uint64_t>
+rpcsx::ui::getJsonUnsigned(std::string_view value) {
+  std::uint64_t result;
+  auto [end, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), result);
+
+  if (ec != std::errc{} || end != value.data() + value.size()) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+bool rpcsx::ui::isJsonNull(std::string_view value) { return value == "null"; }
+
+std::size_t rpcsx::ui::getUtf8Length(std::string_view text) {
+  auto byte = [&](std::size_t index) {
+    return static_cast<unsigned char>(text[index]);
+  };
+
+  std::size_t length;
+  if (byte(0) < 0x80) {
+    return 1;
+  } else if (byte(0) >= 0xc2 && byte(0) <= 0xdf) {
+    length = 2;
+  } else if (byte(0) >= 0xe0 && byte(0) <= 0xef) {
+    length = 3;
+  } else if (byte(0) >= 0xf0 && byte(0) <= 0xf4) {
+    length = 4;
+  } else {
+    return 0;
+  }
+
+  if (text.size() < length) {
+    return 0;
+  }
+
+  for (std::size_t i = 1; i < length; ++i) {
+    if ((byte(i) & 0xc0) != 0x80) {
+      return 0;
+    }
+  }
+
+  // overlong forms, surrogates and code points past U+10FFFF
+  if ((byte(0) == 0xe0 && byte(1) < 0xa0) ||
+      (byte(0) == 0xed && byte(1) > 0x9f) ||
+      (byte(0) == 0xf0 && byte(1) < 0x90) ||
+      (byte(0) == 0xf4 && byte(1) > 0x8f)) {
+    return 0;
+  }
+
+  return length;
+}
@@ -0,0 +1,222 @@
+#include "rpcsx/ui/JsonWriter.hpp"
+#include "rpcsx/ui/JsonScanner.hpp"
+#include <charconv>
+#include <memory>
+
+using namespace rpcsx::ui;
+
+// nlohmann has no public way to dump into existing buffer, its serializer is
+// used directly here and nowhere else. It is internal API, check it again
+// when the library is updated
+static_assert(NLOHMANN_JSON_VERSION_MAJOR == 3 &&
+                  NLOHMANN_JSON_VERSION_MINOR == 11 &&
+                  NLOHMANN_JSON_VERSION_PATCH == 3,
+              "appendJsonText() depends on nlohmann::detail::serializer");
+
+namespace {
+// Serializer of each thread is kept and pointed to output of each call
+struct OutputTarget : nlohmann::detail::output_adapter_protocol<char> {
+  std::string *output = nullptr;
+
+  void write_character(char c) override { output->push_back(c); }
+  void write_characters(const char *s, std::size_t length) override {
+    output->append(s, length);
+  }
+};
+} // namespace
+
+template <typename BasicJson>
+static void appendText(std::string &output, const BasicJson &value) {
+  thread_local auto target = std::make_shared<OutputTarget>();
+  thread_local nlohmann::detail::serializer<BasicJson> serializer(
+      target, ' ', nlohmann::json::error_handler_t::replace);
+
+  target->output = &output;
+  serializer.dump(value, false, false, 0);
+}
+
+void rpcsx::ui::appendJsonText(std::string &output,
+                               const nlohmann::json &value) {
+  appendText(output, value);
+}
+
+void rpcsx::ui::appendJsonText(std::string &output, const ArenaJson &value) {
+  appendText(output, value);
+}
+
+void JsonWriter::beginObject() {
+  separate();
+  mBuffer.push_back('{');
+  mNeedComma = false;
+}
+
+void JsonWriter::endObject() {
+  mBuffer.push_back('}');
+  mNeedComma = true;
+}
+
+void JsonWriter::beginArray() {
+  separate();
+  mBuffer.push_back('[');
+  mNeedComma = false;
+}
+
+void JsonWriter::endArray() {
+  mBuffer.push_back(']');
+  mNeedComma = true;
+}
+
+void JsonWriter::key(std::string_view name) {
+  separate();
+  appendString(name);
+  mBuffer.push_back(':');
+  mNeedComma = false;
+}
+
+void JsonWriter::writeNull() {
+  separate();
+  mBuffer += "null";
+  mNeedComma = true;
+}
+
+void JsonWriter::writeBool(bool value) {
+  separate();
+  mBuffer += value ? "true" : "false";
+  mNeedComma = true;
+}
+
+void JsonWriter::writeInteger(std::int64_t value) {
+  separate();
+  char text[24];
+  auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+  mBuffer.append(text, end);
+  mNeedComma = true;
+}
+
+void JsonWriter::writeUnsigned(std::uint64_t value) {
+  separate();
+  char text[24];
+  auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+  mBuffer.append(text, end);
+  mNeedComma = true;
+}
+
+void JsonWriter::writeString(std::string_view value) {
+  separate();
+  appendString(value);
+  mNeedComma = true;
+}
+
+void JsonWriter::writeJson(const nlohmann::json &value) {
+  separate();
+  dump(value);
+  mNeedComma = true;
+}
+
+void JsonWriter::separate() {
+  if (mNeedComma) {
+    mBuffer.push_back(',');
+  }
+}
+
+void JsonWriter::dump(const nlohmann::json &value) {
+  appendJsonText(mBuffer, value);
+}
+
+void JsonWriter::appendString(std::string_view value) {
+  auto start = mBuffer.size();
+  mBuffer.push_back('"');
+
+  if (appendEscaped(value)) {
+    mBuffer.push_back('"');
+    return;
+  }
+
+  // let serializer replace invalid UTF-8 exactly like dump() does
+  mBuffer.resize(start);
+  dump(nlohmann::json(value));
+}
+
+bool JsonWriter::appendEscaped(std::string_view value) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::size_t pos = 0;
+
+  while (pos < value.size()) {
+    // copy runs that need no escaping at once
+    auto run = pos;
+    while (pos < value.size()) {
+      auto c = static_cast<unsigned char>(value[pos]);
+      if (c == '"' || c == '\\' || c < 0x20) {
+        break;
+      }
+
+      auto length = c < 0x80 ? 1 : getUtf8Length(value.substr(pos));
+      if (length == 0) {
+        return false;
+      }
+
+      pos += length;
+    }
+
+    mBuffer.append(value.substr(run, pos - run));
+
+    if (pos >= value.size()) {
+      break;
+    }
+
+    auto c = static_cast<unsigned char>(value[pos++]);
+    switch (c) {
+    case '"':
+      mBuffer += "\\\"";
+      break;
+    case '\\':
+      mBuffer += "\\\\";
+      break;
+    case '\b':
+      mBuffer += "\\b";
+      break;
+    case '\f':
+      mBuffer += "\\f";
+      break;
+    case '\n':
+      mBuffer += "\\n";
+      break;
+    case '\r':
+      mBuffer += "\\r";
+      break;
+    case '\t':
+      mBuffer += "\\t";
+      break;
+    default:
+      mBuffer += "\\u00";
+      mBuffer.push_back(kHex[c >> 4]);
+      mBuffer.push_back(kHex[c & 0xf]);
+      break;
+    }
+  }
+
+  return true;
+}
+
+void rpcsx::ui::write_json(JsonWriter &writer,
+                           const nlohmann::json::object_t &value) {
+  writer.beginObject();
+
+  for (auto &[name, member] : value) {
+    writer.key(name);
+    writer.writeJson(member);
+  }
+
+  writer.endObject();
+}
+
+void rpcsx::ui::write_json(JsonWriter &writer,
+                           const nlohmann::json::array_t &value) {
+  writer.beginArray();
+
+  for (auto &item : value) {
+    writer.writeJson(item);
+  }
+
+  writer.endArray();
+}
@@ -0,0 +1,43 @@
+#include "rpcsx/ui/LoopbackTransport.hpp"
+#include <vector>
+
+using namespace rpcsx::ui;
+
+struct LoopbackTransport::Channel {
+  SpscRingControl forward;
+  SpscRingControl backward;
+  std::vector<std::byte> data;
+};
+
+LoopbackTransport::~LoopbackTransport() { shutdown(); }
+
+std::pair<std::unique_ptr<LoopbackTransport>,
+          std::unique_ptr<LoopbackTransport>>
+LoopbackTransport::createPair(std::size_t ringSize) {
+  auto channel = std::make_shared<Channel>();
+  channel->data.resize(ringSize * 2);
+
+  auto data = channel->data.data();
+  SpscRing forward(&channel->forward, {data, ringSize});
+  SpscRing backward(&channel->backward, {data + ringSize, ringSize});
+
+  return {
+      std::unique_ptr<LoopbackTransport>(
+          new LoopbackTransport(channel, backward, forward)),
+      std::unique_ptr<LoopbackTransport>(
+          new LoopbackTransport(channel, forward, backward)),
+  };
+}
+
+void LoopbackTransport::write(std::span<const std::byte> bytes) {
+  mOutput.write(bytes);
+}
+
+void LoopbackTransport::read(std::span<std::byte> &bytes) {
+  bytes = bytes.subspan(0, mInput.read(bytes));
+}
+
+void LoopbackTransport::shutdown() {
+  mOutput.close();
+  mInput.close();
+}
@@ -0,0 +1,100 @@
+#include "rpcsx/ui/MessageArena.hpp"
+#include "rpcsx/ui/JsonWriter.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+using namespace rpcsx::ui;
+
+static thread_local MessageArena *gCurrentArena = nullptr;
+
+void *MessageArena::allocate(std::size_t size, std::size_t alignment) {
+  if (!mBlocks.empty()) {
+    auto &block = mBlocks.back();
+    void *pointer = block.data.get() + mOffset;
+    std::size_t space = block.size - mOffset;
+
+    if (std::align(alignment, size, pointer, space)) {
+      mOffset = block.size - space + size;
+      return pointer;
+    }
+  }
+
+  // blocks grow geometrically, message that does not fit takes few of them
+  auto blockSize = std::max(kMinBlockSize, std::bit_ceil(size + alignment));
+  if (!mBlocks.empty()) {
+    blockSize = std::max(blockSize, mBlocks.back().size * 2);
+  }
+
+  mBlocks.push_back(
+      {std::make_unique_for_overwrite<std::byte[]>(blockSize), blockSize});
+
+  void *pointer = mBlocks.back().data.get();
+  std::size_t space = blockSize;
+  std::align(alignment, size, pointer, space);
+  mOffset = blockSize - space + size;
+  return pointer;
+}
+
+bool MessageArena::owns(const void *pointer) const {
+  auto address = static_cast<const std::byte *>(pointer);
+  std::less<const std::byte *> less;
+
+  for (auto &block : mBlocks) {
+    if (!less(address, block.data.get()) &&
+        less(address, block.data.get() + block.size)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void MessageArena::reset() {
+#ifndef NDEBUG
+  assert(mLiveAllocations.load(std::memory_order::relaxed) == 0 &&
+         "json value of message outlived its arena");
+#endif
+
+  mOffset = 0;
+
+  auto size = getCapacity();
+  if (size > kMaxRetainedSize) {
+    mBlocks.clear();
+    return;
+  }
+
+  if (mBlocks.size() > 1) {
+    mBlocks.clear();
+    mBlocks.push_back(
+        {std::make_unique_for_overwrite<std::byte[]>(size), size});
+  }
+}
+
+std::size_t MessageArena::getCapacity() const {
+  std::size_t result = 0;
+
+  for (auto &block : mBlocks) {
+    result += block.size;
+  }
+
+  return result;
+}
+
+MessageArena::Scope::Scope(MessageArena &arena)
+    : mPrevious(std::exchange(gCurrentArena, &arena)) {}
+
+MessageArena::Scope::~Scope() { gCurrentArena = mPrevious; }
+
+MessageArena *MessageArena::getCurrent() { return gCurrentArena; }
+
+std::string_view rpcsx::ui::toJsonText(const ArenaJson &value) {
+  thread_local std::string buffer;
+  buffer.clear();
+  appendJsonText(buffer, value);
+  return buffer;
+}
@@ -0,0 +1,126 @@
+#include "rpcsx/ui/OutboundBatcher.hpp"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using namespace rpcsx::ui;
+
+OutboundBatcher::OutboundBatcher(Transport *transport, EventLoop &loop,
+                                 Config config)
+    : mTransport(transport), mLoop(loop), mConfig(config) {
+  mBatch.reserve(mConfig.sizeThreshold * 2);
+  mWriteBuffer.reserve(mConfig.sizeThreshold * 2);
+}
+
+OutboundBatcher::~OutboundBatcher() { write(); }
+
+void OutboundBatcher::push(std::span<const std::byte> frame,
+                           std::span<const int> handles) {
+  bool immediate = mConfig.maxDelay.count() <= 0;
+  bool flushNow = false;
+
+  {
+    std::lock_guard lock(mBatchMutex);
+
+    if (mBatch.empty() && !immediate) {
+      mDeadlineTimer = mLoop.addTimer(
+          EventLoop::Clock::now() + mConfig.maxDelay,
+          [this] { flush(FlushReason::Deadline); });
+    }
+
+    mBatch.insert(mBatch.end(), frame.begin(), frame.end());
+    mBatchHandles.insert(mBatchHandles.end(), handles.begin(), handles.end());
+    mBatchFrames++;
+    flushNow = mBatch.size() >= mConfig.sizeThreshold;
+  }
+
+  if (flushNow) {
+    flush(FlushReason::Size);
+  } else if (immediate) {
+    flush(FlushReason::Deadline);
+  }
+}
+
+void OutboundBatcher::flush(FlushReason reason) {
+  {
+    std::lock_guard lock(mBatchMutex);
+
+    // write is already scheduled, frames pushed until then join it
+    if (mBatch.empty() || mPendingFlush) {
+      return;
+    }
+
+    mPendingFlush = reason;
+  }
+
+  if (mLoop.isLoopThread()) {
+    write();
+  } else {
+    mLoop.post([this] { write(); });
+  }
+}
+
+void OutboundBatcher::write() {
+  std::lock_guard writeLock(mWriteMutex);
+  std::size_t frames = 0;
+  FlushReason reason;
+  EventLoop::TimerId deadlineTimer;
+
+  {
+    std::lock_guard lock(mBatchMutex);
+    reason = mPendingFlush.value_or(FlushReason::Idle);
+    mPendingFlush.reset();
+
+    if (mBatch.empty()) {
+      return;
+    }
+
+    std::swap(mBatch, mWriteBuffer);
+    std::swap(mBatchHandles, mWriteHandles);
+    frames = std::exchange(mBatchFrames, 0);
+    deadlineTimer = std::exchange(mDeadlineTimer, 0);
+  }
+
+  if (deadlineTimer != 0) {
+    mLoop.cancelTimer(deadlineTimer);
+  }
+
+  if (mWriteHandles.empty()) {
+    mTransport->write(mWriteBuffer);
+  } else {
+    std::span<const std::byte> buffer = mWriteBuffer;
+    mTransport->writeWithHandles({&buffer, 1}, mWriteHandles);
+    mWriteHandles.clear();
+  }
+
+  mTransport->flush();
+
+  mStats.sentFrames += frames;
+  mStats.sentBytes += mWriteBuffer.size();
+  mStats.sentBatches++;
+  mStats.batchSizeHistogram[std::min<std::size_t>(
+      std::bit_width(frames) - 1, mStats.batchSizeHistogram.size() - 1)]++;
+
+  switch (reason) {
+  case FlushReason::Size:
+    mStats.flushesBySize++;
+    break;
+  case FlushReason::Idle:
+    mStats.flushesByIdle++;
+    break;
+  case FlushReason::Deadline:
+    mStats.flushesByDeadline++;
+    break;
+  case FlushReason::Call:
+    mStats.flushesByCall++;
+    break;
+  }
+
+  mWriteBuffer.clear();
+}
+
+void OutboundBatcher::collectStats(ProtocolStats &stats) {
+  std::lock_guard writeLock(mWriteMutex);
+
+  stats = mStats;
+}
@@ -0,0 +1,71 @@
+#include "rpcsx/ui/PendingCallTable.hpp"
+#include <atomic>
+
+using namespace rpcsx::ui;
+
+static constexpr std::uint64_t kShardCount = 1u
+                                             << PendingCallTable::kShardBits;
+static constexpr std::uint64_t kMaxSlots = 1u << PendingCallTable::kIndexBits;
+static constexpr std::uint32_t kGenerationMask =
+    (1u << PendingCallTable::kGenerationBits) - 1;
+
+static unsigned getThreadShard() {
+  static std::atomic<unsigned> nextShard{0};
+  thread_local unsigned shard =
+      nextShard.fetch_add(1, std::memory_order::relaxed) % kShardCount;
+  return shard;
+}
+
+std::optional<std::uint64_t> PendingCallTable::add(Handler &&handler) {
+  auto shardIndex = getThreadShard();
+  auto &shard = mShards[shardIndex];
+  std::lock_guard lock(shard.mutex);
+
+  std::uint32_t index;
+
+  if (!shard.freeSlots.empty()) {
+    index = shard.freeSlots.back();
+    shard.freeSlots.pop_back();
+  } else if (shard.slots.size() < kMaxSlots) {
+    index = shard.slots.size();
+    shard.slots.emplace_back();
+  } else {
+    return std::nullopt;
+  }
+
+  auto &slot = shard.slots[index];
+  slot.handler = std::move(handler);
+
+  return (std::uint64_t(slot.generation) << (kShardBits + kIndexBits)) |
+         (std::uint64_t(shardIndex) << kIndexBits) | index;
+}
+
+PendingCallTable::Handler PendingCallTable::take(std::uint64_t id) {
+  std::uint32_t index = id & (kMaxSlots - 1);
+  auto shardIndex = (id >> kIndexBits) & (kShardCount - 1);
+  auto generation = id >> (kShardBits + kIndexBits);
+
+  auto &shard = mShards[shardIndex];
+  std::lock_guard lock(shard.mutex);
+
+  if (index >= shard.slots.size()) {
+    return {};
+  }
+
+  auto &slot = shard.slots[index];
+  if (slot.generation != generation || !slot.handler) {
+    return {};
+  }
+
+  auto handler = std::move(slot.handler);
+  slot.handler = nullptr;
+
+  // generation 0 is never issued, so id is never 0
+  slot.generation = (slot.generation + 1) & kGenerationMask;
+  if (slot.generation == 0) {
+    slot.generation = 1;
+  }
+
+  shard.freeSlots.push_back(index);
+  return handler;
+}
@@ -0,0 +1,546 @@
+#include "rpcsx/ui/SessionRecording.hpp"
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+using namespace rpcsx::ui;
+
+static constexpr std::size_t kHeaderSize = sizeof(SessionRecording::kMagic) + 4;
+static constexpr std::size_t kFileBufferSize = 64 * 1024;
+
+// path::c_str() is wide on Windows
+static std::FILE *openFile(const std::filesystem::path &path, bool write) {
+#ifdef _WIN32
+  return ::_wfopen(path.c_str(), write ? L"wb" : L"rb");
+#else
+  return std::fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+static std::size_t encodeVarint(std::uint64_t value, std::uint8_t *out) {
+  std::size_t size = 0;
+
+  while (value >= 0x80) {
+    out[size++] = static_cast<std::uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+
+  out[size++] = static_cast<std::uint8_t>(value);
+  return size;
+}
+
+static bool decodeVarint(std::span<const std::byte> data, std::size_t &offset,
+                         std::uint64_t &result) {
+  result = 0;
+
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (offset >= data.size()) {
+      return false;
+    }
+
+    auto byte = static_cast<std::uint8_t>(data[offset++]);
+    result |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+RecordingTransport::RecordingTransport(std::unique_ptr<Transport> transport,
+                                       std::FILE *file)
+    : mTransport(std::move(transport)), mFile(file),
+      mLastRecord(std::chrono::steady_clock::now()) {}
+
+RecordingTransport::~RecordingTransport() {
+  if (mFile != nullptr) {
+    std::fclose(mFile);
+  }
+}
+
+std::expected<std::unique_ptr<RecordingTransport>, std::error_code>
+RecordingTransport::create(std::unique_ptr<Transport> transport,
+                           const std::filesystem::path &path) {
+  auto file = openFile(path, true);
+  if (file == nullptr) {
+    return std::unexpected(std::error_code(errno, std::generic_category()));
+  }
+
+  std::setvbuf(file, nullptr, _IOFBF, kFileBufferSize);
+
+  std::uint8_t header[kHeaderSize];
+  std::memcpy(header, SessionRecording::kMagic,
+              sizeof(SessionRecording::kMagic));
+  for (int i = 0; i < 4; ++i) {
+    header[sizeof(SessionRecording::kMagic) + i] =
+        static_cast<std::uint8_t>(SessionRecording::kVersion >> (i * 8));
+  }
+
+  if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+    auto error = errno;
+    std::fclose(file);
+    return std::unexpected(std::error_code(error, std::generic_category()));
+  }
+
+  return std::unique_ptr<RecordingTransport>(
+      new RecordingTransport(std::move(transport), file));
+}
+
+void RecordingTransport::record(
+    SessionRecording::Direction direction,
+    std::span<const std::span<const std::byte>> buffers) {
+  std::size_t size = 0;
+  for (auto buffer : buffers) {
+    size += buffer.size();
+  }
+
+  if (size == 0) {
+    return;
+  }
+
+  std::lock_guard lock(mMutex);
+
+  if (mFile == nullptr) {
+    return;
+  }
+
+  // timestamp is taken under the lock to keep records ordered
+  auto now = std::chrono::steady_clock::now();
+  auto delta =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - mLastRecord);
+  mLastRecord = now;
+
+  std::uint8_t header[1 + 10 + 10];
+  header[0] = static_cast<std::uint8_t>(direction);
+  std::size_t headerSize = 1;
+  headerSize += encodeVarint(delta.count(), header + headerSize);
+  headerSize += encodeVarint(size, header + headerSize);
+
+  bool failed = std::fwrite(header, 1, headerSize, mFile) != headerSize;
+
+  for (auto buffer : buffers) {
+    if (failed) {
+      break;
+    }
+
+    failed = std::fwrite(buffer.data(), 1, buffer.size(), mFile) !=
+             buffer.size();
+  }
+
+  if (failed) {
+    std::fprintf(stderr, "session recording stopped: %s\n",
+                 std::strerror(errno));
+    std::fclose(mFile);
+    mFile = nullptr;
+  }
+}
+
+void RecordingTransport::write(std::span<const std::byte> bytes) {
+  record(SessionRecording::Direction::Outbound, {&bytes, 1});
+  mTransport->write(bytes);
+}
+
+void RecordingTransport::writev(
+    std::span<const std::span<const std::byte>> buffers) {
+  record(SessionRecording::Direction::Outbound, buffers);
+  mTransport->writev(buffers);
+}
+
+void RecordingTransport::read(std::span<std::byte> &bytes) {
+  mTransport->read(bytes);
+  std::span<const std::byte> received = bytes;
+  record(SessionRecording::Direction::Inbound, {&received, 1});
+}
+
+void RecordingTransport::flush() { mTransport->flush(); }
+
+bool RecordingTransport::canPassHandles() const {
+  return mTransport->canPassHandles();
+}
+
+void RecordingTransport::writeWithHandles(
+    std::span<const std::span<const std::byte>> buffers,
+    std::span<const int> handles) {
+  // handles are not recorded, replayed session sees only frames
+  record(SessionRecording::Direction::Outbound, buffers);
+  mTransport->writeWithHandles(buffers, handles);
+}
+
+int RecordingTransport::takeHandle() { return mTransport->takeHandle(); }
+
+int RecordingTransport::getPollHandle() const {
+  return mTransport->getPollHandle();
+}
+
+std::expected<std::unique_ptr<ReplayTransport>, std::error_code>
+ReplayTransport::open(const std::filesystem::path &path, Pacing pacing) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return std::unexpected(ec);
+  }
+
+  auto file = openFile(path, false);
+  if (file == nullptr) {
+    return std::unexpected(std::error_code(errno, std::generic_category()));
+  }
+
+  std::vector<std::byte> data(size);
+  auto read = std::fread(data.data(), 1, data.size(), file);
+  std::fclose(file);
+
+  if (read != data.size()) {
+    return std::unexpected(std::make_error_code(std::errc::io_error));
+  }
+
+  if (data.size() < kHeaderSize ||
+      std::memcmp(data.data(), SessionRecording::kMagic,
+                  sizeof(SessionRecording::kMagic)) != 0) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  std::uint32_t version = 0;
+  for (int i = 0; i < 4; ++i) {
+    version |= static_cast<std::uint32_t>(
+                   data[sizeof(SessionRecording::kMagic) + i])
+               << (i * 8);
+  }
+
+  if (version != SessionRecording::kVersion) {
+    return std::unexpected(
+        std::make_error_code(std::errc::protocol_not_supported));
+  }
+
+  auto result = std::unique_ptr<ReplayTransport>(new ReplayTransport(pacing));
+  result->index(data);
+  return result;
+}
+
+namespace {
+struct RawFrame {
+  FrameHeader header;
+  std::span<const std::byte> bytes;
+  std::span<const std::byte> body;
+};
+} // namespace
+
+// Complete frame at the beginning of data
+static std::optional<RawFrame> splitFrame(std::span<const std::byte> data) {
+  constexpr std::string_view kHeaderEnd = "\r\n\r\n";
+  std::string_view text(reinterpret_cast<const char *>(data.data()),
+                        data.size());
+
+  auto headerEnd =
+      text.substr(0, FrameDecoder::kMaxHeaderSize).find(kHeaderEnd);
+  if (headerEnd == std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  auto header = FrameDecoder::parseHeader(text.substr(0, headerEnd));
+  auto bodyOffset = headerEnd + kHeaderEnd.size();
+
+  if (!header || header->contentLength > data.size() - bodyOffset) {
+    return std::nullopt;
+  }
+
+  return RawFrame{
+      .header = std::move(*header),
+      .bytes = data.first(bodyOffset + header->contentLength),
+      .body = data.subspan(bodyOffset, header->contentLength),
+  };
+}
+
+// Discarded value if body cannot be decoded
+static nlohmann::json decodeBody(const RawFrame &frame) {
+  auto body = frame.body;
+  std::vector<std::byte> decoded;
+
+  if (frame.header.encoding != FrameEncoding::Identity) {
+    if (!frame.header.encoding ||
+        !decodeFrame(*frame.header.encoding, body, decoded)) {
+      return nlohmann::json(nlohmann::json::value_t::discarded);
+    }
+
+    body = decoded;
+  }
+
+  auto begin = reinterpret_cast<const std::uint8_t *>(body.data());
+  auto end = begin + body.size();
+
+  switch (frame.header.format.value_or(MessageFormat::Json)) {
+  case MessageFormat::Json:
+    break;
+  case MessageFormat::MsgPack:
+    return nlohmann::json::from_msgpack(begin, end, true, false);
+  case MessageFormat::Cbor:
+    return nlohmann::json::from_cbor(begin, end, true, false);
+  }
+
+  return nlohmann::json::parse(begin, end, nullptr, false);
+}
+
+// Rewritten frames are not compressed, extension accepts them either way
+static void writeFrame(MessageFormat format, const nlohmann::json &message,
+                       std::vector<std::byte> &output) {
+  std::vector<std::uint8_t> body;
+
+  switch (format) {
+  case MessageFormat::Json: {
+    auto text = message.dump();
+    body.assign(text.begin(), text.end());
+    break;
+  }
+  case MessageFormat::MsgPack:
+    body = nlohmann::json::to_msgpack(message);
+    break;
+  case MessageFormat::Cbor:
+    body = nlohmann::json::to_cbor(message);
+    break;
+  }
+
+  auto header = "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  if (format != MessageFormat::Json) {
+    header += "Content-Type: ";
+    header += getMessageFormatContentType(format);
+    header += "\r\n";
+  }
+  header += "\r\n";
+
+  output.clear();
+  output.reserve(header.size() + body.size());
+  for (char c : header) {
+    output.push_back(static_cast<std::byte>(c));
+  }
+  for (auto byte : body) {
+    output.push_back(static_cast<std::byte>(byte));
+  }
+}
+
+// Calls with id in message or batch, key identifies call by method and
+// params
+template <typename F>
+static void forEachCall(const nlohmann::json &message, F &&onCall) {
+  auto visit = [&](const nlohmann::json &item) {
+    if (!item.is_object()) {
+      return;
+    }
+
+    auto method = item.find("method");
+    auto id = item.find("id");
+    if (method == item.end() || !method->is_string() || id == item.end() ||
+        !id->is_number_unsigned()) {
+      return;
+    }
+
+    auto key = method->get<std::string>();
+    key += '\0';
+    if (auto params = item.find("params"); params != item.end()) {
+      key += params->dump();
+    }
+
+    onCall(id->get<std::uint64_t>(), std::move(key));
+  };
+
+  if (message.is_array()) {
+    for (auto &item : message) {
+      visit(item);
+    }
+  } else {
+    visit(message);
+  }
+}
+
+// Ids of responses in message or batch
+template <typename JsonT, typename F>
+static void forEachResponseId(JsonT &message, F &&onId) {
+  auto visit = [&](auto &item) {
+    if (!item.is_object() || item.contains("method")) {
+      return;
+    }
+
+    if (auto id = item.find("id");
+        id != item.end() && id->is_number_unsigned()) {
+      onId(*id);
+    }
+  };
+
+  if (message.is_array()) {
+    for (auto &item : message) {
+      visit(item);
+    }
+  } else {
+    visit(message);
+  }
+}
+
+void ReplayTransport::index(std::span<const std::byte> data) {
+  std::vector<std::byte> outbound;
+
+  // end offset of every inbound chunk and its time
+  std::vector<std::pair<std::size_t, std::chrono::nanoseconds>> chunks;
+  std::chrono::nanoseconds time{0};
+  std::size_t offset = kHeaderSize;
+
+  while (offset < data.size()) {
+    auto direction = static_cast<SessionRecording::Direction>(data[offset]);
+    std::size_t payload = offset + 1;
+    std::uint64_t delta;
+    std::uint64_t size;
+
+    if (!decodeVarint(data, payload, delta) ||
+        !decodeVarint(data, payload, size) ||
+        size > data.size() - payload ||
+        direction > SessionRecording::Direction::Outbound) {
+      std::fprintf(stderr, "session recording is corrupted at offset %zu\n",
+                   offset);
+      break;
+    }
+
+    auto bytes = data.subspan(payload, size);
+    offset = payload + size;
+    time += std::chrono::nanoseconds(delta);
+
+    if (direction == SessionRecording::Direction::Inbound) {
+      mInbound.insert(mInbound.end(), bytes.begin(), bytes.end());
+      chunks.emplace_back(mInbound.size(), time);
+    } else {
+      outbound.insert(outbound.end(), bytes.begin(), bytes.end());
+    }
+  }
+
+  std::unordered_map<std::string, std::size_t> occurrences;
+  std::span<const std::byte> rest = outbound;
+
+  while (auto frame = splitFrame(rest)) {
+    rest = rest.subspan(frame->bytes.size());
+    forEachCall(decodeBody(*frame), [&](std::uint64_t id, std::string key) {
+      auto occurrence = occurrences[key]++;
+      mRecordedCalls.insert_or_assign(id, CallKey{std::move(key), occurrence});
+    });
+  }
+
+  // frames are delivered at time their last chunk was received
+  std::size_t chunk = 0;
+  std::size_t position = 0;
+
+  while (position < mInbound.size()) {
+    auto frame = splitFrame(std::span(mInbound).subspan(position));
+
+    if (!frame) {
+      // rest of stream is not framed, it goes to extension as it is
+      mSegments.push_back({std::span(mInbound).subspan(position),
+                           chunks.back().second, false});
+      break;
+    }
+
+    position += frame->bytes.size();
+    while (chunks[chunk].first < position) {
+      chunk++;
+    }
+
+    bool isResponse = false;
+    const auto message = decodeBody(*frame);
+    forEachResponseId(message, [&](const nlohmann::json &id) {
+      isResponse |= mRecordedCalls.contains(id.get<std::uint64_t>());
+    });
+
+    mSegments.push_back({frame->bytes, chunks[chunk].second, isResponse});
+  }
+}
+
+std::optional<std::uint64_t>
+ReplayTransport::waitCall(const CallKey &call) {
+  std::unique_lock lock(mCallsMutex);
+  std::vector<std::uint64_t> *ids = nullptr;
+
+  mCallsChanged.wait_for(lock, kCallWait, [&] {
+    auto it = mLiveCalls.find(call.key);
+    ids = it == mLiveCalls.end() ? nullptr : &it->second;
+    return ids != nullptr && ids->size() > call.occurrence;
+  });
+
+  if (ids == nullptr || ids->size() <= call.occurrence) {
+    return std::nullopt;
+  }
+
+  return (*ids)[call.occurrence];
+}
+
+std::span<const std::byte>
+ReplayTransport::rewriteResponse(std::span<const std::byte> bytes) {
+  auto frame = splitFrame(bytes);
+  auto message = decodeBody(*frame);
+
+  forEachResponseId(message, [&](nlohmann::json &id) {
+    auto call = mRecordedCalls.find(id.get<std::uint64_t>());
+    if (call == mRecordedCalls.end()) {
+      return;
+    }
+
+    if (auto liveId = waitCall(call->second)) {
+      id = *liveId;
+    }
+  });
+
+  writeFrame(frame->header.format.value_or(MessageFormat::Json), message,
+             mRewritten);
+  return mRewritten;
+}
+
+void ReplayTransport::write(std::span<const std::byte> bytes) {
+  std::lock_guard lock(mCallsMutex);
+  mOutbound.insert(mOutbound.end(), bytes.begin(), bytes.end());
+
+  std::span<const std::byte> rest = mOutbound;
+  bool changed = false;
+
+  while (auto frame = splitFrame(rest)) {
+    rest = rest.subspan(frame->bytes.size());
+    forEachCall(decodeBody(*frame), [&](std::uint64_t id, std::string key) {
+      mLiveCalls[std::move(key)].push_back(id);
+      changed = true;
+    });
+  }
+
+  mOutbound.erase(mOutbound.begin(),
+                  mOutbound.begin() + (mOutbound.size() - rest.size()));
+
+  if (changed) {
+    mCallsChanged.notify_all();
+  }
+}
+
+void ReplayTransport::read(std::span<std::byte> &bytes) {
+  if (mChunk.empty()) {
+    if (mNextSegment >= mSegments.size()) {
+      bytes = {};
+      return;
+    }
+
+    auto &segment = mSegments[mNextSegment++];
+
+    if (mPacing == Pacing::Original) {
+      if (!mStarted) {
+        mStart = std::chrono::steady_clock::now();
+        mStarted = true;
+      }
+
+      std::this_thread::sleep_until(mStart + segment.time);
+    }
+
+    mChunk = segment.isResponse ? rewriteResponse(segment.bytes)
+                                : segment.bytes;
+  }
+
+  auto size = std::min(bytes.size(), mChunk.size());
+  std::memcpy(bytes.data(), mChunk.data(), size);
+  mChunk = mChunk.subspan(size);
+  bytes = bytes.subspan(0, size);
+}
@@ -0,0 +1,164 @@
+#include "rpcsx/ui/SharedMemoryTransport.hpp"
+#include <bit>
+#include <cerrno>
+#include <new>
+
+#if defined(__linux)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+#if defined(__linux)
+static std::error_code lastError() {
+  return std::make_error_code(std::errc{errno});
+}
+
+SharedMemoryTransport::SharedMemoryTransport(int fd, void *mapping,
+                                             std::size_t size, Side side)
+    : mFd(fd), mMapping(mapping), mMappingSize(size) {
+  auto layout = static_cast<Layout *>(mapping);
+  auto data = static_cast<std::byte *>(mapping) + kDataOffset;
+  std::size_t ringSize = layout->ringSize;
+
+  SpscRing hostToExtension(&layout->hostToExtension, {data, ringSize});
+  SpscRing extensionToHost(&layout->extensionToHost,
+                           {data + ringSize, ringSize});
+
+  if (side == Side::Host) {
+    mInput = extensionToHost;
+    mOutput = hostToExtension;
+  } else {
+    mInput = hostToExtension;
+    mOutput = extensionToHost;
+  }
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+  mOutput.close();
+  mInput.close();
+  ::munmap(mMapping, mMappingSize);
+  ::close(mFd);
+}
+
+std::expected<std::pair<std::unique_ptr<SharedMemoryTransport>, int>,
+              std::error_code>
+SharedMemoryTransport::create(std::size_t ringSize) {
+  if (!std::has_single_bit(ringSize) || ringSize > (1u << 30)) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  int fd = ::memfd_create("rpcsx-ui-transport", MFD_CLOEXEC);
+  if (fd < 0) {
+    return std::unexpected(lastError());
+  }
+
+  std::size_t size = kDataOffset + ringSize * 2;
+  if (::ftruncate(fd, size) < 0) {
+    auto error = lastError();
+    ::close(fd);
+    return std::unexpected(error);
+  }
+
+  void *mapping =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    auto error = lastError();
+    ::close(fd);
+    return std::unexpected(error);
+  }
+
+  auto layout = new (mapping) Layout{
+      .magic = kMagic,
+      .version = kVersion,
+      .ringSize = static_cast<std::uint32_t>(ringSize),
+      .reserved = 0,
+  };
+
+  std::atomic_thread_fence(std::memory_order::release);
+
+  int peerFd = ::dup(fd);
+  if (peerFd < 0) {
+    auto error = lastError();
+    layout->~Layout();
+    ::munmap(mapping, size);
+    ::close(fd);
+    return std::unexpected(error);
+  }
+
+  return std::pair{
+      std::unique_ptr<SharedMemoryTransport>(
+          new SharedMemoryTransport(fd, mapping, size, Side::Host)),
+      peerFd,
+  };
+}
+
+std::expected<std::unique_ptr<SharedMemoryTransport>, std::error_code>
+SharedMemoryTransport::open(int fd) {
+  struct stat fs;
+  if (::fstat(fd, &fs) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  std::size_t size = fs.st_size;
+  if (size <= kDataOffset) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  void *mapping =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return std::unexpected(lastError());
+  }
+
+  auto layout = static_cast<const Layout *>(mapping);
+  std::size_t ringSize = layout->ringSize;
+
+  if (layout->magic != kMagic || layout->version != kVersion ||
+      !std::has_single_bit(ringSize) || kDataOffset + ringSize * 2 != size) {
+    ::munmap(mapping, size);
+    return std::unexpected(
+        std::make_error_code(std::errc::protocol_not_supported));
+  }
+
+  ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+  return std::unique_ptr<SharedMemoryTransport>(
+      new SharedMemoryTransport(fd, mapping, size, Side::Extension));
+}
+
+void SharedMemoryTransport::write(std::span<const std::byte> bytes) {
+  mOutput.write(bytes);
+}
+
+void SharedMemoryTransport::read(std::span<std::byte> &bytes) {
+  bytes = bytes.subspan(0, mInput.read(bytes));
+}
+#else
+SharedMemoryTransport::SharedMemoryTransport(int fd, void *mapping,
+                                             std::size_t size, Side)
+    : mFd(fd), mMapping(mapping), mMappingSize(size) {}
+
+SharedMemoryTransport::~SharedMemoryTransport() = default;
+
+std::expected<std::pair<std::unique_ptr<SharedMemoryTransport>, int>,
+              std::error_code>
+SharedMemoryTransport::create(std::size_t) {
+  return std::unexpected(
+      std::make_error_code(std::errc::function_not_supported));
+}
+
+std::expected<std::unique_ptr<SharedMemoryTransport>, std::error_code>
+SharedMemoryTransport::open(int) {
+  return std::unexpected(
+      std::make_error_code(std::errc::function_not_supported));
+}
+
+void SharedMemoryTransport::write(std::span<const std::byte>) {}
+void SharedMemoryTransport::read(std::span<std::byte> &bytes) {
+  bytes = bytes.subspan(0, 0);
+}
+#endif
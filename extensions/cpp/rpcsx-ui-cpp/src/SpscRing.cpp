@@ -0,0 +1,157 @@
+#include "rpcsx/ui/SpscRing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+#if defined(__linux)
+// shared futex, rings can be mapped by different processes. Sleep is bounded
+// to recover from wakeups lost to closing peer
+void rpcsx::ui::futexWait(std::atomic<std::uint32_t> &word,
+                          std::uint32_t expected) {
+  timespec timeout{.tv_sec = 0, .tv_nsec = 100'000'000};
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT,
+            expected, &timeout, nullptr, 0);
+}
+
+void rpcsx::ui::futexWake(std::atomic<std::uint32_t> &word) {
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE,
+            1, nullptr, nullptr, 0);
+}
+#else
+// std::atomic has no timed wait, poll with growing sleeps instead. Bounded
+// the same way as futex wait
+void rpcsx::ui::futexWait(std::atomic<std::uint32_t> &word,
+                          std::uint32_t expected) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+  std::chrono::microseconds delay(50);
+
+  while (word.load(std::memory_order::acquire) == expected &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(delay);
+    delay = std::min(delay * 2, std::chrono::microseconds(1000));
+  }
+}
+
+void rpcsx::ui::futexWake(std::atomic<std::uint32_t> &) {}
+#endif
+
+void SpscRing::wait(std::atomic<std::uint32_t> &word,
+                    std::atomic<std::uint32_t> &waiting,
+                    std::uint32_t observed) {
+  for (int i = 0; i < kSpinCount; ++i) {
+    if (word.load(std::memory_order::acquire) != observed || isClosed()) {
+      return;
+    }
+
+    cpuRelax();
+  }
+
+  waiting.store(1);
+
+  if (word.load() == observed && !isClosed()) {
+    futexWait(word, observed);
+  }
+}
+
+void SpscRing::notify(std::atomic<std::uint32_t> &word,
+                      std::atomic<std::uint32_t> &waiting) {
+  std::atomic_thread_fence(std::memory_order::seq_cst);
+
+  if (waiting.load(std::memory_order::relaxed) != 0) {
+    waiting.store(0, std::memory_order::relaxed);
+    futexWake(word);
+  }
+}
+
+bool SpscRing::write(std::span<const std::byte> bytes) {
+  auto head = mControl->head.load(std::memory_order::relaxed);
+
+  while (!bytes.empty()) {
+    if (isClosed()) {
+      return false;
+    }
+
+    auto tail = mControl->tail.load(std::memory_order::acquire);
+    std::size_t free = capacity() - (head - tail);
+
+    if (free == 0) {
+      wait(mControl->tail, mControl->producerWaiting, tail);
+      continue;
+    }
+
+    auto count = std::min(free, bytes.size());
+    auto offset = head & mMask;
+    auto first = std::min<std::size_t>(count, capacity() - offset);
+
+    std::memcpy(mData + offset, bytes.data(), first);
+    std::memcpy(mData, bytes.data() + first, count - first);
+
+    head += static_cast<std::uint32_t>(count);
+    mControl->head.store(head, std::memory_order::release);
+    notify(mControl->head, mControl->consumerWaiting);
+    bytes = bytes.subspan(count);
+  }
+
+  return true;
+}
+
+std::size_t SpscRing::read(std::span<std::byte> bytes) {
+  auto tail = mControl->tail.load(std::memory_order::relaxed);
+
+  while (true) {
+    auto head = mControl->head.load(std::memory_order::acquire);
+    std::size_t available = head - tail;
+
+    if (available == 0) {
+      if (isClosed()) {
+        if (mControl->head.load(std::memory_order::acquire) == tail) {
+          return 0;
+        }
+
+        continue;
+      }
+
+      wait(mControl->head, mControl->consumerWaiting, head);
+      continue;
+    }
+
+    auto count = std::min(available, bytes.size());
+    auto offset = tail & mMask;
+    auto first = std::min<std::size_t>(count, capacity() - offset);
+
+    std::memcpy(bytes.data(), mData + offset, first);
+    std::memcpy(bytes.data() + first, mData, count - first);
+
+    tail += static_cast<std::uint32_t>(count);
+    mControl->tail.store(tail, std::memory_order::release);
+    notify(mControl->tail, mControl->producerWaiting);
+    return count;
+  }
+}
+
+void SpscRing::close() {
+  mControl->closed.store(1);
+  futexWake(mControl->head);
+  futexWake(mControl->tail);
+}
@@ -0,0 +1,121 @@
+#include "rpcsx/ui/TimerWheel.hpp"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using namespace rpcsx::ui;
+
+static constexpr unsigned kTopShift =
+    TimerWheel::kSlotBits * TimerWheel::kLevels;
+
+void TimerWheel::add(std::uint64_t id, Tick expiry) {
+  insert({id, std::max(expiry, mNow + 1)});
+  mSize++;
+}
+
+void TimerWheel::insert(Entry entry) {
+  auto diff = entry.expiry ^ mNow;
+  unsigned level = diff == 0 ? 0 : (std::bit_width(diff) - 1) / kSlotBits;
+
+  if (level >= kLevels) {
+    mOverflow.push_back(entry);
+    return;
+  }
+
+  auto slot = (entry.expiry >> (level * kSlotBits)) & kSlotMask;
+  mSlots[level][slot].push_back(entry);
+  mOccupied[level] |= std::uint64_t(1) << slot;
+}
+
+std::optional<TimerWheel::Tick> TimerWheel::nextEvent() const {
+  std::optional<Tick> result;
+
+  auto consider = [&](Tick tick) {
+    if (!result || tick < *result) {
+      result = tick;
+    }
+  };
+
+  // slots at or before current digit were already processed
+  for (unsigned level = 0; level < kLevels; ++level) {
+    auto shift = level * kSlotBits;
+    auto digit = (mNow >> shift) & kSlotMask;
+    auto pending = digit == kSlotMask
+                       ? 0
+                       : mOccupied[level] & (~std::uint64_t(0) << (digit + 1));
+
+    if (pending != 0) {
+      auto base = (mNow >> (shift + kSlotBits)) << (shift + kSlotBits);
+      consider(base | (Tick(std::countr_zero(pending)) << shift));
+    }
+  }
+
+  if (!mOverflow.empty()) {
+    consider(((mNow >> kTopShift) + 1) << kTopShift);
+  }
+
+  return result;
+}
+
+void TimerWheel::advance(Tick now, std::vector<std::uint64_t> &expired) {
+  while (true) {
+    auto next = nextEvent();
+    if (!next || *next > now) {
+      mNow = std::max(mNow, now);
+      return;
+    }
+
+    mNow = *next;
+
+    if ((mNow & ((Tick(1) << kTopShift) - 1)) == 0 && !mOverflow.empty()) {
+      for (auto &entry : std::exchange(mOverflow, {})) {
+        insert(entry);
+      }
+    }
+
+    // cascade from the top, entries land in lower levels and the ones that
+    // expire right now end up in processed level 0 slot
+    for (unsigned level = kLevels - 1; level > 0; --level) {
+      auto shift = level * kSlotBits;
+      if ((mNow & ((Tick(1) << shift) - 1)) != 0) {
+        continue;
+      }
+
+      auto slot = (mNow >> shift) & kSlotMask;
+      if ((mOccupied[level] & (std::uint64_t(1) << slot)) == 0) {
+        continue;
+      }
+
+      mOccupied[level] &= ~(std::uint64_t(1) << slot);
+      for (auto &entry : std::exchange(mSlots[level][slot], {})) {
+        insert(entry);
+      }
+    }
+
+    auto slot = mNow & kSlotMask;
+    if ((mOccupied[0] & (std::uint64_t(1) << slot)) != 0) {
+      mOccupied[0] &= ~(std::uint64_t(1) << slot);
+
+      for (auto &entry : mSlots[0][slot]) {
+        expired.push_back(entry.id);
+      }
+
+      mSize -= mSlots[0][slot].size();
+      mSlots[0][slot].clear();
+    }
+  }
+}
+
+void TimerWheel::clear() {
+  for (unsigned level = 0; level < kLevels; ++level) {
+    for (auto occupied = mOccupied[level]; occupied != 0;
+         occupied &= occupied - 1) {
+      mSlots[level][std::countr_zero(occupied)].clear();
+    }
+
+    mOccupied[level] = 0;
+  }
+
+  mOverflow.clear();
+  mSize = 0;
+}
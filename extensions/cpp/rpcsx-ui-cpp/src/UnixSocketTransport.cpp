@@ -0,0 +1,441 @@
+#include "rpcsx/ui/UnixSocketTransport.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+static constexpr int kSendFlags = 0;
+#endif
+
+#ifdef MSG_CMSG_CLOEXEC
+static constexpr int kRecvFlags = MSG_CMSG_CLOEXEC;
+#else
+static constexpr int kRecvFlags = 0;
+#endif
+
+static std::error_code lastError() {
+  return std::make_error_code(std::errc{errno});
+}
+
+static void configureSocket(int socket, std::size_t bufferSize) {
+  int size = static_cast<int>(bufferSize);
+  ::setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  ::setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+#ifdef SO_NOSIGPIPE
+  int noSigPipe = 1;
+  ::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+  ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+}
+
+static std::expected<sockaddr_un, std::error_code>
+makeAddress(const std::filesystem::path &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+
+  auto &native = path.native();
+  if (native.size() >= sizeof(address.sun_path)) {
+    return std::unexpected(std::make_error_code(std::errc::filename_too_long));
+  }
+
+  std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+  return address;
+}
+
+// Removes socket left behind by listener that is gone. Other files and
+// sockets somebody still listens on are kept
+static std::error_code removeStaleSocket(const std::filesystem::path &path,
+                                         const sockaddr_un &address) {
+  struct stat info;
+  if (::lstat(path.c_str(), &info) < 0) {
+    return errno == ENOENT ? std::error_code{} : lastError();
+  }
+
+  if (!S_ISSOCK(info.st_mode)) {
+    return std::make_error_code(std::errc::file_exists);
+  }
+
+  int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probe < 0) {
+    return lastError();
+  }
+
+  bool isAlive = ::connect(probe, reinterpret_cast<const sockaddr *>(&address),
+                           sizeof(address)) == 0;
+  ::close(probe);
+
+  if (isAlive) {
+    return std::make_error_code(std::errc::address_in_use);
+  }
+
+  if (::unlink(path.c_str()) < 0 && errno != ENOENT) {
+    return lastError();
+  }
+
+  return {};
+}
+
+UnixSocketTransport::~UnixSocketTransport() {
+  for (int handle : mReceivedHandles) {
+    ::close(handle);
+  }
+
+  if (mSocket >= 0) {
+    ::close(mSocket);
+  }
+}
+
+std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+UnixSocketTransport::adopt(int socket, std::size_t bufferSize) {
+  int type = 0;
+  socklen_t typeLength = sizeof(type);
+  if (::getsockopt(socket, SOL_SOCKET, SO_TYPE, &type, &typeLength) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  if (type != SOCK_STREAM) {
+    return std::unexpected(
+        std::make_error_code(std::errc::wrong_protocol_type));
+  }
+
+  configureSocket(socket, bufferSize);
+  return std::make_unique<UnixSocketTransport>(socket);
+}
+
+std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+UnixSocketTransport::connect(const std::filesystem::path &path,
+                             std::size_t bufferSize) {
+  auto address = makeAddress(path);
+  if (!address) {
+    return std::unexpected(address.error());
+  }
+
+  int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socket < 0) {
+    return std::unexpected(lastError());
+  }
+
+  configureSocket(socket, bufferSize);
+
+  if (::connect(socket, reinterpret_cast<const sockaddr *>(&*address),
+                sizeof(*address)) < 0) {
+    auto error = lastError();
+    ::close(socket);
+    return std::unexpected(error);
+  }
+
+  return std::make_unique<UnixSocketTransport>(socket);
+}
+
+void UnixSocketTransport::write(std::span<const std::byte> bytes) {
+  writev({&bytes, 1});
+}
+
+void UnixSocketTransport::writev(
+    std::span<const std::span<const std::byte>> buffers) {
+  send(buffers, {});
+}
+
+void UnixSocketTransport::writeWithHandles(
+    std::span<const std::span<const std::byte>> buffers,
+    std::span<const int> handles) {
+  send(buffers, handles);
+
+  for (int handle : handles) {
+    ::close(handle);
+  }
+}
+
+void UnixSocketTransport::send(
+    std::span<const std::span<const std::byte>> buffers,
+    std::span<const int> handles) {
+  iovec iov[64];
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) *
+                                           kMaxHandlesPerMessage)];
+
+  while (!buffers.empty()) {
+    int count = 0;
+    for (; count < std::ssize(iov) && count < std::ssize(buffers); ++count) {
+      iov[count] = {
+          .iov_base = const_cast<std::byte *>(buffers[count].data()),
+          .iov_len = buffers[count].size(),
+      };
+    }
+
+    buffers = buffers.subspan(count);
+
+    msghdr message{};
+    message.msg_iov = iov;
+    message.msg_iovlen = count;
+
+    while (message.msg_iovlen > 0) {
+      auto handleCount = std::min(handles.size(), kMaxHandlesPerMessage);
+      auto iovCount = message.msg_iovlen;
+      auto firstLength = message.msg_iov->iov_len;
+
+      message.msg_control = nullptr;
+      message.msg_controllen = 0;
+
+      if (handleCount > 0) {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(sizeof(int) * handleCount);
+
+        auto header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * handleCount);
+        std::memcpy(CMSG_DATA(header), handles.data(),
+                    sizeof(int) * handleCount);
+
+        // every chunk of handles needs data byte of its own
+        if (handleCount < handles.size()) {
+          message.msg_iovlen = 1;
+          message.msg_iov->iov_len = std::min<std::size_t>(firstLength, 1);
+        }
+      }
+
+      auto written = ::sendmsg(mSocket, &message, kSendFlags);
+
+      message.msg_iovlen = iovCount;
+      message.msg_iov->iov_len = firstLength;
+
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        return;
+      }
+
+      handles = handles.subspan(handleCount);
+
+      while (message.msg_iovlen > 0 &&
+             std::size_t(written) >= message.msg_iov->iov_len) {
+        written -= message.msg_iov->iov_len;
+        ++message.msg_iov;
+        --message.msg_iovlen;
+      }
+
+      if (message.msg_iovlen > 0) {
+        message.msg_iov->iov_base =
+            static_cast<std::byte *>(message.msg_iov->iov_base) + written;
+        message.msg_iov->iov_len -= written;
+      }
+    }
+  }
+}
+
+void UnixSocketTransport::read(std::span<std::byte> &bytes) {
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) *
+                                           kMaxHandlesPerMessage)];
+
+  while (true) {
+    iovec iov{.iov_base = bytes.data(), .iov_len = bytes.size()};
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    auto count = ::recvmsg(mSocket, &message, kRecvFlags);
+
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+
+    for (auto header = CMSG_FIRSTHDR(&message); header != nullptr;
+         header = CMSG_NXTHDR(&message, header)) {
+      if (header->cmsg_level != SOL_SOCKET ||
+          header->cmsg_type != SCM_RIGHTS) {
+        continue;
+      }
+
+      std::size_t handleCount =
+          (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+      for (std::size_t i = 0; i < handleCount; ++i) {
+        int handle;
+        std::memcpy(&handle, CMSG_DATA(header) + i * sizeof(int),
+                    sizeof(int));
+        mReceivedHandles.push_back(handle);
+      }
+    }
+
+    if (message.msg_flags & MSG_CTRUNC) {
+      std::fprintf(stderr, "unix socket: received handles were truncated\n");
+    }
+
+    bytes = bytes.subspan(0, count > 0 ? count : 0);
+    return;
+  }
+}
+
+int UnixSocketTransport::takeHandle() {
+  if (mReceivedHandles.empty()) {
+    return -1;
+  }
+
+  int handle = mReceivedHandles.front();
+  mReceivedHandles.pop_front();
+  return handle;
+}
+
+UnixSocketListener::~UnixSocketListener() {
+  if (mSocket >= 0) {
+    ::close(mSocket);
+    ::unlink(mPath.c_str());
+  }
+
+  if (mWakeRead >= 0) {
+    ::close(mWakeRead);
+    ::close(mWakeWrite);
+  }
+}
+
+std::expected<UnixSocketListener, std::error_code>
+UnixSocketListener::listen(const std::filesystem::path &path) {
+  auto address = makeAddress(path);
+  if (!address) {
+    return std::unexpected(address.error());
+  }
+
+  UnixSocketListener result;
+  result.mSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (result.mSocket < 0) {
+    return std::unexpected(lastError());
+  }
+
+  ::fcntl(result.mSocket, F_SETFD, FD_CLOEXEC);
+
+  if (auto error = removeStaleSocket(path, *address)) {
+    return std::unexpected(error);
+  }
+
+  if (::bind(result.mSocket, reinterpret_cast<const sockaddr *>(&*address),
+             sizeof(*address)) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  result.mPath = path;
+
+  if (::listen(result.mSocket, SOMAXCONN) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  int wakePipe[2];
+#ifdef __linux__
+  if (::pipe2(wakePipe, O_CLOEXEC) < 0) {
+    return std::unexpected(lastError());
+  }
+#else
+  if (::pipe(wakePipe) < 0) {
+    return std::unexpected(lastError());
+  }
+
+  ::fcntl(wakePipe[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(wakePipe[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+  result.mWakeRead = wakePipe[0];
+  result.mWakeWrite = wakePipe[1];
+  return result;
+}
+
+std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+UnixSocketListener::accept(std::size_t bufferSize) {
+  while (true) {
+    pollfd fds[] = {
+        {.fd = mSocket, .events = POLLIN},
+        {.fd = mWakeRead, .events = POLLIN},
+    };
+
+    if (::poll(fds, std::size(fds), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return std::unexpected(lastError());
+    }
+
+    if (fds[1].revents != 0) {
+      return std::unexpected(
+          std::make_error_code(std::errc::operation_canceled));
+    }
+
+    int socket = ::accept(mSocket, nullptr, nullptr);
+
+    if (socket < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == ECONNABORTED) {
+        continue;
+      }
+
+      return std::unexpected(lastError());
+    }
+
+    configureSocket(socket, bufferSize);
+    return std::make_unique<UnixSocketTransport>(socket);
+  }
+}
+
+void UnixSocketListener::interrupt() {
+  char value = 0;
+  [[maybe_unused]] auto result = ::write(mWakeWrite, &value, 1);
+}
+#else
+static std::error_code notSupported() {
+  return std::make_error_code(std::errc::function_not_supported);
+}
+
+UnixSocketTransport::~UnixSocketTransport() = default;
+
+std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+UnixSocketTransport::adopt(int, std::size_t) {
+  return std::unexpected(notSupported());
+}
+
+std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+UnixSocketTransport::connect(const std::filesystem::path &, std::size_t) {
+  return std::unexpected(notSupported());
+}
+
+void UnixSocketTransport::write(std::span<const std::byte>) {}
+void UnixSocketTransport::writev(std::span<const std::span<const std::byte>>) {}
+void UnixSocketTransport::writeWithHandles(
+    std::span<const std::span<const std::byte>>, std::span<const int>) {}
+void UnixSocketTransport::read(std::span<std::byte> &bytes) {
+  bytes = bytes.subspan(0, 0);
+}
+int UnixSocketTransport::takeHandle() { return -1; }
+
+UnixSocketListener::~UnixSocketListener() = default;
+
+std::expected<UnixSocketListener, std::error_code>
+UnixSocketListener::listen(const std::filesystem::path &) {
+  return std::unexpected(notSupported());
+}
+
+std::expected<std::unique_ptr<UnixSocketTransport>, std::error_code>
+UnixSocketListener::accept(std::size_t) {
+  return std::unexpected(notSupported());
+}
+
+void UnixSocketListener::interrupt() {}
+#endif
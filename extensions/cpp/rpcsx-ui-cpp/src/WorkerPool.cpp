@@ -0,0 +1,309 @@
+#include "rpcsx/ui/WorkerPool.hpp"
+#include <algorithm>
+#include <thread>
+
+using namespace rpcsx::ui;
+
+static constexpr std::uint32_t kRunning = 0;
+static constexpr std::uint32_t kParked = 1;
+
+// producer took parked worker and is about to hand it the job
+static constexpr std::uint32_t kClaimed = 2;
+
+thread_local WorkerPool::Worker *WorkerPool::gCurrentWorker = nullptr;
+
+WorkerPool::WorkerPool(std::size_t threadCount, Task onIdle, Task onStart)
+    : mOnIdle(std::move(onIdle)), mOnStart(std::move(onStart)) {
+  threadCount = std::max<std::size_t>(threadCount, 1);
+  mWorkers.reserve(threadCount);
+
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    mWorkers.push_back(std::make_unique<Worker>());
+    mWorkers.back()->pool = this;
+  }
+
+  // workers schedule to each other, start them once the set is complete
+  for (auto &worker : mWorkers) {
+    worker->thread = std::thread([this, worker = worker.get()] {
+      if (mOnStart) {
+        mOnStart();
+      }
+
+      run(*worker);
+    });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  stop();
+
+  for (auto &worker : mWorkers) {
+    release(worker->handoff.exchange(nullptr));
+    release(worker->jobs.head);
+  }
+
+  release(mExternalJobs.head);
+
+  release(mOverflowTaken);
+  release(mOverflow.popAll());
+
+  for (auto &[id, strand] : mStrands) {
+    release(strand->tasks.popAll());
+  }
+
+  release(mFreeJobs.popAll());
+}
+
+WorkerPool::Job *WorkerPool::acquire() {
+  if (auto worker = gCurrentWorker; worker != nullptr && worker->pool == this) {
+    return acquire(&worker->jobs);
+  }
+
+  // most often the event loop is the only thread outside of the pool that
+  // posts, concurrent one allocates instead of waiting for it
+  std::unique_lock lock(mExternalJobsMutex, std::try_to_lock);
+  return acquire(lock.owns_lock() ? &mExternalJobs : nullptr);
+}
+
+// Jobs finished by workers go back to free list of the pool. Posting thread
+// detaches the whole list at once, popAll() is a single exchange so any
+// thread may take it, and keeps the jobs in its cache until it runs out of
+// them
+WorkerPool::Job *WorkerPool::acquire(JobCache *cache) {
+  if (cache != nullptr) {
+    if (cache->head == nullptr) {
+      cache->head = mFreeJobs.popAll();
+    }
+
+    if (auto node = cache->head) {
+      cache->head = node->next;
+      return static_cast<Job *>(node);
+    }
+  }
+
+  mAllocatedJobs.fetch_add(1, std::memory_order::relaxed);
+  return new Job;
+}
+
+// Captures are destroyed right away, they may hold resources
+void WorkerPool::recycle(Job *job) {
+  job->task = nullptr;
+  mFreeJobs.push(job);
+}
+
+void WorkerPool::release(MpscNode *node) {
+  while (node != nullptr) {
+    auto job = static_cast<Job *>(node);
+    node = node->next;
+
+    if (job->strand == nullptr) {
+      delete job;
+    }
+  }
+}
+
+void WorkerPool::stop() {
+  mStopping.store(true, std::memory_order::seq_cst);
+
+  for (auto &worker : mWorkers) {
+    worker->state.store(kRunning, std::memory_order::seq_cst);
+    worker->state.notify_one();
+  }
+
+  for (auto &worker : mWorkers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+void WorkerPool::post(Task task) {
+  mPending.fetch_add(1, std::memory_order::relaxed);
+
+  auto job = acquire();
+  job->task = std::move(task);
+  schedule(job);
+}
+
+void WorkerPool::post(StrandId id, Task task) {
+  mPending.fetch_add(1, std::memory_order::relaxed);
+
+  auto job = acquire();
+  job->task = std::move(task);
+
+  Strand *strand;
+
+  {
+    // strand that is in the map is already scheduled or running
+    std::lock_guard lock(mStrandsMutex);
+
+    if (auto it = mStrands.find(id); it != mStrands.end()) {
+      it->second->tasks.push(job);
+      return;
+    }
+
+    strand = createStrand(id);
+    strand->tasks.push(job);
+  }
+
+  schedule(&strand->activation);
+}
+
+// Called with strands lock held
+WorkerPool::Strand *WorkerPool::createStrand(StrandId id) {
+  if (mFreeStrands.empty()) {
+    auto strand = std::make_unique<Strand>();
+    strand->id = id;
+    strand->activation.strand = strand.get();
+    return mStrands.emplace(id, std::move(strand)).first->second.get();
+  }
+
+  auto node = std::move(mFreeStrands.back());
+  mFreeStrands.pop_back();
+
+  node.key() = id;
+  node.mapped()->id = id;
+  return mStrands.insert(std::move(node)).position->second.get();
+}
+
+// Hands job to parked worker, busy ones would delay it until their current
+// task finishes. Without parked worker job waits in overflow for the first
+// worker that becomes free
+void WorkerPool::schedule(Job *job) {
+  auto count = mWorkers.size();
+  auto start = mNextWorker.fetch_add(1, std::memory_order::relaxed);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    auto worker = mWorkers[(start + i) % count].get();
+    auto state = kParked;
+
+    if (worker->state.load(std::memory_order::relaxed) == kParked &&
+        worker->state.compare_exchange_strong(state, kClaimed,
+                                              std::memory_order::seq_cst)) {
+      job->next = nullptr;
+      worker->handoff.store(job, std::memory_order::release);
+      worker->state.notify_one();
+      return;
+    }
+  }
+
+  mOverflow.push(job);
+  mOverflowSize.fetch_add(1, std::memory_order::seq_cst);
+
+  // worker that parked after the scan above has not seen the job
+  for (auto &worker : mWorkers) {
+    auto state = kParked;
+
+    if (worker->state.compare_exchange_strong(state, kRunning,
+                                              std::memory_order::seq_cst)) {
+      worker->state.notify_one();
+      break;
+    }
+  }
+}
+
+WorkerPool::Job *WorkerPool::takeOverflow() {
+  if (mOverflowSize.load(std::memory_order::acquire) == 0) {
+    return nullptr;
+  }
+
+  std::lock_guard lock(mOverflowMutex);
+
+  if (mOverflowTaken == nullptr) {
+    mOverflowTaken = mOverflow.popAll();
+  }
+
+  auto node = mOverflowTaken;
+  if (node == nullptr) {
+    return nullptr;
+  }
+
+  mOverflowTaken = node->next;
+  mOverflowSize.fetch_sub(1, std::memory_order::relaxed);
+  return static_cast<Job *>(node);
+}
+
+void WorkerPool::run(Worker &worker) {
+  gCurrentWorker = &worker;
+
+  while (!mStopping.load(std::memory_order::relaxed)) {
+    if (worker.state.load(std::memory_order::acquire) == kClaimed) {
+      // producer stores the job right after it claims the worker
+      auto job = worker.handoff.exchange(nullptr, std::memory_order::acquire);
+
+      if (job == nullptr) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      worker.state.store(kRunning, std::memory_order::relaxed);
+      execute(job);
+      continue;
+    }
+
+    if (auto job = takeOverflow()) {
+      execute(job);
+      continue;
+    }
+
+    worker.state.store(kParked, std::memory_order::seq_cst);
+
+    // producer that pushed to overflow may have seen running state
+    if (mOverflowSize.load(std::memory_order::seq_cst) != 0 ||
+        mStopping.load(std::memory_order::seq_cst)) {
+      auto state = kParked;
+      worker.state.compare_exchange_strong(state, kRunning,
+                                           std::memory_order::seq_cst);
+      continue;
+    }
+
+    worker.state.wait(kParked, std::memory_order::seq_cst);
+  }
+}
+
+void WorkerPool::execute(Job *job) {
+  if (job->strand != nullptr) {
+    runStrand(*job->strand);
+    return;
+  }
+
+  job->task();
+  recycle(job);
+  complete();
+}
+
+void WorkerPool::runStrand(Strand &strand) {
+  auto node = strand.tasks.popAll();
+
+  while (node != nullptr) {
+    if (mStopping.load(std::memory_order::relaxed)) {
+      release(node);
+      return;
+    }
+
+    auto job = static_cast<Job *>(node);
+    node = node->next;
+
+    job->task();
+    recycle(job);
+    complete();
+  }
+
+  {
+    // tasks are pushed under the lock, strand without them is retired
+    std::lock_guard lock(mStrandsMutex);
+
+    if (strand.tasks.empty()) {
+      mFreeStrands.push_back(mStrands.extract(strand.id));
+      return;
+    }
+  }
+
+  schedule(&strand.activation);
+}
+
+void WorkerPool::complete() {
+  if (mPending.fetch_sub(1, std::memory_order::acq_rel) == 1 && mOnIdle) {
+    mOnIdle();
+  }
+}
@@ -1,72 +1,80 @@
 #include "rpcsx/ui/extension.hpp"
+#include "rpcsx/ui/EventLoop.hpp"
+#include "rpcsx/ui/FrameCodec.hpp"
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include "rpcsx/ui/JsonReader.hpp"
+#include "rpcsx/ui/JsonScanner.hpp"
+#include "rpcsx/ui/JsonWriter.hpp"
+#include "rpcsx/ui/MessageArena.hpp"
+#include "rpcsx/ui/MpscQueue.hpp"
+#include "rpcsx/ui/OutboundBatcher.hpp"
+#include "rpcsx/ui/PendingCallTable.hpp"
+#include "rpcsx/ui/PerfectHash.hpp"
 #include "rpcsx/ui/Protocol.hpp"
+#include "rpcsx/ui/ProtocolFactory.hpp"
+#include "rpcsx/ui/TimerWheel.hpp"
 #include "rpcsx/ui/Transport.hpp"
+#include "rpcsx/ui/WorkerPool.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <charconv>
-#include <condition_variable>
+#include <chrono>
 #include <cstddef>
 #include <cstdio>
-#include <deque>
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <rpcsx-ui.hpp>
+#include <shared_mutex>
+#include <span>
+#include <stop_token>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
-
-#ifdef _WIN32
-#include <fcntl.h>
-#include <io.h>
-#endif
+#include <variant>
 
 using namespace rpcsx::ui;
 using namespace nlohmann;
 
-struct StdioTransport : Transport {
-#ifdef _WIN32
-  StdioTransport() {
-    _setmode(_fileno(stdin), _O_BINARY);
-    _setmode(_fileno(stdout), _O_BINARY);
-    _setmode(_fileno(stderr), _O_BINARY);
-  }
-#endif
-
-  void write(std::span<const std::byte> bytes) override {
-    while (true) {
-      auto count = std::fwrite(bytes.data(), 1, bytes.size(), stdout);
-
-      if (count <= 0) {
-        break;
-      }
-
-      if (count == bytes.size()) {
-        break;
-      }
+static ErrorCode getErrorCode(const RequestParamsError &error) {
+  return error.isSyntaxError() ? ErrorCode::ParseError
+                               : ErrorCode::InvalidParams;
+}
 
-      bytes = bytes.subspan(count);
-    }
-  }
+// Error passed to response handler of outbound call that failed locally
+static ArenaJson makeCallError(const ErrorInstance &error) {
+  return json(error);
+}
 
-  void read(std::span<std::byte> &bytes) override {
-    auto count = std::fread(bytes.data(), 1, bytes.size(), stdin);
-    bytes = bytes.subspan(0, count);
+// Error reported to caller of handler that failed with exception
+static ErrorInstance getErrorInstance(std::exception_ptr exception) {
+  try {
+    std::rethrow_exception(std::move(exception));
+  } catch (const RequestParamsError &error) {
+    return {getErrorCode(error)};
+  } catch (const std::exception &error) {
+    return {ErrorCode::InternalError, error.what()};
+  } catch (...) {
+    return {ErrorCode::InternalError};
   }
-
-  void flush() override { std::fflush(stdout); }
-};
+}
 
 template <typename T, typename Protocol>
 static auto createMethodHandler(Protocol *protocol) {
-  return [=](std::size_t id, json params) {
+  return [=](std::size_t id, const RequestParams &params) {
     typename T::Request request;
     try {
-      request = params;
-    } catch (const std::exception &) {
-      protocol->sendErrorResponse(id, {ErrorCode::InvalidParams});
+      request = params.get<typename T::Request>();
+    } catch (const RequestParamsError &error) {
+      protocol->sendErrorResponse(id, {getErrorCode(error)});
       return;
     }
 
@@ -76,19 +84,19 @@ static auto createMethodHandler(Protocol *protocol) {
       return;
     }
 
-    protocol->sendResponse(id, json(result.value()));
+    protocol->sendResult(id, ResponseResult(std::move(result.value())));
   };
 };
 
 template <typename T, typename Protocol>
   requires(!requires { typename T::Response; })
 static auto createNotifyHandler(Protocol *protocol) {
-  return [=](json params) {
+  return [=](const RequestParams &params) {
     typename T::Request request;
     try {
-      request = params;
-    } catch (const std::exception &) {
-      protocol->sendErrorResponse({ErrorCode::InvalidParams});
+      request = params.get<typename T::Request>();
+    } catch (const RequestParamsError &error) {
+      protocol->sendErrorResponse({getErrorCode(error)});
       return;
     }
 
@@ -96,425 +104,2147 @@ static auto createNotifyHandler(Protocol *protocol) {
   };
 };
 
+static void closeHandle(int handle) {
+  [[maybe_unused]] auto file = File::adopt(handle);
+}
+
 static std::span<const std::byte> asBytes(std::string_view text) {
   return {reinterpret_cast<const std::byte *>(text.data()), text.size()};
 }
 
-struct JsonRpcInterface {
-  std::map<std::string_view, json (*)(void *, const json &)> methods;
-  std::map<std::string_view, void (*)(void *, const json &)> notifications;
-
-  json call(ProtocolObject &object, std::string_view method,
-            const json &params) {
-    auto methodPtr = methods.at(method);
+// Serializes frames into reusable per thread buffer. Body is dumped after
+// space reserved for header, so complete frame is contiguous and steady state
+// serialization does not allocate
+struct FrameWriter {
+  static constexpr std::size_t kHeaderReserve = 128;
+
+  std::string buffer;
+  std::vector<std::byte> encoded;
+  std::string withHandles;
+
+  // Describe the last serialized frame
+  MessageFormat format = MessageFormat::Json;
+  FrameEncoding encoding = FrameEncoding::Identity;
+  std::size_t bodySize = 0;
+  std::size_t encodedSize = 0;
+
+  // Body is encoded when it is at least threshold bytes long and encoding
+  // makes it smaller
+  std::span<const std::byte>
+  serialize(const json &body, MessageFormat bodyFormat,
+            FrameEncoding bodyEncoding = FrameEncoding::Identity,
+            std::size_t threshold = 0) {
+    buffer.assign(kHeaderReserve, ' ');
+    format = bodyFormat;
+
+    switch (format) {
+    case MessageFormat::Json:
+      appendJsonText(buffer, body);
+      break;
+    case MessageFormat::MsgPack:
+      json::to_msgpack(body, buffer);
+      break;
+    case MessageFormat::Cbor:
+      json::to_cbor(body, buffer);
+      break;
+    }
 
-    return methodPtr(object.get(), params);
+    return finish(bodyEncoding, threshold);
   }
-  void notify(ProtocolObject &object, std::string_view notification,
-              const json &params) {
-    auto methodPtr = notifications.at(notification);
 
-    methodPtr(object.get(), params);
+  // JSON body written by writeBody(JsonWriter &) straight into the buffer
+  template <typename F>
+  std::span<const std::byte>
+  serializeJson(F &&writeBody,
+                FrameEncoding bodyEncoding = FrameEncoding::Identity,
+                std::size_t threshold = 0) {
+    buffer.assign(kHeaderReserve, ' ');
+    format = MessageFormat::Json;
+
+    JsonWriter writer(buffer);
+    writeBody(writer);
+    return finish(bodyEncoding, threshold);
   }
-};
 
-struct JsonRpcInterfaceBuilder : InterfaceBuilder {
-  JsonRpcInterface &result;
+  // Frame that carries descriptors lists their ids in `Content-Handles`
+  // header, bodies of such frames are small so it is prepended with copy
+  std::span<const std::byte>
+  serialize(const json &body, MessageFormat bodyFormat,
+            std::span<const std::uint64_t> handleIds) {
+    auto frame = serialize(body, bodyFormat);
 
-  JsonRpcInterfaceBuilder(JsonRpcInterface &interface) : result(interface) {}
+    if (handleIds.empty()) {
+      return frame;
+    }
 
-  void addMethodHandler(std::string_view method,
-                        json (*handler)(void *, const json &)) {
-    result.methods[method] = handler;
+    withHandles = "Content-Handles: ";
+
+    for (std::size_t i = 0; i < handleIds.size(); ++i) {
+      if (i > 0) {
+        withHandles += ',';
+      }
+
+      withHandles += std::to_string(handleIds[i]);
+    }
+
+    withHandles += "\r\n";
+    withHandles.append(reinterpret_cast<const char *>(frame.data()),
+                       frame.size());
+    return asBytes(withHandles);
   }
 
-  void addNotificationHandler(std::string_view notification,
-                              void (*handler)(void *, const json &)) {
-    result.notifications[notification] = handler;
+private:
+  std::span<const std::byte> finish(FrameEncoding bodyEncoding,
+                                    std::size_t threshold) {
+    auto content = asBytes(std::string_view(buffer).substr(kHeaderReserve));
+    bodySize = content.size();
+    encodedSize = content.size();
+    encoding = FrameEncoding::Identity;
+
+    if (bodyEncoding != FrameEncoding::Identity && bodySize >= threshold) {
+      encoded.resize(kHeaderReserve);
+
+      if (encodeFrame(bodyEncoding, content, encoded) &&
+          encoded.size() - kHeaderReserve < bodySize) {
+        encoding = bodyEncoding;
+        encodedSize = encoded.size() - kHeaderReserve;
+        return writeHeader(std::span(encoded));
+      }
+    }
+
+    return writeHeader(std::span(buffer.data(), buffer.size()));
   }
-};
 
-struct JsonRpcProtocol : Protocol {
-  std::map<std::string_view, JsonRpcInterface> interfaces;
-  std::unordered_map<unsigned, std::pair<ProtocolObject, JsonRpcInterface *>>
-      objects;
-  std::deque<std::function<void()>> processQueue;
-  std::condition_variable processQueueCv;
-  std::mutex processQueueMtx;
-  std::atomic<bool> exit{false};
-  std::thread processorThread = std::thread{[this] {
-    while (exit.load(std::memory_order::relaxed) == false) {
-      std::function<void()> cb;
+  template <typename T>
+  std::span<const std::byte> writeHeader(std::span<T> frame) {
+    constexpr std::string_view lengthPrefix = "Content-Length: ";
+    constexpr std::string_view encodingPrefix = "\r\nContent-Encoding: ";
+    constexpr std::string_view typePrefix = "\r\nContent-Type: ";
+    constexpr std::string_view suffix = "\r\n\r\n";
+
+    char header[kHeaderReserve];
+    char *end = header;
+    auto append = [&](std::string_view text) {
+      end = std::copy(text.begin(), text.end(), end);
+    };
+
+    append(lengthPrefix);
+    end = std::to_chars(end, header + sizeof(header), encodedSize).ptr;
+
+    if (encoding != FrameEncoding::Identity) {
+      append(encodingPrefix);
+      append(getFrameEncodingName(encoding));
+    }
 
-      {
-        std::unique_lock lock(processQueueMtx);
+    if (format != MessageFormat::Json) {
+      append(typePrefix);
+      append(getMessageFormatContentType(format));
+    }
 
-        while (processQueue.empty()) {
-          processQueueCv.wait(lock);
+    append(suffix);
 
-          if (exit.load(std::memory_order::relaxed)) {
-            return;
-          }
-        }
+    std::size_t headerSize = end - header;
+    std::size_t frameOffset = kHeaderReserve - headerSize;
+    std::memcpy(frame.data() + frameOffset, header, headerSize);
 
-        cb = std::move(processQueue.front());
-        processQueue.pop_front();
-      }
+    return std::as_bytes(frame.subspan(frameOffset));
+  }
+};
 
-      cb();
+// Handlers of interface in perfect hash table. Generated builders provide
+// table layout, handlers of other builders are laid out as they are added
+template <typename Handler> struct HandlerTable {
+  struct Entry {
+    std::string_view name;
+    Handler handler = nullptr;
+    bool reentrant = false;
+  };
+
+  std::vector<Entry> slots;
+  std::uint32_t seed = 0;
+
+  void setLayout(std::uint32_t layoutSeed,
+                 std::span<const std::string_view> names) {
+    if (!std::has_single_bit(names.size())) {
+      return;
     }
-  }};
 
-  JsonRpcProtocol(Transport *transport) : Protocol(transport) {
-    mMethodHandlers["$/initialize"] = createMethodHandler<Initialize>(this);
-    mMethodHandlers["$/activate"] = createMethodHandler<Activate>(this);
-    mMethodHandlers["$/deactivate"] = createMethodHandler<Deactivate>(this);
-    mMethodHandlers["$/shutdown"] = createMethodHandler<Shutdown>(this);
+    seed = layoutSeed;
+    slots.assign(names.size(), {});
 
-    mMethodHandlers["$/object/call"] = createMethodHandler<ObjectCall>(this);
-    mNotifyHandlers["$/object/notify"] =
-        createNotifyHandler<ObjectNotify>(this);
-    mMethodHandlers["$/object/destroy"] =
-        createMethodHandler<ObjectDestroy>(this);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      slots[i].name = names[i];
+    }
   }
 
-  ~JsonRpcProtocol() {
-    exit = true;
-    processQueueCv.notify_one();
-    processorThread.join();
-  }
+  // Handlers outside of the layout are collected and placed by build()
+  std::vector<Entry> pending;
 
-  void pushProcessQueue(std::function<void()> cb) {
-    std::lock_guard lock(processQueueMtx);
-    processQueue.push_back(std::move(cb));
-    processQueueCv.notify_one();
-  }
+  void add(std::string_view name, Handler handler, bool reentrant) {
+    if (!slots.empty()) {
+      auto &slot = slots[hashName(name, seed) & (slots.size() - 1)];
 
-  Response<Initialize> handle(const Request<Initialize> &request) {
-    return getHandlers().handle(request);
-  }
-  Response<Activate> handle(const Request<Activate> &request) {
-    return getHandlers().handle(request);
+      if (slot.name == name) {
+        slot.handler = handler;
+        slot.reentrant = reentrant;
+        return;
+      }
+    }
+
+    for (auto &entry : pending) {
+      if (entry.name == name) {
+        entry = {name, handler, reentrant};
+        return;
+      }
+    }
+
+    pending.push_back({name, handler, reentrant});
   }
-  Response<Deactivate> handle(const Request<Deactivate> &request) {
-    return getHandlers().handle(request);
+
+  void build() {
+    if (pending.empty()) {
+      return;
+    }
+
+    std::vector<Entry> entries = std::move(pending);
+    pending.clear();
+
+    for (auto &slot : slots) {
+      if (slot.handler != nullptr) {
+        entries.push_back(slot);
+      }
+    }
+
+    std::vector<std::string_view> names;
+    for (auto &entry : entries) {
+      names.push_back(entry.name);
+    }
+
+    auto size = getPerfectHashSize(names.size());
+    auto newSeed = findPerfectHashSeed(names, size);
+
+    while (!newSeed) {
+      size *= 2;
+      newSeed = findPerfectHashSeed(names, size);
+    }
+
+    seed = *newSeed;
+    slots.assign(size, {});
+
+    for (auto &entry : entries) {
+      slots[hashName(entry.name, seed) & (size - 1)] = entry;
+    }
   }
-  Response<Shutdown> handle(const Request<Shutdown> &request) {
-    return getHandlers().handle(request);
+
+  const Entry *find(std::string_view name) const {
+    if (slots.empty()) {
+      return nullptr;
+    }
+
+    auto &slot = slots[hashName(name, seed) & (slots.size() - 1)];
+    return slot.handler != nullptr && slot.name == name ? &slot : nullptr;
   }
+};
 
-  std::expected<json, ErrorInstance>
-  handle(const Request<ObjectCall> &request) {
-    auto it = objects.find(request.object);
-    if (it != objects.end()) {
-      auto &[object, interface] = it->second;
-      return interface->call(object, request.method, request.params);
+struct JsonRpcInterface {
+  HandlerTable<ResponseResult (*)(void *, const RequestParams &)> methods;
+  HandlerTable<Task<ResponseResult> (*)(void *, const RequestParams &)>
+      asyncMethods;
+  HandlerTable<void (*)(void *, const RequestParams &)> notifications;
+
+  std::expected<ResponseResult, ErrorInstance>
+  call(ProtocolObject &object, std::string_view method,
+       const RequestParams &params) {
+    if (auto entry = methods.find(method)) {
+      try {
+        return entry->handler(object.get(), params);
+      } catch (const RequestParamsError &error) {
+        return std::unexpected(ErrorInstance{getErrorCode(error)});
+      }
     }
 
-    return {};
+    return std::unexpected(
+        ErrorInstance{ErrorCode::MethodNotFound, std::string(method)});
   }
 
-  void handle(const Request<ObjectNotify> &request) {
-    auto it = objects.find(request.object);
-    if (it != objects.end()) {
-      auto &[object, interface] = it->second;
-      interface->notify(object, request.notification, request.params);
+  // std::nullopt if method has no async handler. Throws
+  // RequestParamsError
+  std::optional<Task<ResponseResult>> callAsync(ProtocolObject &object,
+                                                std::string_view method,
+                                                const RequestParams &params) {
+    if (auto entry = asyncMethods.find(method)) {
+      return entry->handler(object.get(), params);
     }
+
+    return std::nullopt;
   }
 
-  Response<ObjectDestroy> handle(const Request<ObjectDestroy> &request) {
-    objects.erase(request.object);
-    return {};
+  // Throws RequestParamsError
+  void notify(ProtocolObject &object, std::string_view notification,
+              const RequestParams &params) {
+    if (auto entry = notifications.find(notification)) {
+      entry->handler(object.get(), params);
+    }
   }
 
-  void addObject(std::string_view interfaceName,
-                 void (*builder)(InterfaceBuilder &builder), unsigned id,
-                 ProtocolObject object) override {
-    auto [it, inserted] = interfaces.emplace(interfaceName, JsonRpcInterface{});
+  bool isReentrant(std::string_view name, bool isNotification) const {
+    if (isNotification) {
+      auto entry = notifications.find(name);
+      return entry != nullptr && entry->reentrant;
+    }
 
-    if (inserted) {
-      JsonRpcInterfaceBuilder interfaceBuilder(it->second);
-      builder(interfaceBuilder);
+    if (auto entry = asyncMethods.find(name)) {
+      return entry->reentrant;
     }
 
-    objects.emplace(id, std::pair{std::move(object), &it->second});
+    auto entry = methods.find(name);
+    return entry != nullptr && entry->reentrant;
   }
+};
 
-  void call(std::string_view method, json params,
-            std::function<void(json, bool isError)> responseHandler) override {
-    std::size_t id = mNextId++;
-    send({
-        {"jsonrpc", "2.0"},
-        {"method", method},
-        {"params", std::move(params)},
-        {"id", id},
-    });
+struct JsonRpcInterfaceBuilder : InterfaceBuilder {
+  JsonRpcInterface &result;
 
-    mExpectedResponses.emplace(id, std::move(responseHandler));
-  }
+  JsonRpcInterfaceBuilder(JsonRpcInterface &interface) : result(interface) {}
 
-  void notify(std::string_view method, json params) override {
-    send({
-        {"jsonrpc", "2.0"},
-        {"method", method},
-        {"params", std::move(params)},
-    });
+  void setMethodTable(std::uint32_t seed,
+                      std::span<const std::string_view> slots) override {
+    result.methods.setLayout(seed, slots);
+    result.asyncMethods.setLayout(seed, slots);
   }
 
-  void sendResponse(std::size_t id, json result) override {
-    send({
-        {"jsonrpc", "2.0"},
-        {"id", id},
-        {"result", std::move(result)},
-    });
+  void setNotificationTable(std::uint32_t seed,
+                            std::span<const std::string_view> slots) override {
+    result.notifications.setLayout(seed, slots);
   }
-  void sendErrorResponse(std::size_t id, ErrorInstance error) override {
-    send({
-        {"jsonrpc", "2.0"},
-        {"id", id},
-        {"error", error},
-    });
+
+  void addMethodHandler(std::string_view method,
+                        ResponseResult (*handler)(void *,
+                                                  const RequestParams &),
+                        bool reentrant) override {
+    result.methods.add(method, handler, reentrant);
   }
-  void sendErrorResponse(ErrorInstance error) override {
-    send({
-        {"jsonrpc", "2.0"},
-        {"id", nullptr},
-        {"error", error},
-    });
+
+  void addAsyncMethodHandler(std::string_view method,
+                             Task<ResponseResult> (*handler)(
+                                 void *, const RequestParams &),
+                             bool reentrant) override {
+    result.asyncMethods.add(method, handler, reentrant);
   }
 
   void addNotificationHandler(std::string_view notification,
-                              std::function<void(json)> handler) override {
-    mNotifyHandlers[std::string(notification)] = std::move(handler);
+                              void (*handler)(void *, const RequestParams &),
+                              bool reentrant) override {
+    result.notifications.add(notification, handler, reentrant);
+  }
+
+  // Called once all handlers are added
+  void build() {
+    result.methods.build();
+    result.asyncMethods.build();
+    result.notifications.build();
   }
+};
+
+// Protocol methods are found in compile time table, handlers added at runtime
+// under other names go to the map. Each name gets its own strand, builtin
+// ones by their index in the table, others in order they were first added
+template <typename Handler, std::size_t N> struct ProtocolHandlers {
+  struct Entry {
+    Handler handler;
+    WorkerPool::StrandId strand = 0;
+    bool reentrant = false;
+  };
 
-  void
-  addMethodHandler(std::string_view method,
-                   std::function<void(std::size_t, json)> handler) override {
-    mMethodHandlers[std::string(method)] = std::move(handler);
+  const PerfectHashTable<N> &names;
+  WorkerPool::StrandId firstStrand;
+  std::array<Entry, N> builtin;
+  std::map<std::string, Entry, std::less<>> other;
+
+  ProtocolHandlers(const PerfectHashTable<N> &names,
+                   WorkerPool::StrandId firstStrand)
+      : names(names), firstStrand(firstStrand) {}
+
+  void set(std::string_view name, Handler handler, bool reentrant = false) {
+    Entry *entry;
+
+    if (auto index = names.find(name); index >= 0) {
+      entry = &builtin[index];
+      entry->strand = firstStrand + index;
+    } else if (auto it = other.find(name); it != other.end()) {
+      entry = &it->second;
+    } else {
+      entry = &other[std::string(name)];
+      entry->strand = firstStrand + N + other.size() - 1;
+    }
+
+    entry->handler = std::move(handler);
+    entry->reentrant = reentrant;
   }
 
-  void onEvent(std::string_view method,
-               std::function<void(json)> eventHandler) override {
-    mEventHandlers[std::string(method)].push_back(std::move(eventHandler));
+  const Handler *find(std::string_view name) const {
+    auto entry = findEntry(name);
+    return entry != nullptr ? &entry->handler : nullptr;
   }
 
-  void sendLogMessage(LogLevel level, std::string_view message) override {
-    // FIXME
-    std::fprintf(stderr, "%s\n", std::string(message).c_str());
+  // std::nullopt for reentrant and unknown handlers
+  std::optional<WorkerPool::StrandId> getStrand(std::string_view name) const {
+    auto entry = findEntry(name);
+    if (entry == nullptr || entry->reentrant) {
+      return std::nullopt;
+    }
+
+    return entry->strand;
   }
 
-  int processMessages() override {
-    std::string header;
-    std::vector<std::byte> buffer;
-
-    while (true) {
-      header.clear();
-
-      while (true) {
-        std::byte b;
-        std::span bytes = {&b, 1};
-        getTransport()->read(bytes);
-        if (!bytes.empty()) {
-          header += static_cast<char>(b);
-        }
+private:
+  const Entry *findEntry(std::string_view name) const {
+    if (auto index = names.find(name); index >= 0) {
+      return builtin[index].handler ? &builtin[index] : nullptr;
+    }
+
+    if (auto it = other.find(name); it != other.end()) {
+      return &it->second;
+    }
+
+    return nullptr;
+  }
+};
+
+static constexpr std::string_view kProtocolMethodNames[] = {
+    "$/initialize", "$/activate",    "$/deactivate",     "$/shutdown",
+    "$/object/call", "$/object/destroy",
+};
+static constexpr std::string_view kProtocolNotificationNames[] = {
+    "$/object/notify",
+    "$/object/destroy",
+};
 
-        if (header.ends_with("\r\n\r\n")) {
-          break;
+static constexpr auto kProtocolMethods =
+    makePerfectHashTable(kProtocolMethodNames);
+static constexpr auto kProtocolNotifications =
+    makePerfectHashTable(kProtocolNotificationNames);
+
+struct JsonRpcProtocol : Protocol {
+  // Descriptors received with a message, the ones handler did not claim are
+  // closed once the message is processed
+  struct ReceivedHandles {
+    JsonRpcProtocol *protocol;
+    std::vector<std::uint64_t> ids;
+
+    ~ReceivedHandles() {
+      std::lock_guard lock(protocol->mHandlesMutex);
+
+      for (auto id : ids) {
+        if (auto it = protocol->mIncomingHandles.find(id);
+            it != protocol->mIncomingHandles.end()) {
+          closeHandle(it->second);
+          protocol->mIncomingHandles.erase(it);
         }
       }
+    }
+  };
 
-      constexpr std::string_view contentLength = "Content-Length:";
-      auto contentLengthPos = header.find_first_of(contentLength);
-      if (contentLengthPos == std::string_view::npos) {
-        continue;
-      }
+  using HandleLease = std::shared_ptr<ReceivedHandles>;
 
-      std::string_view lengthString = std::string_view(header).substr(
-          contentLengthPos + contentLength.size());
+  // Responses of inbound batch. Pending counts unanswered requests plus
+  // one for dispatch of the batch itself
+  struct InboundBatch {
+    std::mutex mutex;
+    json responses = json::array();
+    std::atomic<std::size_t> pending{1};
+  };
 
-      auto lineEnd = lengthString.find_first_of("\r\n");
-      if (lineEnd == std::string_view::npos) {
-        continue;
-      }
+  // Requests with ids handlers cannot see are given batch request ids too,
+  // ones outside of batch have no batch and are answered on their own
+  struct BatchRequest {
+    std::shared_ptr<InboundBatch> batch;
+    json id;
+  };
 
-      lengthString = lengthString.substr(0, lineEnd);
+  // Resolution of outbound call deadlines
+  static constexpr std::chrono::milliseconds kDeadlineTick{10};
+
+  // Request routed from pre-scan of JSON frame. Params stay raw text until
+  // worker that runs handler decodes them. Strings point into the frame,
+  // which is leased until request is dispatched
+  struct RawRequest {
+    std::string_view method;
+    std::optional<std::size_t> id;
+    RequestParams params;
+    std::optional<std::uint64_t> object;
+    std::string_view handlerName;
+    FrameLease buffer;
+  };
 
-      while (lengthString.starts_with(' ')) {
-        lengthString.remove_prefix(1);
-      }
+  // Elements of batch, requests are routed like single messages and anything
+  // else is left as DOM
+  struct RawBatch {
+    std::vector<std::variant<json, RawRequest>> items;
+  };
+
+  // Message that was not pre-scanned as request, most often a response. It
+  // is decoded on event loop thread straight from the frame
+  struct RawMessage {
+    MessageFormat format;
+    std::span<const std::byte> body;
+    FrameLease buffer;
+  };
 
-      std::size_t length = 0;
-      auto [ptr, ec] =
-          std::from_chars(lengthString.data(),
-                          lengthString.data() + lengthString.size(), length);
+  using InboundMessage = std::variant<json, RawRequest, RawBatch, RawMessage>;
 
-      if (ec != std::errc{} ||
-          ptr != lengthString.data() + lengthString.size()) {
-        continue;
-      }
+  using MethodHandler = UniqueFunction<void(std::size_t, RequestParams)>;
+  using NotifyHandler = UniqueFunction<void(RequestParams)>;
 
-      buffer.resize(length);
+  // Inbound message queued for worker that runs its handler
+  struct PendingMessage : MpscNode {
+    const MethodHandler *method = nullptr;
+    const NotifyHandler *notification = nullptr;
+    std::size_t id = 0;
+    RequestParams params;
+    HandleLease handles;
+    std::stop_token stopToken;
+    std::optional<WorkerPool::StrandId> strand;
+  };
 
-      std::span bytes = {buffer};
-      getTransport()->read(bytes);
+  // Messages are taken on event loop thread and come back from workers once
+  // their handler returns. Slots are reused, so queuing message does not
+  // allocate after enough of them were in flight at the same time
+  class MessagePool {
+  public:
+    struct Release {
+      MessagePool *pool;
 
-      if (bytes.size() != buffer.size()) {
-        std::fprintf(stderr, "input truncated\n");
-        std::abort();
+      void operator()(PendingMessage *message) const {
+        pool->release(message);
       }
+    };
 
-      std::string_view content = {
-          (char *)buffer.data(),
-          buffer.size(),
-      };
+    using Ptr = std::unique_ptr<PendingMessage, Release>;
 
-      handleRequest(json::parse(content));
+    MessagePool() = default;
+    MessagePool(const MessagePool &) = delete;
+    MessagePool &operator=(const MessagePool &) = delete;
+
+    ~MessagePool() {
+      free(mFree.popAll());
+      free(mCached);
     }
 
-    return 0;
-  }
+    // Event loop thread only
+    Ptr acquire() {
+      if (mCached == nullptr) {
+        mCached = mFree.popAll();
+      }
 
-  void handleRequest(json message) {
-    auto handlers = getHandlers();
+      if (auto node = mCached) {
+        mCached = node->next;
+        return Ptr(static_cast<PendingMessage *>(node), Release{this});
+      }
 
-    if (auto it = message.find("method"); it != message.end()) {
-      std::string method = it.value();
+      mAllocations.fetch_add(1, std::memory_order::relaxed);
+      return Ptr(new PendingMessage, Release{this});
+    }
 
-      std::size_t id = 0;
-      bool hasId = false;
+    std::uint64_t getAllocations() const {
+      return mAllocations.load(std::memory_order::relaxed);
+    }
 
-      if (auto it = message.find("id"); it != message.end() && !it->is_null()) {
-        hasId = true;
-        id = it.value();
+  private:
+    // Params and descriptors are released with the message
+    void release(PendingMessage *message) {
+      message->method = nullptr;
+      message->notification = nullptr;
+      message->params = {};
+      message->handles = {};
+      message->stopToken = {};
+      message->strand = std::nullopt;
+      mFree.push(message);
+    }
+
+    static void free(MpscNode *node) {
+      while (node != nullptr) {
+        auto next = node->next;
+        delete static_cast<PendingMessage *>(node);
+        node = next;
       }
+    }
 
-      json params;
+    MpscQueue mFree;
+    MpscNode *mCached = nullptr;
+    std::atomic<std::uint64_t> mAllocations{0};
+  };
 
-      if (auto it = message.find("params"); it != message.end()) {
-        params = it.value();
-      }
+  // Ids handlers see for requests that came in batch
+  static constexpr std::size_t kBatchRequestId = ~(~std::size_t(0) >> 1);
 
-      if (hasId) {
-        if (auto it = mMethodHandlers.find(method);
-            it != mMethodHandlers.end()) {
-          pushProcessQueue([cb = it->second, id, params = std::move(params)] {
-            cb(id, params);
-          });
-          return;
-        }
+  // Calls in flight keep the object alive after it was destroyed
+  struct ObjectEntry {
+    ProtocolObject object;
+    JsonRpcInterface *interface;
+  };
 
-        sendErrorResponse(id, {ErrorCode::MethodNotFound, method});
-        return;
-      }
+  // Handlers of the same object or of the same top level method share a
+  // strand, object strands are tagged with the high bit and notification
+  // strands with the next one
+  static constexpr WorkerPool::StrandId kObjectStrand = 1ull << 63;
+  static constexpr WorkerPool::StrandId kNotificationStrand = 1ull << 62;
 
-      if (auto it = mNotifyHandlers.find(method); it != mNotifyHandlers.end()) {
-        pushProcessQueue(
-            [cb = it->second, params = std::move(params)] { cb(params); });
+  std::map<std::string_view, JsonRpcInterface> interfaces;
+  std::unordered_map<unsigned, std::shared_ptr<ObjectEntry>> objects;
+  std::shared_mutex objectsMutex;
+  EventLoop loop;
+  OutboundBatcher outbound;
+
+  // outlives workers, tasks they discard on stop return their messages
+  MessagePool messages;
+  WorkerPool workers;
+
+  JsonRpcProtocol(Transport *transport, const ProtocolOptions &options,
+                  MessageFormat format = MessageFormat::Json)
+      : Protocol(transport), outbound(transport, loop, options.outbound),
+        workers(
+            options.workerThreads,
+            [this] { outbound.flush(OutboundBatcher::FlushReason::Idle); },
+            [this] { Protocol::setThreadDefault(this); }),
+        mCallTimeout(options.callTimeout),
+        mDeadlineEpoch(EventLoop::Clock::now()),
+        mCompressionThreshold(options.compressionThreshold),
+        mMessageFormat(format) {
+    mMethodHandlers.set("$/initialize", createMethodHandler<Initialize>(this));
+    mMethodHandlers.set("$/activate", createMethodHandler<Activate>(this));
+    mMethodHandlers.set("$/deactivate", createMethodHandler<Deactivate>(this));
+    mMethodHandlers.set("$/shutdown", createMethodHandler<Shutdown>(this));
+
+    mMethodHandlers.set("$/object/call", [this](std::size_t id,
+                                                RequestParams params) {
+      ObjectMessage message;
+      try {
+        message = decodeObjectMessage(std::move(params), "method");
+      } catch (const RequestParamsError &error) {
+        sendErrorResponse(id, {getErrorCode(error)});
         return;
       }
 
-      sendErrorResponse({ErrorCode::MethodNotFound, method});
-      return;
-    }
-
-    {
-      bool hasId = false;
-      std::size_t id = 0;
-
-      if (auto it = message.find("id"); it != message.end() && !it->is_null()) {
-        hasId = true;
-        id = it.value();
+      callObject(id, message);
+    });
+    mNotifyHandlers.set("$/object/notify", [this](RequestParams params) {
+      ObjectMessage message;
+      try {
+        message = decodeObjectMessage(std::move(params), "notification");
+      } catch (const RequestParamsError &error) {
+        sendErrorResponse({getErrorCode(error)});
+        return;
       }
 
-      if (!hasId) {
+      notifyObject(message);
+    });
+    mMethodHandlers.set("$/object/destroy",
+                        createMethodHandler<ObjectDestroy>(this));
+
+    // host destroys objects without waiting for response
+    mNotifyHandlers.set("$/object/destroy", [this](RequestParams params) {
+      Request<ObjectDestroy> request;
+      try {
+        request = params.get<Request<ObjectDestroy>>();
+      } catch (const RequestParamsError &error) {
+        sendErrorResponse({getErrorCode(error)});
         return;
       }
 
-      if (auto it = mExpectedResponses.find(id);
-          it != mExpectedResponses.end()) {
-        auto impl = std::move(it->second);
-        mExpectedResponses.erase(it);
-        if (auto it = message.find("result"); it != message.end()) {
-          json result = it.value();
-          impl(result, false);
-        } else if (auto it = message.find("error"); it != message.end()) {
-          json error = it.value();
-          impl(error, true);
-        }
+      handle(request);
+    });
+  }
+
+  ~JsonRpcProtocol() {
+    workers.stop();
+
+    for (auto handles : {&mOutgoingHandles, &mIncomingHandles}) {
+      for (auto [id, handle] : *handles) {
+        closeHandle(handle);
       }
     }
   }
 
-private:
-  void send(json body) {
-    std::string bodyText = body.dump();
-    std::string header = "Content-Length: ";
-    header += std::to_string(bodyText.length());
-    header += "\r\n\r\n";
+  std::shared_ptr<ObjectEntry> findObject(unsigned id) {
+    std::shared_lock lock(objectsMutex);
 
-    getTransport()->write(asBytes(header));
-    getTransport()->write(asBytes(bodyText));
-    getTransport()->flush();
-  }
+    if (auto it = objects.find(id); it != objects.end()) {
+      return it->second;
+    }
 
-  std::map<std::string, std::function<void(std::size_t, json)>> mMethodHandlers;
-  std::map<std::string, std::function<void(json)>> mNotifyHandlers;
-  std::map<std::string, std::vector<std::function<void(json)>>> mEventHandlers;
-  std::map<std::size_t, std::function<void(json, bool isError)>>
-      mExpectedResponses;
-  std::size_t mNextId = 1;
-};
+    return {};
+  }
 
-ExtensionBuilder extension_main(int argc, const char *argv[]);
+  // Returns std::nullopt for handlers that may run on any worker. Object
+  // methods pass object id and handler name from their params
+  std::optional<WorkerPool::StrandId>
+  getStrand(std::string_view method, bool isNotification,
+            std::optional<std::uint64_t> object,
+            std::string_view handlerName) {
+    bool isCall = method == "$/object/call";
+    bool isNotify = method == "$/object/notify";
+
+    if ((!isCall && !isNotify && method != "$/object/destroy") || !object) {
+      return isNotification ? mNotifyHandlers.getStrand(method)
+                            : mMethodHandlers.getStrand(method);
+    }
 
-int main(int argc, const char *argv[]) {
-  auto extensionBuilder = extension_main(argc, argv);
+    auto id = static_cast<unsigned>(*object);
 
-  std::string_view transportId;
-  std::string_view protocolId;
+    if ((isCall || isNotify) && !handlerName.empty()) {
+      if (auto entry = findObject(id);
+          entry && entry->interface->isReentrant(handlerName, isNotify)) {
+        return std::nullopt;
+      }
+    }
 
-  for (int i = 1; i < argc - 1; ++i) {
-    if (argv[i] == std::string_view("--rpcsx-ui/transport")) {
-      transportId = argv[i + 1];
-      ++i;
+    return kObjectStrand | id;
+  }
 
-      continue;
+  std::optional<WorkerPool::StrandId>
+  getStrand(std::string_view method, bool isNotification, const json &params) {
+    if (!params.is_object()) {
+      return getStrand(method, isNotification, std::nullopt, {});
     }
 
-    if (argv[i] == std::string_view("--rpcsx-ui/protocol")) {
-      protocolId = argv[i + 1];
-      ++i;
+    std::optional<std::uint64_t> object;
+    std::string_view handlerName;
 
-      continue;
+    if (auto it = params.find("object");
+        it != params.end() && it->is_number_unsigned()) {
+      object = it->get<std::uint64_t>();
     }
-  }
 
-  if (transportId.empty()) {
-    transportId = "stdio";
-  }
+    if (auto it = params.find(getHandlerNameKey(method));
+        it != params.end() && it->is_string()) {
+      handlerName = it->get_ref<const std::string &>();
+    }
 
-  if (protocolId.empty()) {
-    protocolId = "json-rpc";
+    return getStrand(method, isNotification, object, handlerName);
   }
 
-  std::unique_ptr<Transport> transport;
+  static std::string_view getHandlerNameKey(std::string_view method) {
+    return method == "$/object/notify" ? "notification" : "method";
+  }
 
-  if (transportId == "stdio") {
-    transport = std::make_unique<StdioTransport>();
-  } else {
-    return 1;
+  void dispatch(std::optional<WorkerPool::StrandId> strand,
+                WorkerPool::Task task) {
+    if (strand) {
+      workers.post(*strand, std::move(task));
+    } else {
+      workers.post(std::move(task));
+    }
   }
 
-  std::unique_ptr<Protocol> protocol;
+  Response<Initialize> handle(const Request<Initialize> &request) {
+    auto response = getHandlers().handle(request);
+
+    if (response) {
+      negotiateMessageFormat(request.client.capabilities,
+                             response->extension);
+      negotiateFrameEncoding(request.client.capabilities,
+                             response->extension);
+    }
 
-  if (protocolId == "json-rpc") {
-    protocol = std::make_unique<JsonRpcProtocol>(transport.get());
-  } else {
-    return 1;
+    return response;
+  }
+  Response<Activate> handle(const Request<Activate> &request) {
+    return getHandlers().handle(request);
+  }
+  Response<Deactivate> handle(const Request<Deactivate> &request) {
+    return getHandlers().handle(request);
+  }
+  Response<Shutdown> handle(const Request<Shutdown> &request) {
+    return getHandlers().handle(request);
+  }
+
+  // Envelope of $/object/call and $/object/notify. Params are left for the
+  // object handler, which decodes them into its request type
+  struct ObjectMessage {
+    std::int64_t object = 0;
+    std::string name;
+    RequestParams params;
+  };
+
+  // Throws RequestParamsError
+  static ObjectMessage decodeObjectMessage(RequestParams params,
+                                           std::string_view nameKey) {
+    ObjectMessage message;
+    auto text = params.getText();
+
+    if (!text) {
+      auto body = std::move(params).toJson().value();
+
+      try {
+        message.object = body.at("object");
+        message.name = body.at(nameKey);
+
+        if (auto it = body.find("params"); it != body.end()) {
+          message.params = std::move(*it);
+        }
+      } catch (const json::exception &) {
+        throw RequestParamsError(JsonReader::Error::Type);
+      }
+
+      return message;
+    }
+
+    JsonReader reader(*text);
+    std::string_view paramsText;
+    bool foundObject = false;
+    bool foundName = false;
+
+    bool result = reader.readObject([&](std::string_view key) {
+      if (key == "object") {
+        foundObject = true;
+        return read_json(reader, message.object);
+      }
+
+      if (key == nameKey) {
+        foundName = true;
+        return read_json(reader, message.name);
+      }
+
+      if (key == "params") {
+        return reader.readRaw(paramsText);
+      }
+
+      return reader.skip();
+    });
+
+    if (!result || !reader.require(foundObject && foundName) ||
+        !reader.finish()) {
+      throw RequestParamsError(reader.error());
+    }
+
+    message.params = params.getPart(paramsText);
+    return message;
+  }
+
+  void callObject(std::size_t id, const ObjectMessage &message) {
+    auto entry = findObject(message.object);
+    if (!entry) {
+      sendResponse(id, {});
+      return;
+    }
+
+    std::optional<Task<ResponseResult>> task;
+    try {
+      task = entry->interface->callAsync(entry->object, message.name,
+                                         message.params);
+    } catch (const RequestParamsError &error) {
+      sendErrorResponse(id, {getErrorCode(error)});
+      return;
+    }
+
+    if (task) {
+      spawn(
+          std::move(*task),
+          [this, id, entry](ResponseResult result) {
+            sendResult(id, std::move(result));
+          },
+          [this, id, entry](std::exception_ptr exception) {
+            sendErrorResponse(id, getErrorInstance(exception));
+          });
+      return;
+    }
+
+    auto result =
+        entry->interface->call(entry->object, message.name, message.params);
+
+    if (!result.has_value()) {
+      sendErrorResponse(id, result.error());
+      return;
+    }
+
+    sendResult(id, std::move(result.value()));
+  }
+
+  void notifyObject(const ObjectMessage &message) {
+    auto entry = findObject(message.object);
+    if (!entry) {
+      return;
+    }
+
+    try {
+      entry->interface->notify(entry->object, message.name, message.params);
+    } catch (const RequestParamsError &error) {
+      sendErrorResponse({getErrorCode(error)});
+    }
+  }
+
+  Response<ObjectDestroy> handle(const Request<ObjectDestroy> &request) {
+    std::shared_ptr<ObjectEntry> entry;
+
+    {
+      std::lock_guard lock(objectsMutex);
+      if (auto it = objects.find(request.object); it != objects.end()) {
+        entry = std::move(it->second);
+        objects.erase(it);
+      }
+    }
+
+    return {};
+  }
+
+  void addObject(std::string_view interfaceName,
+                 void (*builder)(InterfaceBuilder &builder), unsigned id,
+                 ProtocolObject object) override {
+    std::lock_guard lock(objectsMutex);
+    auto [it, inserted] = interfaces.emplace(interfaceName, JsonRpcInterface{});
+
+    if (inserted) {
+      JsonRpcInterfaceBuilder interfaceBuilder(it->second);
+      builder(interfaceBuilder);
+      interfaceBuilder.build();
+    }
+
+    objects.emplace(id, std::make_shared<ObjectEntry>(std::move(object),
+                                                      &it->second));
+  }
+
+  // Response can arrive as soon as request is written, so handler is
+  // registered first. Fails handler if there is no room for it
+  std::optional<json>
+  createCall(std::string_view method, json &&params,
+             ResponseHandler &&responseHandler,
+             std::optional<EventLoop::Clock::time_point> deadline) {
+    auto id = mPendingCalls.add(std::move(responseHandler));
+    if (!id) {
+      responseHandler(
+          makeCallError({ErrorCode::InternalError, "too many pending calls"}),
+          true);
+      return std::nullopt;
+    }
+
+    if (deadline) {
+      addDeadline(*id, *deadline);
+    }
+
+    return json{
+        {"jsonrpc", "2.0"},
+        {"method", method},
+        {"params", std::move(params)},
+        {"id", *id},
+    };
+  }
+
+  std::optional<EventLoop::Clock::time_point> getDefaultDeadline() const {
+    if (mCallTimeout.count() <= 0) {
+      return std::nullopt;
+    }
+
+    return EventLoop::Clock::now() + mCallTimeout;
+  }
+
+  void call(std::string_view method, json params,
+            ResponseHandler responseHandler) override {
+    callUntil(method, std::move(params), std::move(responseHandler),
+              getDefaultDeadline());
+  }
+
+  void callUntil(std::string_view method, json params,
+                 ResponseHandler responseHandler,
+                 EventLoop::Clock::time_point deadline) override {
+    callUntil(method, std::move(params), std::move(responseHandler),
+              std::optional(deadline));
+  }
+
+  void callUntil(std::string_view method, json params,
+                 ResponseHandler responseHandler,
+                 std::optional<EventLoop::Clock::time_point> deadline) {
+    if (auto request = createCall(method, std::move(params),
+                                  std::move(responseHandler), deadline)) {
+      send(*request);
+
+      // caller usually blocks on the response, do not hold the request back
+      outbound.flush(OutboundBatcher::FlushReason::Call);
+    }
+  }
+
+  void callBatch(std::vector<BatchCall> calls) override {
+    auto batch = json::array();
+    auto deadline = getDefaultDeadline();
+
+    for (auto &batchCall : calls) {
+      if (auto request =
+              createCall(batchCall.method, std::move(batchCall.params),
+                         std::move(batchCall.responseHandler), deadline)) {
+        batch.push_back(std::move(*request));
+      }
+    }
+
+    // empty batch is invalid request
+    if (batch.empty()) {
+      return;
+    }
+
+    send(batch);
+    outbound.flush(OutboundBatcher::FlushReason::Call);
+  }
+
+  void notify(std::string_view method, json params) override {
+    send({
+        {"jsonrpc", "2.0"},
+        {"method", method},
+        {"params", std::move(params)},
+    });
+  }
+
+  void sendResponse(std::size_t id, json result) override {
+    sendResponseMessage(id, {
+                                {"jsonrpc", "2.0"},
+                                {"id", id},
+                                {"result", std::move(result)},
+                            });
+  }
+
+  // Results of generated types are written straight into JSON frame. DOM is
+  // built for binary formats, batches and while descriptors wait to be sent,
+  // since collectHandles() looks for their references in it
+  void sendResult(std::size_t id, ResponseResult result) {
+    if (result.getJson() != nullptr || (id & kBatchRequestId) != 0 ||
+        mMessageFormat.load(std::memory_order::relaxed) !=
+            MessageFormat::Json ||
+        mOutgoingHandleCount.load(std::memory_order::relaxed) != 0) {
+      sendResponse(id, std::move(result).toJson());
+      return;
+    }
+
+    endRequest(id);
+
+    auto &writer = getFrameWriter();
+    auto frame = writer.serializeJson(
+        [&](JsonWriter &body) {
+          body.beginObject();
+          body.key("id");
+          body.writeUnsigned(id);
+          body.key("jsonrpc");
+          body.writeString("2.0");
+          body.key("result");
+          result.write(body);
+          body.endObject();
+        },
+        mFrameEncoding.load(std::memory_order::relaxed),
+        mCompressionThreshold);
+    pushFrame(writer, frame);
+  }
+
+  void sendErrorResponse(std::size_t id, ErrorInstance error) override {
+    sendResponseMessage(id, {
+                                {"jsonrpc", "2.0"},
+                                {"id", id},
+                                {"error", error},
+                            });
+  }
+  void sendErrorResponse(ErrorInstance error) override {
+    send({
+        {"jsonrpc", "2.0"},
+        {"id", nullptr},
+        {"error", error},
+    });
+  }
+
+  void addNotificationHandler(std::string_view notification,
+                              std::function<void(json)> handler,
+                              bool reentrant) override {
+    mNotifyHandlers.set(
+        notification,
+        [this, handler = std::move(handler)](RequestParams params) {
+          auto body = std::move(params).toJson();
+          if (!body) {
+            sendErrorResponse({ErrorCode::ParseError});
+            return;
+          }
+
+          handler(std::move(*body));
+        },
+        reentrant);
+  }
+
+  void addMethodHandler(std::string_view method,
+                        std::function<void(std::size_t, json)> handler,
+                        bool reentrant) override {
+    mMethodHandlers.set(
+        method,
+        [this, handler = std::move(handler)](std::size_t id,
+                                             RequestParams params) {
+          auto body = std::move(params).toJson();
+          if (!body) {
+            sendErrorResponse(id, {ErrorCode::ParseError});
+            return;
+          }
+
+          handler(id, std::move(*body));
+        },
+        reentrant);
+  }
+
+  void onEvent(std::string_view method,
+               std::function<void(json)> eventHandler) override {
+    mEventHandlers[std::string(method)].push_back(std::move(eventHandler));
+  }
+
+  void sendLogMessage(LogLevel level, std::string_view message) override {
+    // FIXME
+    std::fprintf(stderr, "%s\n", std::string(message).c_str());
+  }
+
+  void post(UniqueFunction<void()> task) override {
+    workers.post(std::move(task));
+  }
+
+  void post(std::optional<std::uint64_t> strand,
+            UniqueFunction<void()> task) override {
+    dispatch(strand, std::move(task));
+  }
+
+  std::optional<json> shareFile(File file) override {
+    if (!getTransport()->canPassHandles()) {
+      return std::nullopt;
+    }
+
+    int handle = file.release();
+    if (handle < 0) {
+      return std::nullopt;
+    }
+
+    auto id = mNextHandleId.fetch_add(1, std::memory_order::relaxed);
+
+    {
+      std::lock_guard lock(mHandlesMutex);
+      mOutgoingHandles.emplace(id, handle);
+      mOutgoingHandleCount.store(mOutgoingHandles.size(),
+                                 std::memory_order::relaxed);
+    }
+
+    return json{{"$fd", id}};
+  }
+
+  std::expected<File, std::error_code> takeFile(const json &ref) override {
+    auto it = ref.find("$fd");
+    if (it == ref.end() || !it->is_number_unsigned()) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+
+    int handle;
+
+    {
+      std::lock_guard lock(mHandlesMutex);
+      auto handleIt = mIncomingHandles.find(it->get<std::uint64_t>());
+      if (handleIt == mIncomingHandles.end()) {
+        return std::unexpected(
+            std::make_error_code(std::errc::bad_file_descriptor));
+      }
+
+      handle = handleIt->second;
+      mIncomingHandles.erase(handleIt);
+    }
+
+    return File::adopt(handle);
+  }
+
+  ProtocolStats getStats() override {
+    ProtocolStats stats;
+    outbound.collectStats(stats);
+    stats.encodedFrames = mEncodedFrames.load(std::memory_order::relaxed);
+    stats.encodedInputBytes =
+        mEncodedInputBytes.load(std::memory_order::relaxed);
+    stats.encodedOutputBytes =
+        mEncodedOutputBytes.load(std::memory_order::relaxed);
+    stats.dispatchAllocations =
+        workers.getAllocatedJobs() + messages.getAllocations();
+    return stats;
+  }
+
+  // Event loop thread reads and dispatches messages, writes outbound frames
+  // and runs timers. Transports that cannot be polled are read by separate
+  // thread that forwards parsed messages to the loop
+  int processMessages() override {
+    FrameDecoder decoder;
+    auto transport = getTransport();
+    std::thread reader;
+
+    auto onReadable = [&] {
+      if (!decoder.receive(*transport)) {
+        loop.stop();
+        return;
+      }
+
+      while (auto frame = decoder.decode()) {
+        auto handles = receiveHandles(*frame);
+        std::visit(
+            [&](auto &&message) {
+              handleMessage(std::move(message), std::move(handles));
+            },
+            readFrame(*frame));
+      }
+
+      outbound.flush(OutboundBatcher::FlushReason::Idle);
+    };
+
+    int pollHandle = transport->getPollHandle();
+
+    if (pollHandle < 0 || !loop.watch(pollHandle, onReadable)) {
+      reader = std::thread([&] {
+        while (auto frame = decoder.next(*transport)) {
+          loop.post([this, handles = receiveHandles(*frame),
+                     message = readFrame(*frame),
+                     idle = decoder.empty()]() mutable {
+            std::visit(
+                [&](auto &&message) {
+                  handleMessage(std::move(message), std::move(handles));
+                },
+                std::move(message));
+
+            if (idle) {
+              outbound.flush(OutboundBatcher::FlushReason::Idle);
+            }
+          });
+        }
+
+        // messages posted before end of stream are still dispatched
+        loop.post([this] { loop.stop(); });
+      });
+    }
+
+    loop.run();
+
+    if (reader.joinable()) {
+      reader.join();
+    } else {
+      loop.unwatch(pollHandle);
+    }
+
+    return 0;
+  }
+
+  // Requests with JSON body are only pre-scanned here, so reader is not
+  // held up by parsing of large params
+  static InboundMessage readFrame(const Frame &frame) {
+    auto body = frame.body;
+    auto buffer = frame.buffer;
+
+    if (frame.header.encoding != FrameEncoding::Identity) {
+      // decoded body is leased like received one, buffer is reused once
+      // previous message is released
+      thread_local std::shared_ptr<FrameBuffer> decoded;
+      if (decoded == nullptr ||
+          decoded->leases.load(std::memory_order::acquire) != 0) {
+        decoded = std::make_shared<FrameBuffer>();
+      }
+
+      decoded->bytes.clear();
+
+      if (!frame.header.encoding ||
+          !decodeFrame(*frame.header.encoding, body, decoded->bytes)) {
+        return json(json::value_t::discarded);
+      }
+
+      body = decoded->bytes;
+      buffer = FrameLease(decoded);
+    }
+
+    if (!frame.header.format) {
+      return json(json::value_t::discarded);
+    }
+
+    if (*frame.header.format != MessageFormat::Json) {
+      return RawMessage{*frame.header.format, body, std::move(buffer)};
+    }
+
+    std::string_view text(reinterpret_cast<const char *>(body.data()),
+                          body.size());
+
+    if (auto request = scanRequest(text, buffer)) {
+      return std::move(*request);
+    }
+
+    if (auto batch = scanBatch(text, buffer)) {
+      return std::move(*batch);
+    }
+
+    return RawMessage{MessageFormat::Json, body, std::move(buffer)};
+  }
+
+  // Counterpart of scanRequest() for decoded message. Method and handler
+  // name point into the message, params are serialized to own buffer
+  static std::optional<RawRequest> routeRequest(const ArenaJson &message) {
+    if (!message.is_object()) {
+      return std::nullopt;
+    }
+
+    auto method = message.find("method");
+    if (method == message.end() || !method->is_string()) {
+      return std::nullopt;
+    }
+
+    RawRequest request;
+    request.method = method->get_ref<const std::string &>();
+
+    if (auto id = message.find("id"); id != message.end() && !id->is_null()) {
+      if (!id->is_number_unsigned()) {
+        return std::nullopt;
+      }
+
+      request.id = id->get<std::uint64_t>();
+    }
+
+    auto params = message.find("params");
+    if (params == message.end()) {
+      return request;
+    }
+
+    request.params = RequestParams::fromText(toJsonText(*params));
+
+    if (request.method.starts_with("$/object/") && params->is_object()) {
+      if (auto it = params->find("object");
+          it != params->end() && it->is_number_unsigned()) {
+        request.object = it->get<std::uint64_t>();
+      }
+
+      if (auto it = params->find(getHandlerNameKey(request.method));
+          it != params->end() && it->is_string()) {
+        request.handlerName = it->get_ref<const std::string &>();
+      }
+    }
+
+    return request;
+  }
+
+  // Batch of requests is pre-scanned item by item. Anything else, including
+  // batches of responses and malformed items, is left to the parser
+  static std::optional<RawBatch> scanBatch(std::string_view text,
+                                          const FrameLease &buffer) {
+    JsonReader reader(text);
+    if (reader.peek() != JsonReader::Kind::Array) {
+      return std::nullopt;
+    }
+
+    RawBatch batch;
+    bool result = reader.readArray([&] {
+      std::string_view item;
+      if (!reader.readRaw(item)) {
+        return false;
+      }
+
+      auto request = scanRequest(item, buffer);
+      if (!request) {
+        return false;
+      }
+
+      batch.items.emplace_back(std::move(*request));
+      return true;
+    });
+
+    if (!result || !reader.finish()) {
+      return std::nullopt;
+    }
+
+    return batch;
+  }
+
+  // Finds method, id and object that request addresses. Anything else,
+  // including responses and batches, is left to the parser
+  static std::optional<RawRequest> scanRequest(std::string_view text,
+                                               const FrameLease &buffer) {
+    thread_local std::vector<JsonMember> members;
+    if (!scanJsonObject(text, members)) {
+      return std::nullopt;
+    }
+
+    RawRequest request;
+    std::string_view params;
+    bool hasMethod = false;
+
+    for (auto &member : members) {
+      if (member.escapedKey) {
+        return std::nullopt;
+      }
+
+      if (member.key == "method") {
+        auto method = getJsonString(member.value);
+        if (!method) {
+          return std::nullopt;
+        }
+
+        request.method = *method;
+        hasMethod = true;
+      } else if (member.key == "id") {
+        if (isJsonNull(member.value)) {
+          request.id.reset();
+          continue;
+        }
+
+        auto id = getJsonUnsigned(member.value);
+        if (!id) {
+          return std::nullopt;
+        }
+
+        request.id = *id;
+      } else if (member.key == "params") {
+        params = member.value;
+      }
+    }
+
+    if (!hasMethod) {
+      return std::nullopt;
+    }
+
+    if (request.method.starts_with("$/object/") && !params.empty() &&
+        scanJsonObject(params, members)) {
+      auto nameKey = getHandlerNameKey(request.method);
+
+      for (auto &member : members) {
+        if (member.key == "object") {
+          request.object = getJsonUnsigned(member.value);
+        } else if (member.key == nameKey) {
+          request.handlerName = getJsonString(member.value).value_or("");
+        }
+      }
+    }
+
+    request.params = RequestParams::fromText(params, buffer);
+    request.buffer = buffer;
+    return request;
+  }
+
+  void handleMessage(RawRequest request, HandleLease handles = {}) {
+    if (!rejectBatchRequestId(request.id)) {
+      dispatchRequest(std::move(request), std::move(handles));
+    }
+  }
+
+  void dispatchRequest(RawRequest request, HandleLease handles) {
+    auto strand = getStrand(request.method, !request.id, request.object,
+                            request.handlerName);
+    dispatchRequest(request.method, request.id, std::move(request.params),
+                    strand, std::move(handles));
+  }
+
+  void handleMessage(json message, HandleLease handles = {}) {
+    if (message.is_discarded()) {
+      sendErrorResponse({ErrorCode::ParseError});
+      return;
+    }
+
+    if (message.is_array()) {
+      RawBatch batch;
+      batch.items.reserve(message.size());
+
+      for (auto &item : message) {
+        batch.items.emplace_back(std::move(item));
+      }
+
+      handleMessage(std::move(batch), std::move(handles));
+      return;
+    }
+
+    if (auto id = message.find("id"); id != message.end() &&
+                                      id->is_number_unsigned() &&
+                                      message.contains("method")) {
+      if (rejectBatchRequestId(id->get<std::uint64_t>())) {
+        return;
+      }
+    }
+
+    handleRequest(std::move(message), std::move(handles));
+  }
+
+  // Messages that were not pre-scanned are decoded into arena of event loop.
+  // Response handlers see the DOM and it is reset once they return, requests
+  // take JSON text of their params from it. Arena is current only while
+  // decoding, copies handlers make come from heap and outlive the reset
+  void handleMessage(RawMessage message, HandleLease handles = {}) {
+    {
+      ArenaJson decoded;
+
+      {
+        MessageArena::Scope scope(mInboundArena);
+        decoded = decodeMessage(message);
+      }
+
+      routeMessage(decoded, std::move(handles));
+    }
+
+    mInboundArena.reset();
+  }
+
+  static ArenaJson decodeMessage(const RawMessage &message) {
+    auto begin = reinterpret_cast<const std::uint8_t *>(message.body.data());
+    auto end = begin + message.body.size();
+
+    switch (message.format) {
+    case MessageFormat::Json:
+      break;
+    case MessageFormat::MsgPack:
+      return ArenaJson::from_msgpack(begin, end, true, false);
+    case MessageFormat::Cbor:
+      return ArenaJson::from_cbor(begin, end, true, false);
+    }
+
+    return ArenaJson::parse(begin, end, nullptr, false);
+  }
+
+  static bool isResponse(const ArenaJson &message) {
+    return message.is_object() && !message.contains("method");
+  }
+
+  void routeMessage(const ArenaJson &message, HandleLease handles) {
+    if (message.is_discarded()) {
+      sendErrorResponse({ErrorCode::ParseError});
+      return;
+    }
+
+    if (isResponse(message)) {
+      handleResponse(message);
+      return;
+    }
+
+    if (message.is_array() && !message.empty() &&
+        std::ranges::all_of(message, isResponse)) {
+      for (auto &item : message) {
+        handleResponse(item);
+      }
+      return;
+    }
+
+    if (message.is_array()) {
+      RawBatch batch;
+      batch.items.reserve(message.size());
+
+      for (auto &item : message) {
+        if (auto request = routeRequest(item)) {
+          batch.items.emplace_back(std::move(*request));
+        } else {
+          batch.items.emplace_back(json(item));
+        }
+      }
+
+      handleMessage(std::move(batch), std::move(handles));
+      return;
+    }
+
+    if (auto request = routeRequest(message)) {
+      handleMessage(std::move(*request), std::move(handles));
+      return;
+    }
+
+    handleMessage(json(message), std::move(handles));
+  }
+
+  // Runs on event loop thread, handler of the call sees response in place
+  void handleResponse(const ArenaJson &message) {
+    auto idIt = message.find("id");
+    if (idIt == message.end() || !idIt->is_number_unsigned()) {
+      return;
+    }
+
+    auto handler = mPendingCalls.take(idIt->get<std::uint64_t>());
+    if (!handler) {
+      return;
+    }
+
+    if (auto it = message.find("result"); it != message.end()) {
+      handler(*it, false);
+    } else if (auto it = message.find("error"); it != message.end()) {
+      handler(*it, true);
+    }
+  }
+
+  // Ids with the batch bit set are reserved for requests of batches, request
+  // that uses one is answered here instead of being taken for batch request
+  bool rejectBatchRequestId(std::optional<std::size_t> id) {
+    if (!id || (*id & kBatchRequestId) == 0) {
+      return false;
+    }
+
+    send({
+        {"jsonrpc", "2.0"},
+        {"id", *id},
+        {"error", ErrorInstance{ErrorCode::InvalidRequest}},
+    });
+    return true;
+  }
+
+  // Requests of batch are dispatched like separate messages. Their ids are
+  // replaced with batch request ids, so responses sent by handlers are
+  // collected and go back as one batch once the last request is answered
+  void handleMessage(RawBatch batch, HandleLease handles = {}) {
+    if (batch.items.empty()) {
+      sendErrorResponse({ErrorCode::InvalidRequest});
+      return;
+    }
+
+    auto state = std::make_shared<InboundBatch>();
+
+    for (auto &item : batch.items) {
+      if (auto request = std::get_if<RawRequest>(&item)) {
+        if (request->id) {
+          request->id = addBatchRequest(state, *request->id);
+        }
+
+        dispatchRequest(std::move(*request), handles);
+        continue;
+      }
+
+      auto &message = std::get<json>(item);
+
+      if (!message.is_object()) {
+        state->pending.fetch_add(1, std::memory_order::relaxed);
+        completeBatchRequest(*state,
+                             {
+                                 {"jsonrpc", "2.0"},
+                                 {"id", nullptr},
+                                 {"error", ErrorInstance{
+                                               ErrorCode::InvalidRequest}},
+                             });
+        continue;
+      }
+
+      if (auto idIt = message.find("id");
+          idIt != message.end() && !idIt->is_null() &&
+          message.contains("method")) {
+        *idIt = addBatchRequest(state, std::move(*idIt));
+      }
+
+      handleRequest(std::move(message), handles);
+    }
+
+    // dispatch is done, batch is sent by whoever answers last
+    completeBatchRequest(*state, nullptr);
+  }
+
+  std::size_t addBatchRequest(const std::shared_ptr<InboundBatch> &batch,
+                              json id) {
+    if (batch != nullptr) {
+      batch->pending.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    auto idText = id.dump();
+    std::lock_guard lock(mBatchMutex);
+    auto result = mNextBatchRequestId++ | kBatchRequestId;
+    mBatchRequests.emplace(result, BatchRequest{batch, std::move(id)});
+    mBatchRequestIds.insert_or_assign(std::move(idText), result);
+    return result;
+  }
+
+  // Cancelled requests that are still queued are answered with
+  // RequestCancelled, running handlers see stop request on their token.
+  // Requests that got batch request id are found by id peer sent
+  void cancelRequest(const json &id) {
+    std::optional<std::size_t> batchRequestId;
+
+    {
+      std::lock_guard lock(mBatchMutex);
+      if (auto it = mBatchRequestIds.find(id.dump());
+          it != mBatchRequestIds.end()) {
+        batchRequestId = it->second;
+      }
+    }
+
+    std::lock_guard lock(mRequestsMutex);
+    auto cancel = [&](std::size_t requestId) {
+      if (auto it = mActiveRequests.find(requestId);
+          it != mActiveRequests.end()) {
+        it->second.request_stop();
+      }
+    };
+
+    if (id.is_number_unsigned()) {
+      cancel(id.get<std::size_t>());
+    }
+
+    if (batchRequestId) {
+      cancel(*batchRequestId);
+    }
+  }
+
+  void dispatchRequest(std::string_view method, std::optional<std::size_t> id,
+                       RequestParams params,
+                       std::optional<WorkerPool::StrandId> strand,
+                       HandleLease handles) {
+    // cancellation has to overtake work it cancels, handle it right away.
+    // It is notification, malformed one is dropped without answer
+    if (!id && (method == "$/cancel" || method == "$/cancelRequest")) {
+      auto body = std::move(params).toJson();
+      if (!body || !body->is_object()) {
+        return;
+      }
+
+      if (auto it = body->find("id"); it != body->end() && !it->is_null()) {
+        cancelRequest(*it);
+      }
+      return;
+    }
+
+    // handlers are referenced in place, they must not be replaced while
+    // their messages are queued
+    if (id) {
+      if (auto handler = mMethodHandlers.find(method)) {
+        auto message = messages.acquire();
+        message->method = handler;
+        message->id = *id;
+        message->params = std::move(params);
+        message->handles = std::move(handles);
+        message->stopToken = beginRequest(*id);
+        message->strand = strand;
+
+        dispatch(strand, [this, message = std::move(message)] {
+          if (message->stopToken.stop_requested()) {
+            sendErrorResponse(message->id, {ErrorCode::RequestCancelled});
+            return;
+          }
+
+          RequestScope scope(message->stopToken, message->strand);
+          (*message->method)(message->id, std::move(message->params));
+        });
+        return;
+      }
+
+      sendErrorResponse(*id, {ErrorCode::MethodNotFound, std::string(method)});
+      return;
+    }
+
+    if (auto handler = mNotifyHandlers.find(method)) {
+      auto message = messages.acquire();
+      message->notification = handler;
+      message->params = std::move(params);
+      message->handles = std::move(handles);
+      message->strand = strand;
+
+      dispatch(strand, [message = std::move(message)] {
+        RequestScope scope({}, message->strand);
+        (*message->notification)(std::move(message->params));
+      });
+      return;
+    }
+
+    sendErrorResponse({ErrorCode::MethodNotFound, std::string(method)});
+  }
+
+  void handleRequest(json message, HandleLease handles = {}) {
+    if (auto it = message.find("method"); it != message.end()) {
+      std::size_t id = 0;
+      bool hasId = false;
+
+      // string and signed ids are valid, handlers get id of their own
+      if (auto it = message.find("id"); it != message.end() && !it->is_null()) {
+        hasId = true;
+        id = it->is_number_unsigned() ? it->get<std::size_t>()
+                                      : addBatchRequest(nullptr, *it);
+      }
+
+      if (!it->is_string()) {
+        if (hasId) {
+          sendErrorResponse(id, {ErrorCode::InvalidRequest});
+        } else {
+          sendErrorResponse({ErrorCode::InvalidRequest});
+        }
+        return;
+      }
+
+      std::string_view method = it->get_ref<const std::string &>();
+      json params;
+
+      if (auto it = message.find("params"); it != message.end()) {
+        params = std::move(*it);
+      }
+
+      auto strand = getStrand(method, !hasId, params);
+      dispatchRequest(method, hasId ? std::optional(id) : std::nullopt,
+                      std::move(params), strand, std::move(handles));
+      return;
+    }
+
+    handleResponse(ArenaJson(message));
+  }
+
+private:
+  // Deadlines are not removed when response arrives, ids of completed calls
+  // are not found in pending call table when they expire
+  void addDeadline(std::uint64_t id, EventLoop::Clock::time_point deadline) {
+    auto tick = (deadline - mDeadlineEpoch + kDeadlineTick -
+                 EventLoop::Clock::duration(1)) /
+                kDeadlineTick;
+
+    std::lock_guard lock(mDeadlinesMutex);
+    mDeadlines.add(id, std::max<decltype(tick)>(tick, 0));
+    armDeadlineTimer();
+  }
+
+  void armDeadlineTimer() {
+    auto next = mDeadlines.nextEvent();
+    if (!next || (mDeadlineTimerTick && *mDeadlineTimerTick <= *next)) {
+      return;
+    }
+
+    if (mDeadlineTimerTick) {
+      loop.cancelTimer(mDeadlineTimer);
+    }
+
+    mDeadlineTimerTick = *next;
+    mDeadlineTimer = loop.addTimer(mDeadlineEpoch + *next * kDeadlineTick,
+                                   [this, tick = *next] { expireCalls(tick); });
+  }
+
+  void expireCalls(TimerWheel::Tick timerTick) {
+    std::vector<std::uint64_t> expired;
+
+    {
+      std::lock_guard lock(mDeadlinesMutex);
+      if (mDeadlineTimerTick == timerTick) {
+        mDeadlineTimerTick.reset();
+      }
+
+      mDeadlines.advance(
+          (EventLoop::Clock::now() - mDeadlineEpoch) / kDeadlineTick,
+          expired);
+      armDeadlineTimer();
+    }
+
+    for (auto id : expired) {
+      if (auto handler = mPendingCalls.take(id)) {
+        handler(makeCallError({ErrorCode::TimedOut, "no response in time"}),
+                true);
+      }
+    }
+  }
+
+  // Entries of answered requests are kept and reused for new ones
+  std::stop_token beginRequest(std::size_t id) {
+    std::stop_source source;
+    std::lock_guard lock(mRequestsMutex);
+
+    if (mFreeRequestEntries.empty()) {
+      mActiveRequests.insert_or_assign(id, source);
+      return source.get_token();
+    }
+
+    auto entry = std::move(mFreeRequestEntries.back());
+    mFreeRequestEntries.pop_back();
+    entry.key() = id;
+    entry.mapped() = source;
+
+    if (auto result = mActiveRequests.insert(std::move(entry));
+        !result.inserted) {
+      result.position->second = source;
+      mFreeRequestEntries.push_back(std::move(result.node));
+    }
+
+    return source.get_token();
+  }
+
+  void endRequest(std::size_t id) {
+    std::lock_guard lock(mRequestsMutex);
+
+    if (auto entry = mActiveRequests.extract(id)) {
+      entry.mapped() = std::stop_source(std::nostopstate);
+      mFreeRequestEntries.push_back(std::move(entry));
+    }
+  }
+
+  void sendResponseMessage(std::size_t id, json response) {
+    endRequest(id);
+
+    if ((id & kBatchRequestId) == 0) {
+      send(response);
+      return;
+    }
+
+    BatchRequest request;
+
+    {
+      std::lock_guard lock(mBatchMutex);
+      auto it = mBatchRequests.find(id);
+      if (it == mBatchRequests.end()) {
+        return;
+      }
+
+      request = std::move(it->second);
+      mBatchRequests.erase(it);
+
+      if (auto it = mBatchRequestIds.find(request.id.dump());
+          it != mBatchRequestIds.end() && it->second == id) {
+        mBatchRequestIds.erase(it);
+      }
+    }
+
+    response["id"] = std::move(request.id);
+
+    if (request.batch == nullptr) {
+      send(response);
+      return;
+    }
+
+    completeBatchRequest(*request.batch, std::move(response));
+  }
+
+  void completeBatchRequest(InboundBatch &batch, json response) {
+    json responses;
+
+    {
+      std::lock_guard lock(batch.mutex);
+      if (!response.is_null()) {
+        batch.responses.push_back(std::move(response));
+      }
+
+      if (batch.pending.fetch_sub(1, std::memory_order::acq_rel) != 1 ||
+          batch.responses.empty()) {
+        return;
+      }
+
+      responses = std::move(batch.responses);
+    }
+
+    send(responses);
+  }
+
+  HandleLease receiveHandles(const Frame &frame) {
+    if (frame.header.handleIds.empty()) {
+      return {};
+    }
+
+    auto transport = getTransport();
+    std::lock_guard lock(mHandlesMutex);
+
+    for (auto id : frame.header.handleIds) {
+      int handle = transport->takeHandle();
+      if (handle < 0) {
+        std::fprintf(stderr, "frame handle %llu was not received\n",
+                     static_cast<unsigned long long>(id));
+        continue;
+      }
+
+      if (auto [it, inserted] = mIncomingHandles.emplace(id, handle);
+          !inserted) {
+        closeHandle(std::exchange(it->second, handle));
+      }
+    }
+
+    return std::make_shared<ReceivedHandles>(this, frame.header.handleIds);
+  }
+
+  // Moves descriptors referenced by body out of shared set
+  void collectHandles(const json &body, std::vector<std::uint64_t> &ids,
+                      std::vector<int> &handles) {
+    if (body.is_array()) {
+      for (auto &item : body) {
+        collectHandles(item, ids, handles);
+      }
+
+      return;
+    }
+
+    if (!body.is_object()) {
+      return;
+    }
+
+    if (body.size() == 1) {
+      if (auto it = body.find("$fd");
+          it != body.end() && it->is_number_unsigned()) {
+        auto id = it->get<std::uint64_t>();
+
+        if (auto handleIt = mOutgoingHandles.find(id);
+            handleIt != mOutgoingHandles.end()) {
+          ids.push_back(id);
+          handles.push_back(handleIt->second);
+          mOutgoingHandles.erase(handleIt);
+        }
+
+        return;
+      }
+    }
+
+    for (auto &[key, value] : body.items()) {
+      collectHandles(value, ids, handles);
+    }
+  }
+
+  // Client lists message formats it can read in order of preference. Frames
+  // are labeled with their format, so the switch applies starting from the
+  // response to initialize request
+  void negotiateMessageFormat(const json::object_t &clientCapabilities,
+                              ExtensionInfo &extension) {
+    auto it = clientCapabilities.find("messageFormats");
+    if (it == clientCapabilities.end() || !it->second.is_array()) {
+      return;
+    }
+
+    for (auto &name : it->second) {
+      if (!name.is_string()) {
+        continue;
+      }
+
+      if (auto format = parseMessageFormat(name.get<std::string_view>())) {
+        mMessageFormat.store(*format, std::memory_order::relaxed);
+
+        if (!extension.capabilities) {
+          extension.capabilities.emplace();
+        }
+
+        (*extension.capabilities)["messageFormat"] =
+            getMessageFormatName(*format);
+        return;
+      }
+    }
+  }
+
+  // Client lists encodings it can decode in order of preference, the first
+  // one available here is used for every frame sent after this point. Client
+  // has to accept encoded frames as soon as it advertises them
+  void negotiateFrameEncoding(const json::object_t &clientCapabilities,
+                              ExtensionInfo &extension) {
+    auto it = clientCapabilities.find("frameEncodings");
+    if (it == clientCapabilities.end() || !it->second.is_array()) {
+      return;
+    }
+
+    auto supported = getSupportedFrameEncodings();
+
+    for (auto &name : it->second) {
+      if (!name.is_string()) {
+        continue;
+      }
+
+      auto encoding = parseFrameEncoding(name.get<std::string_view>());
+
+      if (encoding && std::ranges::find(supported, *encoding) !=
+                          supported.end()) {
+        mFrameEncoding.store(*encoding, std::memory_order::relaxed);
+
+        if (!extension.capabilities) {
+          extension.capabilities.emplace();
+        }
+
+        (*extension.capabilities)["frameEncoding"] =
+            getFrameEncodingName(*encoding);
+        return;
+      }
+    }
+  }
+
+  static FrameWriter &getFrameWriter() {
+    thread_local FrameWriter writer;
+    return writer;
+  }
+
+  void send(const json &body) {
+    auto &writer = getFrameWriter();
+    auto format = mMessageFormat.load(std::memory_order::relaxed);
+
+    if (mOutgoingHandleCount.load(std::memory_order::relaxed) != 0) {
+      std::vector<std::uint64_t> ids;
+      std::vector<int> handles;
+
+      {
+        std::lock_guard lock(mHandlesMutex);
+        collectHandles(body, ids, handles);
+        mOutgoingHandleCount.store(mOutgoingHandles.size(),
+                                   std::memory_order::relaxed);
+      }
+
+      if (!handles.empty()) {
+        outbound.push(writer.serialize(body, format, ids), handles);
+        return;
+      }
+    }
+    auto frame = writer.serialize(
+        body, format, mFrameEncoding.load(std::memory_order::relaxed),
+        mCompressionThreshold);
+    pushFrame(writer, frame);
+  }
+
+  void pushFrame(const FrameWriter &writer,
+                 std::span<const std::byte> frame) {
+    if (writer.encoding != FrameEncoding::Identity) {
+      mEncodedFrames.fetch_add(1, std::memory_order::relaxed);
+      mEncodedInputBytes.fetch_add(writer.bodySize,
+                                   std::memory_order::relaxed);
+      mEncodedOutputBytes.fetch_add(writer.encodedSize,
+                                    std::memory_order::relaxed);
+    }
+
+    outbound.push(frame);
+  }
+
+  ProtocolHandlers<MethodHandler, kProtocolMethods.size()> mMethodHandlers{
+      kProtocolMethods, 0};
+  ProtocolHandlers<NotifyHandler, kProtocolNotifications.size()>
+      mNotifyHandlers{kProtocolNotifications, kNotificationStrand};
+  std::map<std::string, std::vector<std::function<void(json)>>> mEventHandlers;
+  PendingCallTable mPendingCalls;
+
+  // Event loop thread only
+  MessageArena mInboundArena;
+
+  std::chrono::milliseconds mCallTimeout;
+  EventLoop::Clock::time_point mDeadlineEpoch;
+  std::mutex mDeadlinesMutex;
+  TimerWheel mDeadlines;
+  std::optional<TimerWheel::Tick> mDeadlineTimerTick;
+  EventLoop::TimerId mDeadlineTimer = 0;
+
+  std::mutex mRequestsMutex;
+  std::unordered_map<std::size_t, std::stop_source> mActiveRequests;
+  std::vector<decltype(mActiveRequests)::node_type> mFreeRequestEntries;
+
+  std::mutex mBatchMutex;
+  std::unordered_map<std::size_t, BatchRequest> mBatchRequests;
+
+  // batch request ids by JSON text of id peer sent, for cancellation
+  std::unordered_map<std::string, std::size_t> mBatchRequestIds;
+  std::size_t mNextBatchRequestId = 0;
+
+  std::size_t mCompressionThreshold;
+  std::atomic<MessageFormat> mMessageFormat;
+  std::atomic<FrameEncoding> mFrameEncoding{FrameEncoding::Identity};
+  std::atomic<std::uint64_t> mEncodedFrames{0};
+  std::atomic<std::uint64_t> mEncodedInputBytes{0};
+  std::atomic<std::uint64_t> mEncodedOutputBytes{0};
+
+  std::mutex mHandlesMutex;
+  std::unordered_map<std::uint64_t, int> mOutgoingHandles;
+  std::unordered_map<std::uint64_t, int> mIncomingHandles;
+  std::atomic<std::size_t> mOutgoingHandleCount{0};
+  std::atomic<std::uint64_t> mNextHandleId{1};
+};
+
+template <MessageFormat Format>
+static std::unique_ptr<Protocol>
+createJsonRpcProtocol(Transport *transport, const ProtocolOptions &options) {
+  return std::make_unique<JsonRpcProtocol>(transport, options, Format);
+}
+
+ProtocolFactory rpcsx::ui::findProtocolFactory(std::string_view protocolId) {
+  // binary variants keep JSON-RPC messages and encode them as MessagePack or
+  // CBOR from the first frame
+  if (protocolId == "json-rpc") {
+    return createJsonRpcProtocol<MessageFormat::Json>;
+  }
+
+  if (protocolId == "json-rpc+msgpack") {
+    return createJsonRpcProtocol<MessageFormat::MsgPack>;
+  }
+
+  if (protocolId == "json-rpc+cbor") {
+    return createJsonRpcProtocol<MessageFormat::Cbor>;
+  }
+
+  return nullptr;
+}
+
+int rpcsx::ui::runSession(const ExtensionBuilder &extensionBuilder,
+                          Protocol *protocol) {
+  Protocol::setThreadDefault(protocol);
+
+  int result;
+  {
+    auto extension = extensionBuilder(protocol);
+    result = protocol->processMessages();
   }
 
-  Protocol::setDefault(protocol.get());
-  auto extension = extensionBuilder(protocol.get());
-  return protocol->processMessages();
+  Protocol::setThreadDefault(nullptr);
+  return result;
 }
@@ -33,6 +33,13 @@ File::~File() {
   }
 }
 
+static File::Impl *toImpl(int fd) {
+  File::Impl *handle{};
+  std::uintptr_t rawHandle = -fd;
+  std::memcpy(&handle, &rawHandle, sizeof(void *));
+  return handle;
+}
+
 std::expected<File, std::error_code>
 File::open(const std::filesystem::path &path, std::ios::openmode mode) {
   int flags = 0;
@@ -62,14 +69,62 @@ File::open(const std::filesystem::path &path, std::ios::openmode mode) {
     return std::unexpected(std::make_error_code(std::errc{errno}));
   }
 
-  Impl *handle{};
-  std::uintptr_t rawHandle = -fd;
-  std::memcpy(&handle, &rawHandle, sizeof(void *));
   File result;
-  result.m_impl = handle;
+  result.m_impl = toImpl(fd);
   return result;
 }
 
+std::expected<File, std::error_code> File::adopt(int handle) {
+  if (handle < 0) {
+    return std::unexpected(
+        std::make_error_code(std::errc::bad_file_descriptor));
+  }
+
+  File result;
+  result.m_impl = toImpl(handle);
+  return result;
+}
+
+std::expected<File, std::error_code>
+File::createMemory(std::span<const std::byte> data) {
+  int fd = ::memfd_create("rpcsx-ui-payload", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    return std::unexpected(std::make_error_code(std::errc{errno}));
+  }
+
+  auto result = adopt(fd);
+
+  while (!data.empty()) {
+    auto written = ::write(fd, data.data(), data.size());
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return std::unexpected(std::make_error_code(std::errc{errno}));
+    }
+
+    data = data.subspan(written);
+  }
+
+  // receiver maps it without copy, contents must not change under it
+  if (::fcntl(fd, F_ADD_SEALS,
+              F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) < 0) {
+    return std::unexpected(std::make_error_code(std::errc{errno}));
+  }
+
+  return result;
+}
+
+int File::release() {
+  if (m_impl == nullptr) {
+    return -1;
+  }
+
+  return fileNativeHandle(std::exchange(m_impl, nullptr));
+}
+
 FileData::~FileData() {
   if (data()) {
     ::munmap(data(), (size() + gPageSize - 1) & ~(gPageSize - 1));
@@ -107,6 +162,8 @@ struct FileData::Impl {
 File::~File() { delete m_impl; }
 FileData::~FileData() { delete m_impl; }
 
+int File::release() { return -1; }
+
 std::expected<File, std::error_code>
 File::open(const std::filesystem::path &path, std::ios::openmode mode) {
   std::fstream f(path, mode);
@@ -120,6 +177,17 @@ File::open(const std::filesystem::path &path, std::ios::openmode mode) {
   return result;
 }
 
+std::expected<File, std::error_code> File::adopt(int) {
+  return std::unexpected(
+      std::make_error_code(std::errc::function_not_supported));
+}
+
+std::expected<File, std::error_code>
+File::createMemory(std::span<const std::byte>) {
+  return std::unexpected(
+      std::make_error_code(std::errc::function_not_supported));
+}
+
 std::expected<FileData, std::error_code> File::map() {
   if (m_impl == nullptr) {
     return std::unexpected(std::make_error_code(std::errc::invalid_argument));
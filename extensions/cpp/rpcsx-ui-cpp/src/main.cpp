@@ -0,0 +1,450 @@
+#include "rpcsx/ui/extension.hpp"
+#include "rpcsx/ui/IoUringTransport.hpp"
+#include "rpcsx/ui/ProtocolFactory.hpp"
+#include "rpcsx/ui/SessionRecording.hpp"
+#include "rpcsx/ui/SharedMemoryTransport.hpp"
+#include "rpcsx/ui/Transport.hpp"
+#include "rpcsx/ui/UnixSocketTransport.hpp"
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace rpcsx::ui;
+
+struct StdioTransport : Transport {
+#ifdef _WIN32
+  StdioTransport() {
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+    _setmode(_fileno(stderr), _O_BINARY);
+  }
+#endif
+
+#ifdef _WIN32
+  void write(std::span<const std::byte> bytes) override {
+    while (true) {
+      auto count = std::fwrite(bytes.data(), 1, bytes.size(), stdout);
+
+      if (count <= 0) {
+        break;
+      }
+
+      if (count == bytes.size()) {
+        break;
+      }
+
+      bytes = bytes.subspan(count);
+    }
+  }
+
+  void flush() override { std::fflush(stdout); }
+#else
+  // stdout is written directly, bypassing stdio buffering and locking
+  void write(std::span<const std::byte> bytes) override { writev({&bytes, 1}); }
+
+  void writev(std::span<const std::span<const std::byte>> buffers) override {
+    iovec iov[64];
+
+    while (!buffers.empty()) {
+      int count = 0;
+      for (; count < std::ssize(iov) && count < std::ssize(buffers); ++count) {
+        iov[count] = {
+            .iov_base = const_cast<std::byte *>(buffers[count].data()),
+            .iov_len = buffers[count].size(),
+        };
+      }
+
+      buffers = buffers.subspan(count);
+
+      iovec *pending = iov;
+      while (count > 0) {
+        auto written = ::writev(STDOUT_FILENO, pending, count);
+
+        if (written < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+
+          return;
+        }
+
+        while (count > 0 && std::size_t(written) >= pending->iov_len) {
+          written -= pending->iov_len;
+          ++pending;
+          --count;
+        }
+
+        if (count > 0) {
+          pending->iov_base =
+              static_cast<std::byte *>(pending->iov_base) + written;
+          pending->iov_len -= written;
+        }
+      }
+    }
+  }
+#endif
+
+  void read(std::span<std::byte> &bytes) override {
+    while (true) {
+#ifdef _WIN32
+      auto count = _read(_fileno(stdin), bytes.data(),
+                         static_cast<unsigned>(bytes.size()));
+#else
+      auto count = ::read(STDIN_FILENO, bytes.data(), bytes.size());
+#endif
+
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+
+      bytes = bytes.subspan(0, count > 0 ? count : 0);
+      return;
+    }
+  }
+
+#ifndef _WIN32
+  int getPollHandle() const override { return STDIN_FILENO; }
+  int getOutputHandle() const override { return STDOUT_FILENO; }
+#endif
+};
+
+ExtensionBuilder extension_main(int argc, const char *argv[]);
+
+static int serveUnixSocket(const ExtensionBuilder &extensionBuilder,
+                           ProtocolFactory createProtocol,
+                           const ProtocolOptions &protocolOptions,
+                           const std::filesystem::path &path,
+                           std::size_t bufferSize) {
+  auto listener = UnixSocketListener::listen(path);
+  if (!listener) {
+    std::fprintf(stderr, "%s: %s\n", path.string().c_str(),
+                 listener.error().message().c_str());
+    return 1;
+  }
+
+  struct Session {
+    std::unique_ptr<Transport> transport;
+    std::unique_ptr<Protocol> protocol;
+    std::thread thread;
+    bool done = false;
+  };
+
+  // finished sessions are joined and destroyed from accept loop, handlers
+  // log to protocol of their own session
+  std::list<Session> sessions;
+  std::mutex sessionsMutex;
+  std::size_t activeSessions = 0;
+
+  while (true) {
+    auto transport = listener->accept(bufferSize);
+    if (!transport) {
+      break;
+    }
+
+    std::lock_guard lock(sessionsMutex);
+
+    // session is marked done by its thread right before it exits
+    std::erase_if(sessions, [](Session &session) {
+      if (!session.done) {
+        return false;
+      }
+
+      session.thread.join();
+      return true;
+    });
+
+    auto &session = sessions.emplace_back();
+    session.transport = std::move(*transport);
+    session.protocol =
+        createProtocol(session.transport.get(), protocolOptions);
+    ++activeSessions;
+
+    session.thread = std::thread([&, &session = session] {
+      runSession(extensionBuilder, session.protocol.get());
+
+      std::lock_guard lock(sessionsMutex);
+      session.done = true;
+
+      if (--activeSessions == 0) {
+        listener->interrupt();
+      }
+    });
+  }
+
+  for (auto &session : sessions) {
+    session.thread.join();
+  }
+
+  return 0;
+}
+
+template <typename T>
+static bool parseNumber(std::string_view text, T &result) {
+  auto [ptr, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), result);
+  return ec == std::errc{} && ptr == text.data() + text.size();
+}
+
+int main(int argc, const char *argv[]) {
+  auto extensionBuilder = extension_main(argc, argv);
+
+  std::string_view transportId;
+  std::string_view protocolId;
+  std::string_view transportPath;
+  std::string_view ioBackend;
+  std::string_view recordPath;
+  std::string_view replayPath;
+  auto replayPacing = ReplayTransport::Pacing::Original;
+  int transportFd = -1;
+  std::size_t socketBufferSize = UnixSocketTransport::kDefaultBufferSize;
+  ProtocolOptions protocolOptions;
+
+  for (int i = 1; i < argc - 1; ++i) {
+    if (argv[i] == std::string_view("--rpcsx-ui/transport")) {
+      transportId = argv[i + 1];
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/protocol")) {
+      protocolId = argv[i + 1];
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/transport-path")) {
+      transportPath = argv[i + 1];
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/io-backend")) {
+      ioBackend = argv[i + 1];
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/record")) {
+      recordPath = argv[i + 1];
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/replay")) {
+      replayPath = argv[i + 1];
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/replay-pacing")) {
+      if (argv[i + 1] == std::string_view("original")) {
+        replayPacing = ReplayTransport::Pacing::Original;
+      } else if (argv[i + 1] == std::string_view("fast")) {
+        replayPacing = ReplayTransport::Pacing::Fast;
+      } else {
+        return 1;
+      }
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/transport-fd")) {
+      if (!parseNumber(argv[i + 1], transportFd)) {
+        return 1;
+      }
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/socket-buffer-size")) {
+      if (!parseNumber(argv[i + 1], socketBufferSize)) {
+        return 1;
+      }
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/flush-delay")) {
+      std::chrono::microseconds::rep delay;
+      if (!parseNumber(argv[i + 1], delay)) {
+        return 1;
+      }
+      protocolOptions.outbound.maxDelay = std::chrono::microseconds(delay);
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/compression-threshold")) {
+      if (!parseNumber(argv[i + 1], protocolOptions.compressionThreshold)) {
+        return 1;
+      }
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/worker-threads")) {
+      if (!parseNumber(argv[i + 1], protocolOptions.workerThreads) ||
+          protocolOptions.workerThreads == 0) {
+        return 1;
+      }
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/call-timeout")) {
+      std::chrono::milliseconds::rep timeout;
+      if (!parseNumber(argv[i + 1], timeout)) {
+        return 1;
+      }
+      protocolOptions.callTimeout = std::chrono::milliseconds(timeout);
+      ++i;
+
+      continue;
+    }
+
+    if (argv[i] == std::string_view("--rpcsx-ui/flush-threshold")) {
+      if (!parseNumber(argv[i + 1], protocolOptions.outbound.sizeThreshold)) {
+        return 1;
+      }
+      ++i;
+
+      continue;
+    }
+  }
+
+  if (transportId.empty()) {
+    transportId = "stdio";
+  }
+
+  if (protocolId.empty()) {
+    protocolId = "json-rpc";
+  }
+
+  auto createProtocol = findProtocolFactory(protocolId);
+  if (createProtocol == nullptr) {
+    return 1;
+  }
+
+  std::unique_ptr<Transport> transport;
+
+  if (!replayPath.empty()) {
+    auto replay = ReplayTransport::open(replayPath, replayPacing);
+    if (!replay) {
+      std::fprintf(stderr, "replay %s: %s\n", replayPath.data(),
+                   replay.error().message().c_str());
+      return 1;
+    }
+
+    transport = std::move(*replay);
+  } else if (transportId == "stdio") {
+    transport = std::make_unique<StdioTransport>();
+  } else if (transportId == "unix") {
+    if (transportFd >= 0) {
+      auto socket = UnixSocketTransport::adopt(transportFd, socketBufferSize);
+      if (!socket) {
+        std::fprintf(stderr, "transport fd %d: %s\n", transportFd,
+                     socket.error().message().c_str());
+        return 1;
+      }
+
+      transport = std::move(*socket);
+    } else if (!transportPath.empty()) {
+      return serveUnixSocket(extensionBuilder, createProtocol, protocolOptions,
+                             transportPath, socketBufferSize);
+    } else {
+      return 1;
+    }
+  } else if (transportId == "shm") {
+    auto shm = transportFd >= 0
+                   ? SharedMemoryTransport::open(transportFd)
+                   : std::unexpected(std::make_error_code(
+                         std::errc::protocol_not_supported));
+
+    if (shm) {
+      transport = std::move(*shm);
+    } else {
+      std::fprintf(stderr,
+                   "shared memory transport is not available (%s), "
+                   "falling back to stdio\n",
+                   shm.error().message().c_str());
+      transport = std::make_unique<StdioTransport>();
+    }
+  } else {
+    return 1;
+  }
+
+  // io_uring transport does not own descriptors, base transport keeps them
+  std::unique_ptr<Transport> baseTransport;
+
+  if (ioBackend == "uring") {
+    // stdio transport reads stdin and writes stdout, sockets are duplex
+    int inputFd = transport->getPollHandle();
+    int outputFd = transport->getOutputHandle();
+
+    auto uring = inputFd >= 0 && outputFd >= 0
+                     ? IoUringTransport::create(inputFd, outputFd)
+                     : std::unexpected(std::make_error_code(
+                           std::errc::function_not_supported));
+
+    if (uring) {
+      baseTransport = std::move(transport);
+      transport = std::move(*uring);
+    } else {
+      std::fprintf(stderr,
+                   "io_uring backend is not available (%s), "
+                   "falling back to epoll\n",
+                   uring.error().message().c_str());
+    }
+  } else if (!ioBackend.empty() && ioBackend != "epoll") {
+    return 1;
+  }
+
+  if (!recordPath.empty()) {
+    auto recording =
+        RecordingTransport::create(std::move(transport), recordPath);
+    if (!recording) {
+      std::fprintf(stderr, "record %s: %s\n", recordPath.data(),
+                   recording.error().message().c_str());
+      return 1;
+    }
+
+    transport = std::move(*recording);
+  }
+
+  // the only session also serves threads extension starts on its own
+  auto protocol = createProtocol(transport.get(), protocolOptions);
+  Protocol::setDefault(protocol.get());
+
+  int result = runSession(extensionBuilder, protocol.get());
+  Protocol::setDefault(nullptr);
+  return result;
+}
@@ -0,0 +1,121 @@
+#include "Check.hpp"
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace rpcsx::ui;
+
+// Delivers prepared input in reads of at most chunkSize bytes
+class InputTransport : public Transport {
+  std::string mInput;
+  std::size_t mChunkSize;
+  std::size_t mPos = 0;
+
+public:
+  InputTransport(std::string input, std::size_t chunkSize)
+      : mInput(std::move(input)), mChunkSize(chunkSize) {}
+
+  void write(std::span<const std::byte>) override {}
+
+  void read(std::span<std::byte> &bytes) override {
+    auto count = std::min({bytes.size(), mChunkSize, mInput.size() - mPos});
+    std::memcpy(bytes.data(), mInput.data() + mPos, count);
+    mPos += count;
+    bytes = bytes.first(count);
+  }
+};
+
+static std::string makeFrame(std::string_view body) {
+  return "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" +
+         std::string(body);
+}
+
+static std::string_view getBody(const Frame &frame) {
+  return {reinterpret_cast<const char *>(frame.body.data()),
+          frame.body.size()};
+}
+
+static void testSplitInput() {
+  auto input = makeFrame(R"({"id":1})") + makeFrame(R"({"id":2})");
+
+  for (std::size_t chunkSize : {1, 3, 7, 4096}) {
+    InputTransport transport(input, chunkSize);
+    FrameDecoder decoder;
+
+    auto first = decoder.next(transport);
+    CHECK(first && getBody(*first) == R"({"id":1})");
+
+    auto second = decoder.next(transport);
+    CHECK(second && getBody(*second) == R"({"id":2})");
+
+    CHECK(!decoder.next(transport));
+  }
+}
+
+// body of frame with invalid header is dropped even if it looks like header
+static void testInvalidHeaderSkipsBody() {
+  auto body = makeFrame("X");
+  auto input = "Content-Length: " + std::to_string(body.size()) +
+               "\r\nContent-Handles: x\r\n\r\n" + body + makeFrame("{}");
+
+  for (std::size_t chunkSize : {1, 4096}) {
+    InputTransport transport(input, chunkSize);
+    FrameDecoder decoder;
+
+    auto frame = decoder.next(transport);
+    CHECK(frame && getBody(*frame) == "{}");
+    CHECK(!decoder.next(transport));
+  }
+}
+
+// without usable length decoder waits for the next frame
+static void testResync() {
+  auto input = "Content-Length: 1x\r\n\r\nContent-Type: text\r\n\r\n" +
+               makeFrame("{}");
+
+  for (std::size_t chunkSize : {1, 5, 4096}) {
+    InputTransport transport(input, chunkSize);
+    FrameDecoder decoder;
+
+    auto frame = decoder.next(transport);
+    CHECK(frame && getBody(*frame) == "{}");
+    CHECK(!decoder.next(transport));
+  }
+}
+
+// leased bodies stay in place while decoder continues in other buffers
+static void testLeasedFrames() {
+  std::string input;
+  std::vector<std::string> bodies;
+
+  for (int i = 0; i < 200; ++i) {
+    bodies.push_back(std::string(100 + i * 7, static_cast<char>('a' + i % 26)));
+    input += makeFrame(bodies.back());
+  }
+
+  InputTransport transport(input, 1000);
+  FrameDecoder decoder(256);
+  std::vector<Frame> frames;
+
+  while (auto frame = decoder.next(transport)) {
+    frames.push_back(std::move(*frame));
+  }
+
+  CHECK(frames.size() == bodies.size());
+
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    CHECK(frames[i].buffer);
+    CHECK(getBody(frames[i]) == bodies[i]);
+  }
+}
+
+int main() {
+  testSplitInput();
+  testInvalidHeaderSkipsBody();
+  testResync();
+  testLeasedFrames();
+}
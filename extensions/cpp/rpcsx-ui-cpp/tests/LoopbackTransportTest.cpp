@@ -0,0 +1,490 @@
+#include "Check.hpp"
+#include "rpcsx/ui/Call.hpp"
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include "rpcsx/ui/LoopbackTransport.hpp"
+#include "rpcsx/ui/ProtocolFactory.hpp"
+#include "rpcsx/ui/extension.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace rpcsx::ui;
+
+static void sendMessage(Transport &transport, const json &message) {
+  auto body = message.dump();
+  auto frame = "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+  frame += body;
+  transport.write(std::as_bytes(std::span(frame)));
+}
+
+static json receiveMessage(FrameDecoder &decoder, Transport &transport) {
+  auto frame = decoder.next(transport);
+  CHECK(frame.has_value());
+
+  auto body = reinterpret_cast<const char *>(frame->body.data());
+  return json::parse(body, body + frame->body.size());
+}
+
+// bytes cross ring that is much smaller than the data in order, end of
+// stream is reported once peer is gone
+static void testByteStream() {
+  auto [first, second] = LoopbackTransport::createPair(4096);
+
+  std::vector<std::byte> data(1024 * 1024);
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<std::byte>(i * 31 + i / 4096);
+  }
+
+  std::thread writer([&data, end = std::move(first)]() mutable {
+    for (std::size_t offset = 0; offset < data.size(); offset += 1000) {
+      end->write(std::span(data).subspan(
+          offset, std::min<std::size_t>(1000, data.size() - offset)));
+    }
+
+    end.reset();
+  });
+
+  std::vector<std::byte> received;
+  std::byte buffer[3000];
+  while (true) {
+    std::span<std::byte> bytes = buffer;
+    second->read(bytes);
+
+    if (bytes.empty()) {
+      break;
+    }
+
+    received.insert(received.end(), bytes.begin(), bytes.end());
+  }
+
+  writer.join();
+  CHECK(received == data);
+}
+
+// host calls extension method and extension calls host through protocol
+// running on the other end
+static void testProtocolRoundTrip() {
+  auto [host, extension] = LoopbackTransport::createPair();
+  auto protocol = findProtocolFactory("json-rpc")(extension.get(), {});
+  ExtensionBase handlers;
+  protocol->setHandlers(&handlers);
+  Protocol::setDefault(protocol.get());
+
+  protocol->addMethodHandler("test/echo", [&](std::size_t id, json params) {
+    protocol->sendResponse(id, std::move(params));
+  });
+
+  std::thread session([&] { protocol->processMessages(); });
+
+  FrameDecoder decoder;
+  sendMessage(*host, {{"jsonrpc", "2.0"},
+                      {"id", 7},
+                      {"method", "test/echo"},
+                      {"params", {{"value", 42}}}});
+
+  auto response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == 7);
+  CHECK(response["result"]["value"] == 42);
+
+  sendMessage(*host,
+              {{"jsonrpc", "2.0"}, {"id", 8}, {"method", "test/missing"}});
+  response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == 8);
+  CHECK(response.contains("error"));
+
+  // ids with the high bit set are reserved for requests of batches
+  constexpr std::uint64_t kReservedId = (1ull << 63) | 9;
+  sendMessage(*host, {{"jsonrpc", "2.0"},
+                      {"id", kReservedId},
+                      {"method", "test/echo"},
+                      {"params", 1}});
+  response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == kReservedId);
+  CHECK(response["error"]["code"] == int(ErrorCode::InvalidRequest));
+
+  // string and signed ids are answered with the id request came with
+  sendMessage(*host, {{"jsonrpc", "2.0"},
+                      {"id", "abc"},
+                      {"method", "test/echo"},
+                      {"params", 2}});
+  response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == "abc");
+  CHECK(response["result"] == 2);
+
+  sendMessage(*host,
+              {{"jsonrpc", "2.0"}, {"id", -1}, {"method", "test/missing"}});
+  response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == -1);
+  CHECK(response["error"]["code"] == int(ErrorCode::MethodNotFound));
+
+  std::atomic<bool> answered = false;
+  protocol->call("host/echo", {{"text", "ping"}},
+                 [&](json result, bool isError) {
+                   CHECK(!isError);
+                   CHECK(result["text"] == "ping");
+                   answered = true;
+                 });
+
+  auto request = receiveMessage(decoder, *host);
+  CHECK(request["method"] == "host/echo");
+  sendMessage(*host, {{"jsonrpc", "2.0"},
+                      {"id", request["id"]},
+                      {"result", request["params"]}});
+
+  // batch response is decoded into arena of the message and handlers see it
+  // before the arena is reset, copies they keep come from heap
+  std::atomic<int> batchAnswered = 0;
+  ArenaJson keptResult;
+  std::vector<Protocol::BatchCall> calls;
+  calls.push_back({"host/stat", "a",
+                   [&](const ArenaJson &result, bool isError) {
+                     CHECK(MessageArena::getCurrent() == nullptr);
+                     CHECK(!isError && result["size"] == 1);
+                     keptResult = result;
+                     batchAnswered++;
+                   }});
+  calls.push_back({"host/stat", "b",
+                   [&](const ArenaJson &error, bool isError) {
+                     CHECK(isError && error["code"] == -1);
+                     batchAnswered++;
+                   }});
+  protocol->callBatch(std::move(calls));
+
+  auto batch = receiveMessage(decoder, *host);
+  CHECK(batch.is_array() && batch.size() == 2);
+  sendMessage(*host, json::array({
+                         {{"jsonrpc", "2.0"},
+                          {"id", batch[1]["id"]},
+                          {"error", {{"code", -1}}}},
+                         {{"jsonrpc", "2.0"},
+                          {"id", batch[0]["id"]},
+                          {"result", {{"size", 1}}}},
+                     }));
+
+  host->shutdown();
+  session.join();
+  CHECK(answered);
+  CHECK(batchAnswered == 2);
+  CHECK(keptResult["size"] == 1);
+
+  Protocol::setDefault(nullptr);
+}
+
+// async object method that fails is answered with InternalError instead of
+// terminating the extension
+static void testAsyncHandlerFailure() {
+  auto [host, extension] = LoopbackTransport::createPair();
+  auto protocol = findProtocolFactory("json-rpc")(extension.get(), {});
+  ExtensionBase handlers;
+  protocol->setHandlers(&handlers);
+
+  static int object;
+  protocol->addObject(
+      "test/failing",
+      [](InterfaceBuilder &builder) {
+        builder.addAsyncMethodHandler(
+            "fail", [](void *, const RequestParams &) -> Task<ResponseResult> {
+              throw std::runtime_error("failed");
+              co_return ResponseResult(json());
+            });
+      },
+      1, ProtocolObject(&object, [](void *) {}));
+
+  std::thread session([&] { protocol->processMessages(); });
+
+  FrameDecoder decoder;
+  sendMessage(*host, {{"jsonrpc", "2.0"},
+                      {"id", 3},
+                      {"method", "$/object/call"},
+                      {"params", {{"object", 1}, {"method", "fail"}}}});
+
+  auto response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == 3);
+  CHECK(response["error"]["code"] == int(ErrorCode::InternalError));
+  CHECK(response["error"]["message"] == "failed");
+
+  host->shutdown();
+  session.join();
+}
+
+// describe that host cancels sees stop request. Cancellation finds request
+// by id host sent, also when id is string or request came in batch.
+// Malformed cancellation is not answered
+static void testCancelDescribe() {
+  auto [host, extension] = LoopbackTransport::createPair();
+  auto protocol = findProtocolFactory("json-rpc")(extension.get(), {});
+  ExtensionBase handlers;
+  protocol->setHandlers(&handlers);
+
+  static std::atomic<int> started = 0;
+  static int object;
+  protocol->addObject(
+      "test/describer",
+      [](InterfaceBuilder &builder) {
+        builder.addAsyncMethodHandler(
+            "describe",
+            [](void *, const RequestParams &) -> Task<ResponseResult> {
+              auto stopToken = Protocol::getRequestStopToken();
+              started++;
+
+              while (!stopToken.stop_requested()) {
+                std::this_thread::yield();
+              }
+
+              co_return ResponseResult(json("cancelled"));
+            });
+      },
+      1, ProtocolObject(&object, [](void *) {}));
+
+  std::thread session([&] { protocol->processMessages(); });
+
+  auto describe = [](json id) {
+    return json{{"jsonrpc", "2.0"},
+                {"id", std::move(id)},
+                {"method", "$/object/call"},
+                {"params", {{"object", 1}, {"method", "describe"}}}};
+  };
+
+  auto cancel = [&](json params) {
+    sendMessage(*host, {{"jsonrpc", "2.0"},
+                        {"method", "$/cancelRequest"},
+                        {"params", std::move(params)}});
+  };
+
+  auto waitStarted = [](int count) {
+    while (started < count) {
+      std::this_thread::yield();
+    }
+  };
+
+  FrameDecoder decoder;
+  sendMessage(*host, describe("abc"));
+  waitStarted(1);
+  cancel({{"id", "abc"}});
+
+  auto response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == "abc" && response["result"] == "cancelled");
+
+  sendMessage(*host, json::array({describe(5)}));
+  waitStarted(2);
+  cancel({{"id", 5}});
+
+  response = receiveMessage(decoder, *host);
+  CHECK(response.is_array() && response.size() == 1);
+  CHECK(response[0]["id"] == 5 && response[0]["result"] == "cancelled");
+
+  cancel("malformed");
+  cancel({{"id", {{"nested", 1}}}});
+
+  sendMessage(*host, describe(6));
+  waitStarted(3);
+  cancel({{"id", 6}});
+
+  response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == 6 && response["result"] == "cancelled");
+
+  host->shutdown();
+  session.join();
+}
+
+// handler that awaits call to host resumes on strand of its object, it does
+// not run while other handler of the object is running
+static void testResumeOnStrand() {
+  auto [host, extension] = LoopbackTransport::createPair();
+  auto protocol = findProtocolFactory("json-rpc")(extension.get(), {});
+  ExtensionBase handlers;
+  protocol->setHandlers(&handlers);
+
+  static Protocol *caller;
+  static std::atomic<bool> blocking = false;
+  static std::atomic<bool> released = false;
+  static int object;
+  caller = protocol.get();
+
+  protocol->addObject(
+      "test/ordered",
+      [](InterfaceBuilder &builder) {
+        builder.addAsyncMethodHandler(
+            "fetch", [](void *, const RequestParams &) -> Task<ResponseResult> {
+              auto value = co_await Call<json>(*caller, "host/value", {});
+              co_return ResponseResult(json{{"value", value.value()},
+                                            {"overlapped", blocking.load()}});
+            });
+
+        builder.addMethodHandler(
+            "block", [](void *, const RequestParams &) {
+              blocking = true;
+              while (!released) {
+                std::this_thread::yield();
+              }
+
+              blocking = false;
+              return ResponseResult(json("done"));
+            });
+      },
+      1, ProtocolObject(&object, [](void *) {}));
+
+  std::thread session([&] { protocol->processMessages(); });
+
+  auto callObject = [&](std::uint64_t id, const char *method) {
+    sendMessage(*host, {{"jsonrpc", "2.0"},
+                        {"id", id},
+                        {"method", "$/object/call"},
+                        {"params", {{"object", 1}, {"method", method}}}});
+  };
+
+  FrameDecoder decoder;
+  callObject(1, "fetch");
+
+  auto request = receiveMessage(decoder, *host);
+  CHECK(request["method"] == "host/value");
+
+  callObject(2, "block");
+  while (!blocking) {
+    std::this_thread::yield();
+  }
+
+  // fetch would resume right away and see block running without strand
+  sendMessage(*host,
+              {{"jsonrpc", "2.0"}, {"id", request["id"]}, {"result", 42}});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  released = true;
+
+  auto response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == 2 && response["result"] == "done");
+
+  response = receiveMessage(decoder, *host);
+  CHECK(response["id"] == 1);
+  CHECK(response["result"]["value"] == 42);
+  CHECK(response["result"]["overlapped"] == false);
+
+  host->shutdown();
+  session.join();
+}
+
+// calls of reentrant top level method run in parallel, calls of other
+// method run one at a time
+static void testReentrantMethod() {
+  auto [host, extension] = LoopbackTransport::createPair();
+  auto protocol = findProtocolFactory("json-rpc")(extension.get(), {});
+  ExtensionBase handlers;
+  protocol->setHandlers(&handlers);
+
+  std::atomic<int> meeting = 0;
+  protocol->addMethodHandler(
+      "test/meet",
+      [&](std::size_t id, json) {
+        meeting++;
+
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (meeting < 2 && std::chrono::steady_clock::now() < deadline) {
+          std::this_thread::yield();
+        }
+
+        protocol->sendResponse(id, meeting >= 2);
+      },
+      true);
+
+  std::atomic<int> active = 0;
+  protocol->addMethodHandler("test/serial", [&](std::size_t id, json) {
+    bool overlapped = ++active > 1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    active--;
+    protocol->sendResponse(id, overlapped);
+  });
+
+  std::thread session([&] { protocol->processMessages(); });
+
+  auto call = [&](std::uint64_t id, const char *method) {
+    sendMessage(*host, {{"jsonrpc", "2.0"}, {"id", id}, {"method", method}});
+  };
+
+  FrameDecoder decoder;
+  call(1, "test/meet");
+  call(2, "test/meet");
+
+  for (int i = 0; i < 2; ++i) {
+    CHECK(receiveMessage(decoder, *host)["result"] == true);
+  }
+
+  call(3, "test/serial");
+  call(4, "test/serial");
+
+  for (int i = 0; i < 2; ++i) {
+    CHECK(receiveMessage(decoder, *host)["result"] == false);
+  }
+
+  host->shutdown();
+  session.join();
+}
+
+// handlers of each session see their own protocol as default, nothing is
+// shared through process wide default
+static void testSessionDefault() {
+  struct Session {
+    std::unique_ptr<LoopbackTransport> host;
+    std::unique_ptr<LoopbackTransport> extension;
+    std::unique_ptr<Protocol> protocol;
+    std::thread thread;
+  };
+
+  Session sessions[2];
+
+  for (auto &session : sessions) {
+    std::tie(session.host, session.extension) =
+        LoopbackTransport::createPair();
+    session.protocol =
+        findProtocolFactory("json-rpc")(session.extension.get(), {});
+
+    auto protocol = session.protocol.get();
+    protocol->addMethodHandler("test/session", [protocol](std::size_t id,
+                                                          json) {
+      protocol->sendResponse(id, Protocol::getDefault() == protocol);
+    });
+
+    session.thread = std::thread([protocol] {
+      runSession(
+          [](Protocol *protocol) {
+            auto handlers = std::make_unique<ExtensionBase>();
+            protocol->setHandlers(handlers.get());
+            return handlers;
+          },
+          protocol);
+    });
+  }
+
+  for (auto &session : sessions) {
+    FrameDecoder decoder;
+    sendMessage(*session.host,
+                {{"jsonrpc", "2.0"}, {"id", 1}, {"method", "test/session"}});
+
+    auto response = receiveMessage(decoder, *session.host);
+    CHECK(response["result"] == true);
+  }
+
+  CHECK(Protocol::getDefault() == nullptr);
+
+  for (auto &session : sessions) {
+    session.host->shutdown();
+    session.thread.join();
+  }
+}
+
+int main() {
+  testByteStream();
+  testProtocolRoundTrip();
+  testAsyncHandlerFailure();
+  testCancelDescribe();
+  testResumeOnStrand();
+  testReentrantMethod();
+  testSessionDefault();
+}
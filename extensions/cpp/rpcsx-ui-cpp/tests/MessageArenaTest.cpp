@@ -0,0 +1,181 @@
+#include "Check.hpp"
+#include "rpcsx/ui/JsonReader.hpp"
+#include "rpcsx/ui/MessageArena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace rpcsx::ui;
+
+static constexpr std::string_view kBatchResponse =
+    R"([{"id":1,"jsonrpc":"2.0","result":{"size":10,"type":1}},)"
+    R"({"error":{"code":-32601,"message":"no such file"},"id":2,)"
+    R"("jsonrpc":"2.0"}])";
+
+static void testAllocate() {
+  MessageArena arena;
+
+  for (std::size_t alignment : {1, 8, 16, 64}) {
+    auto pointer = arena.allocate(3, alignment);
+    CHECK(reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0);
+    CHECK(arena.owns(pointer));
+  }
+
+  int local;
+  CHECK(!arena.owns(&local));
+}
+
+// memory of blocks is merged on reset, the same load fits without new blocks
+static void testResetKeepsMemory() {
+  MessageArena arena;
+
+  auto fill = [&] {
+    for (int i = 0; i < 100; ++i) {
+      arena.allocate(1000, 8);
+    }
+  };
+
+  fill();
+  auto capacity = arena.getCapacity();
+  CHECK(capacity >= 100 * 1000);
+
+  arena.reset();
+  CHECK(arena.getCapacity() == capacity);
+
+  fill();
+  CHECK(arena.getCapacity() == capacity);
+}
+
+static void testLargeMessageReleased() {
+  MessageArena arena;
+  arena.allocate(2 * 1024 * 1024, 8);
+  arena.reset();
+  CHECK(arena.getCapacity() == 0);
+}
+
+static void testScope() {
+  MessageArena outer;
+  MessageArena inner;
+  CHECK(MessageArena::getCurrent() == nullptr);
+
+  {
+    MessageArena::Scope outerScope(outer);
+    CHECK(MessageArena::getCurrent() == &outer);
+
+    {
+      MessageArena::Scope innerScope(inner);
+      CHECK(MessageArena::getCurrent() == &inner);
+    }
+
+    CHECK(MessageArena::getCurrent() == &outer);
+  }
+
+  CHECK(MessageArena::getCurrent() == nullptr);
+}
+
+// response DOM comes from current arena, values outside of scope come from
+// heap
+static void testArenaJson() {
+  MessageArena arena;
+
+  auto parse = [&] {
+    MessageArena::Scope scope(arena);
+    auto message = ArenaJson::parse(kBatchResponse);
+
+    CHECK(message.is_array() && message.size() == 2);
+    CHECK(message[0]["result"]["size"] == 10);
+    CHECK(message[1]["error"]["code"] == -32601);
+    CHECK(toJsonText(message[0]["result"]) == R"({"size":10,"type":1})");
+  };
+
+  parse();
+  auto capacity = arena.getCapacity();
+  CHECK(capacity > 0);
+
+  arena.reset();
+  parse();
+  CHECK(arena.getCapacity() == capacity);
+  arena.reset();
+
+  auto heapMessage = ArenaJson::parse(kBatchResponse);
+  CHECK(heapMessage.size() == 2);
+  CHECK(arena.getCapacity() == capacity);
+}
+
+// values are released by the allocator they came from whatever arena is
+// current, copies made outside of scope outlive reset
+static void testCopyOutOfScope() {
+  MessageArena arena;
+  MessageArena other;
+  ArenaJson message;
+
+  {
+    MessageArena::Scope scope(arena);
+    message = ArenaJson::parse(kBatchResponse);
+  }
+
+  ArenaJson copy = message[1];
+  message = nullptr;
+  arena.reset();
+  CHECK(copy["error"]["code"] == -32601);
+
+  {
+    MessageArena::Scope scope(other);
+    copy = nullptr;
+  }
+
+  CHECK(other.getCapacity() == 0);
+}
+
+// reader of DOM decodes response without serializing it
+static void testReadDom() {
+  MessageArena arena;
+  MessageArena::Scope scope(arena);
+  auto message = ArenaJson::parse(kBatchResponse);
+
+  std::int64_t size = 0;
+  std::int64_t type = 0;
+  JsonReader reader(message[0]["result"]);
+  CHECK(reader.readObject([&](std::string_view key) {
+    if (key == "size") {
+      return reader.readInteger(size);
+    }
+
+    if (key == "type") {
+      return reader.readInteger(type);
+    }
+
+    return reader.skip();
+  }));
+  CHECK(reader.finish());
+  CHECK(size == 10 && type == 1);
+
+  std::string text;
+  JsonReader errorReader(message[1]["error"]);
+  CHECK(!errorReader.readObject([&](std::string_view key) {
+    if (key == "code") {
+      return errorReader.readString(text);
+    }
+
+    return errorReader.skip();
+  }));
+  CHECK(errorReader.error() == JsonReader::Error::Type);
+
+  std::string_view raw;
+  JsonReader rawReader(message[0]);
+  CHECK(rawReader.readObject([&](std::string_view key) {
+    return key == "result" ? rawReader.readRaw(raw) : rawReader.skip();
+  }));
+  CHECK(raw == R"({"size":10,"type":1})");
+}
+
+int main() {
+  testAllocate();
+  testResetKeepsMemory();
+  testLargeMessageReleased();
+  testScope();
+  testArenaJson();
+  testCopyOutOfScope();
+  testReadDom();
+}
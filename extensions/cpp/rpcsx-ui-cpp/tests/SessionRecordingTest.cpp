@@ -0,0 +1,95 @@
+#include "Check.hpp"
+#include "rpcsx/ui/FrameDecoder.hpp"
+#include "rpcsx/ui/LoopbackTransport.hpp"
+#include "rpcsx/ui/SessionRecording.hpp"
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unistd.h>
+
+using namespace rpcsx::ui;
+using nlohmann::json;
+
+static std::string makeFrame(const json &message) {
+  auto body = message.dump();
+  return "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static void writeText(Transport &transport, const std::string &text) {
+  transport.write(std::as_bytes(std::span(text)));
+}
+
+static json receiveMessage(FrameDecoder &decoder, Transport &transport) {
+  auto frame = decoder.next(transport);
+  CHECK(frame.has_value());
+
+  auto body = reinterpret_cast<const char *>(frame->body.data());
+  return json::parse(body, body + frame->body.size());
+}
+
+static json makeCall(std::uint64_t id, const json &params) {
+  return {{"jsonrpc", "2.0"},
+          {"id", id},
+          {"method", "host/echo"},
+          {"params", params}};
+}
+
+static json makeResponse(std::uint64_t id, const json &result) {
+  return {{"jsonrpc", "2.0"}, {"id", id}, {"result", result}};
+}
+
+// recorded responses get ids of calls extension makes on replay, calls with
+// the same method and params are matched in order
+static void testReplayRewritesIds() {
+  auto path = std::filesystem::temp_directory_path() /
+              ("rpcsx-ui-replay-" + std::to_string(::getpid()) + ".bin");
+
+  {
+    auto [host, extension] = LoopbackTransport::createPair();
+    auto recording = RecordingTransport::create(std::move(extension), path);
+    CHECK(recording.has_value());
+
+    writeText(**recording, makeFrame(makeCall(5, 1)) +
+                               makeFrame(makeCall(6, 1)) +
+                               makeFrame(makeCall(7, 2)));
+
+    // responses arrive out of order in one chunk, request of host is left
+    // as it is
+    writeText(*host, makeFrame(makeResponse(6, "second")) +
+                         makeFrame(makeCall(6, "host")) +
+                         makeFrame(makeResponse(7, "other")) +
+                         makeFrame(makeResponse(5, "first")));
+
+    FrameDecoder decoder;
+    for (int i = 0; i < 4; ++i) {
+      receiveMessage(decoder, **recording);
+    }
+  }
+
+  auto replay = ReplayTransport::open(path, ReplayTransport::Pacing::Fast);
+  std::filesystem::remove(path);
+  CHECK(replay.has_value());
+
+  // live ids differ from recorded ones, call is split across writes
+  auto calls = makeFrame(makeCall(7, 2)) + makeFrame(makeCall(40, 1)) +
+               makeFrame(makeCall(41, 1));
+  writeText(**replay, calls.substr(0, 10));
+  writeText(**replay, calls.substr(10));
+
+  FrameDecoder decoder;
+  auto response = receiveMessage(decoder, **replay);
+  CHECK(response["id"] == 41 && response["result"] == "second");
+
+  response = receiveMessage(decoder, **replay);
+  CHECK(response["id"] == 6 && response["method"] == "host/echo");
+
+  response = receiveMessage(decoder, **replay);
+  CHECK(response["id"] == 7 && response["result"] == "other");
+
+  response = receiveMessage(decoder, **replay);
+  CHECK(response["id"] == 40 && response["result"] == "first");
+
+  CHECK(!decoder.next(**replay).has_value());
+}
+
+int main() { testReplayRewritesIds(); }
@@ -0,0 +1,193 @@
+#include "Check.hpp"
+#include "rpcsx/ui/WorkerPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace rpcsx::ui;
+using namespace std::chrono_literals;
+
+static bool waitFor(const std::atomic<bool> &flag) {
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+
+  while (!flag.load()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+
+    std::this_thread::sleep_for(100us);
+  }
+
+  return true;
+}
+
+// tasks of one strand never overlap and run in posting order
+static void testStrandOrder() {
+  constexpr int kStrands = 64;
+  constexpr int kTasks = 2000;
+
+  struct State {
+    std::atomic<bool> running{false};
+    int last = -1;
+    bool failed = false;
+  };
+
+  std::vector<State> strands(kStrands);
+  std::atomic<int> done = 0;
+
+  {
+    WorkerPool pool(4);
+
+    for (int i = 0; i < kTasks; ++i) {
+      for (int id = 0; id < kStrands; ++id) {
+        pool.post(id, [&, id, i] {
+          auto &state = strands[id];
+          if (state.running.exchange(true) || state.last != i - 1) {
+            state.failed = true;
+          }
+
+          state.last = i;
+          state.running = false;
+          ++done;
+        });
+      }
+    }
+
+    while (done.load() < kStrands * kTasks) {
+      std::this_thread::yield();
+    }
+  }
+
+  for (auto &state : strands) {
+    CHECK(!state.failed);
+    CHECK(state.last == kTasks - 1);
+  }
+}
+
+// strands are keyed by exact id, a blocked strand does not hold others
+static void testStrandsIndependent() {
+  constexpr int kStrands = 4096;
+
+  WorkerPool pool(2);
+  std::atomic<int> others = 0;
+  std::atomic<bool> othersDone = false;
+  std::atomic<bool> finished = false;
+
+  pool.post(0, [&] { finished = waitFor(othersDone); });
+
+  for (WorkerPool::StrandId id = 1; id < kStrands; ++id) {
+    pool.post(id, [&] {
+      if (++others == kStrands - 1) {
+        othersDone = true;
+      }
+    });
+  }
+
+  CHECK(waitFor(othersDone));
+  CHECK(waitFor(finished));
+}
+
+// job posted while every worker is busy runs on the first worker that
+// becomes free, not behind the slow task
+static void testNoHeadOfLineBlocking() {
+  WorkerPool pool(2);
+  std::atomic<bool> slowReleased = false;
+  std::atomic<bool> slowStarted = false;
+  std::atomic<bool> shortStarted = false;
+  std::atomic<bool> fastDone = false;
+
+  pool.post([&] {
+    slowStarted = true;
+
+    while (!slowReleased) {
+      std::this_thread::sleep_for(100us);
+    }
+  });
+  pool.post([&] {
+    shortStarted = true;
+    std::this_thread::sleep_for(20ms);
+  });
+
+  CHECK(waitFor(slowStarted));
+  CHECK(waitFor(shortStarted));
+
+  constexpr int kFastTasks = 8;
+  std::atomic<int> fastCount = 0;
+
+  for (int i = 0; i < kFastTasks; ++i) {
+    auto task = [&] {
+      if (++fastCount == kFastTasks) {
+        fastDone = true;
+      }
+    };
+
+    if (i % 2 == 0) {
+      pool.post(std::move(task));
+    } else {
+      pool.post(i, std::move(task));
+    }
+  }
+
+  CHECK(waitFor(fastDone));
+  CHECK(!slowReleased);
+  slowReleased = true;
+}
+
+// jobs go back to the pool that allocated them, warm pool does not allocate
+// after the same thread posted to another pool
+static void testJobsStayInPool() {
+  constexpr int kTasks = 8;
+
+  struct Load {
+    std::atomic<int> done = 0;
+    std::atomic<int> expected = 0;
+    std::atomic<bool> idle = false;
+  };
+
+  Load first;
+  Load second;
+
+  auto onIdle = [](Load &load) {
+    return [&load] {
+      if (load.done == load.expected) {
+        load.idle = true;
+      }
+    };
+  };
+
+  WorkerPool firstPool(2, onIdle(first));
+  WorkerPool secondPool(2, onIdle(second));
+
+  auto run = [](WorkerPool &pool, Load &load, int count) {
+    load.done = 0;
+    load.expected = count;
+    load.idle = false;
+
+    for (int i = 0; i < count; ++i) {
+      pool.post([&load] { ++load.done; });
+    }
+
+    CHECK(waitFor(load.idle));
+  };
+
+  // jobs left by pools of other tests are not reused
+  run(firstPool, first, kTasks);
+  auto jobs = firstPool.getAllocatedJobs();
+  CHECK(jobs != 0);
+
+  for (int round = 0; round < 10; ++round) {
+    run(firstPool, first, 1);
+    run(secondPool, second, kTasks);
+  }
+
+  run(firstPool, first, kTasks);
+  CHECK(firstPool.getAllocatedJobs() == jobs);
+}
+
+int main() {
+  testStrandOrder();
+  testStrandsIndependent();
+  testNoHeadOfLineBlocking();
+  testJobsStayInPool();
+}
@@ -19,6 +19,18 @@ function hasContributions(component: Component) {
     return component.manifest.contributions != undefined;
 }
 
+// Interface handlers marked with `"reentrant": true` are not serialized with
+// other handlers of the same object
+function isReentrant(handler: object) {
+    return "reentrant" in handler && handler.reentrant === true;
+}
+
+// Methods marked with `"async": true` are coroutines returning Task, their
+// response is sent when the task completes
+function isAsync(handler: object) {
+    return "async" in handler && handler.async === true;
+}
+
 export class ExtensionApiGenerator implements ConfigGenerator {
     constructor(private config: CmakeGeneratorConfig) {
     }
@@ -160,6 +172,8 @@ class CppTypesGenerator implements ContributionGenerator {
             paramsType += `struct ${labelName} {\n${this.generateObjectBody(component, type.params)}};\n\n`;
             paramsType += this.generateObjectSerializer(labelName, type.params);
             paramsType += this.generateObjectDeserializer(labelName, type.params);
+            paramsType += this.generateObjectReader(labelName, type.params);
+            paramsType += this.generateObjectWriter(labelName, type.params);
         } else if (type.type === "enum") {
             if (!("enumerators" in type)) {
                 throw `${type}: enumerators must be present`;
@@ -233,6 +247,8 @@ class CppTypesGenerator implements ContributionGenerator {
                     paramsType += "};\n";
                     paramsType += this.generateObjectSerializer(requestTypeName, method.params);
                     paramsType += this.generateObjectDeserializer(requestTypeName, method.params);
+                    paramsType += this.generateObjectReader(requestTypeName, method.params);
+                    paramsType += this.generateObjectWriter(requestTypeName, method.params);
                 } else if (typeof method.params == "string") {
                     paramsType += `using ${requestTypeName} = ${this.getTypeName(component, method.params)};\n`;
                 }
@@ -240,6 +256,8 @@ class CppTypesGenerator implements ContributionGenerator {
                 paramsType += `struct ${requestTypeName} {};\n`;
                 paramsType += this.generateObjectSerializer(requestTypeName, {});
                 paramsType += this.generateObjectDeserializer(requestTypeName, {});
+                paramsType += this.generateObjectReader(requestTypeName, {});
+                paramsType += this.generateObjectWriter(requestTypeName, {});
             }
             this.body += paramsType;
         }
@@ -254,6 +272,8 @@ class CppTypesGenerator implements ContributionGenerator {
                     responseType += "};\n";
                     responseType += this.generateObjectSerializer(responseTypeName, method.returns);
                     responseType += this.generateObjectDeserializer(responseTypeName, method.returns);
+                    responseType += this.generateObjectReader(responseTypeName, method.returns);
+                    responseType += this.generateObjectWriter(responseTypeName, method.returns);
                 } else if (typeof method.returns == "string") {
                     responseType += `using ${responseTypeName} = ${this.getTypeName(component, method.returns)};\n`;
                 }
@@ -261,6 +281,8 @@ class CppTypesGenerator implements ContributionGenerator {
                 responseType += `struct ${responseTypeName} {};\n`;
                 responseType += this.generateObjectSerializer(responseTypeName, {});
                 responseType += this.generateObjectDeserializer(responseTypeName, {});
+                responseType += this.generateObjectReader(responseTypeName, {});
+                responseType += this.generateObjectWriter(responseTypeName, {});
             }
 
             this.body += responseType;
@@ -287,6 +309,8 @@ class CppTypesGenerator implements ContributionGenerator {
                     paramsType += "};\n";
                     paramsType += this.generateObjectSerializer(requestTypeName, notification.params);
                     paramsType += this.generateObjectDeserializer(requestTypeName, notification.params);
+                    paramsType += this.generateObjectReader(requestTypeName, notification.params);
+                    paramsType += this.generateObjectWriter(requestTypeName, notification.params);
                 } else if (typeof notification.params == "string") {
                     paramsType += `using ${requestTypeName} = ${this.getTypeName(component, notification.params)};\n`;
                 }
@@ -294,6 +318,8 @@ class CppTypesGenerator implements ContributionGenerator {
                 paramsType += `struct ${requestTypeName} {};\n`;
                 paramsType += this.generateObjectSerializer(requestTypeName, {});
                 paramsType += this.generateObjectDeserializer(requestTypeName, {});
+                paramsType += this.generateObjectReader(requestTypeName, {});
+                paramsType += this.generateObjectWriter(requestTypeName, {});
             }
             this.body += paramsType;
         }
@@ -306,6 +332,24 @@ class CppTypesGenerator implements ContributionGenerator {
 
     generateInterface(component: string, iface: object, name: string) {
         const labelName = generateComponentLabelName(component, name + "-interface", true);
+        const methods = "methods" in iface && iface.methods ? Object.keys(iface.methods) : [];
+        const notifications = "notifications" in iface && iface.notifications ? Object.keys(iface.notifications) : [];
+
+        // handler tables are laid out by compiler, empty interfaces have none
+        const generateTable = (label: string, names: string[]) => names.length == 0 ? "" : `
+        static constexpr std::string_view k${label}Names[] = {${names.map(name => `"${name}"`).join(", ")}};
+        static constexpr auto k${label}Table = makePerfectHashTable(k${label}Names);`;
+        const generateSetTable = (label: string, names: string[]) => names.length == 0 ? "" : `
+            builder.set${label}Table(k${label}Table.seed, k${label}Table.slotNames);`;
+        this.addInclude("string_view");
+        this.addInclude("rpcsx/ui/PerfectHash.hpp");
+        this.addInclude("rpcsx/ui/RequestParams.hpp");
+        this.addInclude("rpcsx/ui/ResponseResult.hpp");
+
+        if ("methods" in iface && iface.methods && Object.values(iface.methods).some(method => isAsync(method))) {
+            this.addInclude("rpcsx/ui/Task.hpp");
+        }
+
         this.body += `struct ${labelName} {
     static constexpr auto kInterfaceId = "${component}/${name}";
     using InterfaceType = ${labelName};
@@ -314,10 +358,11 @@ class CppTypesGenerator implements ContributionGenerator {
 
 ${"methods" in iface ? iface.methods && Object.keys(iface.methods).map(method => {
             const methodTypeLabel = generateComponentLabelName(component, `${name}-${method}`, true);
+            const returnType = isAsync((iface.methods as any)[method]) ? `Task<${methodTypeLabel}Response>` : `${methodTypeLabel}Response`;
             if ("params" in (iface.methods as any)[method]) {
-                return `    virtual ${methodTypeLabel}Response ${generateLabelName(method, false)}(const ${methodTypeLabel}Request &request) = 0;`
+                return `    virtual ${returnType} ${generateLabelName(method, false)}(const ${methodTypeLabel}Request &request) = 0;`
             } else {
-                return `    virtual ${methodTypeLabel}Response ${generateLabelName(method, false)}() = 0;`
+                return `    virtual ${returnType} ${generateLabelName(method, false)}() = 0;`
             }
         }).join("\n") : ""}
 ${"notifications" in iface ? iface.notifications && Object.keys(iface.notifications).map(notification => {
@@ -329,35 +374,56 @@ ${"notifications" in iface ? iface.notifications && Object.keys(iface.notificati
             }
         }).join("\n") : ""}
         
-    struct Builder {
+    struct Builder {${generateTable("Method", methods)}${generateTable("Notification", notifications)}
+
         template<typename ObjectBuilder>
-        static void build(ObjectBuilder &builder) {
+        static void build(ObjectBuilder &builder) {${generateSetTable("Method", methods)}${generateSetTable("Notification", notifications)}
 ${"methods" in iface ? iface.methods && Object.keys(iface.methods).map(method => {
+            const reentrant = isReentrant((iface.methods as any)[method]) ? ", true" : "";
+            if (isAsync((iface.methods as any)[method])) {
+                const methodTypeLabel = generateComponentLabelName(component, `${name}-${method}`, true);
+                const hasParams = "params" in (iface.methods as any)[method];
+
+                // request is decoded before coroutine starts, so decoding
+                // errors reach the caller. Coroutine keeps its copy until the
+                // handler completes
+                return `
+            builder.addAsyncMethodHandler("${method}",  [](void *object, const RequestParams &${hasParams ? "params" : ""}) {
+                return [](${labelName} *object${hasParams ? `, ${methodTypeLabel}Request request` : ""}) -> Task<ResponseResult> {
+                    auto response = co_await object->${generateLabelName(method, false)}(${hasParams ? "request" : ""});
+                    co_return ResponseResult(std::move(response));
+                }(static_cast<${labelName} *>(object)${hasParams ? `, params.get<${methodTypeLabel}Request>()` : ""});
+            }${reentrant});`
+            }
+
             if ("params" in (iface.methods as any)[method]) {
+                const methodTypeLabel = generateComponentLabelName(component, `${name}-${method}`, true);
                 return `
-            builder.addMethodHandler("${method}",  [](void *object, const nlohmann::json &request) {
-                return nlohmann::json(static_cast<${labelName} *>(object)->${generateLabelName(method, false)}(request));
-            });`
+            builder.addMethodHandler("${method}",  [](void *object, const RequestParams &params) {
+                return ResponseResult(static_cast<${labelName} *>(object)->${generateLabelName(method, false)}(params.get<${methodTypeLabel}Request>()));
+            }${reentrant});`
 
             } else {
                 return `
-            builder.addMethodHandler("${method}",  [](void *object, const nlohmann::json &) {
-                return nlohmann::json(static_cast<${labelName} *>(object)->${generateLabelName(method, false)}());
-            });`
+            builder.addMethodHandler("${method}",  [](void *object, const RequestParams &) {
+                return ResponseResult(static_cast<${labelName} *>(object)->${generateLabelName(method, false)}());
+            }${reentrant});`
             }
         }).join("\n") : ""}
 ${"notifications" in iface ? iface.notifications && Object.keys(iface.notifications).map(notification => {
+            const reentrant = isReentrant((iface.notifications as any)[notification]) ? ", true" : "";
             if ("params" in (iface.notifications as any)[notification]) {
+                const notificationTypeLabel = generateComponentLabelName(component, `${name}-${notification}`, true);
                 return `
-            builder.addNotificationHandler("${notification}",  [](void *object, const nlohmann::json &request) {
-                static_cast<${labelName} *>(object)->${generateLabelName(notification, false)}(request);
-            });`
+            builder.addNotificationHandler("${notification}",  [](void *object, const RequestParams &params) {
+                static_cast<${labelName} *>(object)->${generateLabelName(notification, false)}(params.get<${notificationTypeLabel}Request>());
+            }${reentrant});`
 
             } else {
                 return `
-            builder.addNotificationHandler("${notification}",  [](void *object, const nlohmann::json &) {
+            builder.addNotificationHandler("${notification}",  [](void *object, const RequestParams &) {
                 static_cast<${labelName} *>(object)->${generateLabelName(notification, false)}();
-            });`
+            }${reentrant});`
             }
         }).join("\n") : ""}
 
@@ -377,6 +443,8 @@ ${"notifications" in iface ? iface.notifications && Object.keys(iface.notificati
             paramsType += "};\n"
             paramsType += this.generateObjectSerializer(typeName, event);
             paramsType += this.generateObjectDeserializer(typeName, event);
+            paramsType += this.generateObjectReader(typeName, event);
+            paramsType += this.generateObjectWriter(typeName, event);
             this.body += paramsType;
         } else if (typeof event == 'string') {
             this.body += `using ${typeName} = ${this.getTypeName(component, event)};\n`;
@@ -444,6 +512,51 @@ ${Object.keys(body).map(field => `        { "${generateLabelName(field, false)}"
 }\n\n`;
     }
 
+    generateObjectWriter(typename: string, body: object): string {
+        this.addInclude("rpcsx/ui/JsonWriter.hpp");
+
+        return `inline void write_json(rpcsx::ui::JsonWriter &writer, const ${typename} &${Object.keys(body).length > 0 ? "value" : ""}) {
+    writer.beginObject();
+${Object.keys(body).map(field => `    writer.key("${generateLabelName(field, false)}");
+    write_json(writer, value.${generateLabelName(field, false)});
+`).join("")}    writer.endObject();
+}\n\n`;
+    }
+
+    generateObjectReader(typename: string, body: object): string {
+        this.addInclude("rpcsx/ui/JsonReader.hpp");
+
+        const fields = Object.keys(body).map(field => {
+            const fieldObject = (body as any)[field];
+            return {
+                label: generateLabelName(field, false),
+                isOptional: ("optional" in fieldObject) && fieldObject.optional === true,
+            };
+        });
+
+        if (fields.length == 0) {
+            // like from_json, members of empty type are ignored
+            return `inline bool read_json(rpcsx::ui::JsonReader &reader, ${typename} &) {
+    return reader.skip();
+}\n\n`;
+        }
+
+        const required = fields.filter(field => !field.isOptional);
+        const foundName = (label: string) => `found${label.charAt(0).toUpperCase()}${label.slice(1)}`;
+
+        return `inline bool read_json(rpcsx::ui::JsonReader &reader, ${typename} &value) {
+${required.map(field => `    bool ${foundName(field.label)} = false;\n`).join("")}${fields.filter(field => field.isOptional).map(field => `    value.${field.label} = std::nullopt;\n`).join("")}
+    bool result = reader.readObject([&](std::string_view key) {
+${fields.map(field => `        if (key == "${field.label}") {
+${field.isOptional ? "" : `            ${foundName(field.label)} = true;\n`}            return read_json(reader, value.${field.label});
+        }
+`).join("")}        return reader.skip();
+    });
+
+    return result${required.length > 0 ? ` && reader.require(${required.map(field => foundName(field.label)).join(" && ")})` : ""};
+}\n\n`;
+    }
+
     generateObjectDeserializer(typename: string, body: object): string {
         this.addInclude("nlohmann/json.hpp");
 
@@ -479,12 +592,15 @@ class CppApiGenerator implements ContributionGenerator {
 #include "rpcsx/ui/core/types.hpp"
 #include <expected>
 #include <functional>
-#include <future>
+#include <rpcsx/ui/Call.hpp>
 #include <type_traits>
 #include <memory>
 #include <utility>
 
 namespace ${this.namespace} {
+// Calls to ${this.componentName} component. Methods without callback return
+// lazy Call, nothing is sent until it is awaited or get() is called.
+// Overloads that take callback send the request right away
 template <typename InstanceT> class ${label}Instance {
 private:
     auto &extension() { return *static_cast<InstanceT *>(this); }
@@ -510,28 +626,14 @@ struct ${label} {
 
         this.content += `
     auto ${label}(${params == "" ? "" : `${params}, `}std::function<void(std::expected<${returnType}, ErrorInstance>)> cb) {
-        return protocol().call("${component}/${name}", ${params ? "params" : "{}"}, [cb = std::move(cb)](const nlohmann::json &response, bool isError) {
-            if (isError) {
-                cb(std::unexpected(response.get<ErrorInstance>()));
-            } else {
-                cb(${returnType == "void" ? `{}` : `response.get<${returnType}>()`});
-            }
+        return protocol().call("${component}/${name}", ${params ? "params" : "{}"}, [cb = std::move(cb)](const ArenaJson &response, bool isError) {
+            cb(Call<${returnType}>::decode(response, isError));
         });
     }`
         
         this.content += `
-    std::future<std::expected<${returnType}, ErrorInstance>> ${label}(${params}) {
-        auto promise = std::make_shared<std::promise<std::expected<${returnType}, ErrorInstance>>>();
-        auto result = promise->get_future();
-        protocol().call("${component}/${name}", ${params ? "params" : "{}"}, [promise = std::move(promise)](const nlohmann::json &response, bool isError) mutable {
-            if (isError) {
-                promise->set_value(std::unexpected(response.get<ErrorInstance>()));
-            } else {
-                promise->set_value(${returnType == "void" ? `{}` : `response.get<${returnType}>()`});
-            }
-        });
-
-        return result;
+    Call<${returnType}> ${label}(${params}) {
+        return {protocol(), "${component}/${name}", ${params ? "params" : "{}"}};
     }`
     }
 
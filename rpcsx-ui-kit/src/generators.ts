@@ -711,9 +711,9 @@ type ${uLabel}Interface = {
 ${"methods" in iface ? iface.methods && Object.keys(iface.methods).map(method => {
             const methodTypeLabel = generateComponentLabelName(component, `${name}-${method}`, true);
             if ("params" in (iface.methods as any)[method]) {
-                return `    ${generateLabelName(method, false)}(caller: ComponentRef, request: ${methodTypeLabel}Request): ${methodTypeLabel}Response | Promise<${methodTypeLabel}Response>`;
+                return `    ${generateLabelName(method, false)}(caller: ComponentRef, request: ${methodTypeLabel}Request, signal?: AbortSignal): ${methodTypeLabel}Response | Promise<${methodTypeLabel}Response>`;
             } else {
-                return `    ${generateLabelName(method, false)}(caller: ComponentRef): ${methodTypeLabel}Response | Promise<${methodTypeLabel}Response>`;
+                return `    ${generateLabelName(method, false)}(caller: ComponentRef, signal?: AbortSignal): ${methodTypeLabel}Response | Promise<${methodTypeLabel}Response>`;
             }
         }).join("\n") : ""}
 ${"notifications" in iface ? iface.notifications && Object.keys(iface.notifications).map(notification => {
@@ -826,8 +826,8 @@ class ServerPublicApiGenerator implements ContributionGenerator {
 import { thisComponent } from "$/component-info";
 import { ComponentInstance } from '$core/ComponentInstance';
 
-export async function call(caller: ComponentInstance, method: string, params?: Json): Promise<Json | void> {
-    return thisComponent().call(caller, method, params);
+export async function call(caller: ComponentInstance, method: string, params?: Json, signal?: AbortSignal): Promise<Json | void> {
+    return thisComponent().call(caller, method, params, signal);
 }
 
 export async function notify(caller: ComponentInstance, notification: string, params?: Json) {
@@ -849,15 +849,15 @@ export class ${uLabel}ComponentObject implements ComponentObject {
 
     constructor(public impl: ${uLabel}Interface, public name: string) {}
 
-    call(caller: ComponentRef, method: string, params: Json | undefined): Promise<Json | void> | Json | void {
+    call(caller: ComponentRef, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void> | Json | void {
         void caller, params;
 
         switch (method) {
 ${"methods" in iface ? iface.methods && Object.keys(iface.methods).map(method => {
         if ("params" in (iface.methods as any)[method]) {
-            return `            case "${method}": return this.impl.${generateLabelName(method, false)}(caller, params as any);\n`
+            return `            case "${method}": return this.impl.${generateLabelName(method, false)}(caller, params as any, signal);\n`
         } else {
-            return `            case "${method}": return this.impl.${generateLabelName(method, false)}(caller);\n`
+            return `            case "${method}": return this.impl.${generateLabelName(method, false)}(caller, signal);\n`
         }
     }).join("\n") : ""}
 
@@ -896,13 +896,13 @@ export class ${uLabel} {
 ${"methods" in iface ? iface.methods && Object.keys(iface.methods).map(method => {
         const methodTypeLabel = generateComponentLabelName(component, `${name}-${method}`, true);
         if ("params" in (iface.methods as any)[method]) {
-            return `    async ${generateLabelName(method, false)}(request: ${methodTypeLabel}Request): Promise<${methodTypeLabel}Response> {
-        return await ${component == "core" ? "" : "core."}objectCall({ object: this.id, method: "${method}", params: request}) as any;
+            return `    async ${generateLabelName(method, false)}(request: ${methodTypeLabel}Request, signal?: AbortSignal): Promise<${methodTypeLabel}Response> {
+        return await ${component == "core" ? "" : "core."}objectCall({ object: this.id, method: "${method}", params: request}, signal) as any;
     }
 `
         } else {
-            return `    async ${generateLabelName(method, false)}(): Promise<${methodTypeLabel}Response> {
-        return await ${component == "core" ? "" : "core."}objectCall({ object: this.id, method: "${method}", params: {}}) as any;
+            return `    async ${generateLabelName(method, false)}(signal?: AbortSignal): Promise<${methodTypeLabel}Response> {
+        return await ${component == "core" ? "" : "core."}objectCall({ object: this.id, method: "${method}", params: {}}, signal) as any;
     }
 `
         }
@@ -958,8 +958,8 @@ class ServerComponentApiGenerator implements ContributionGenerator {
 
         const label = generateComponentLabelName(component, name, false);
         const uLabel = generateComponentLabelName(component, name, true);
-        this.body += `export async function ${label}(params: ${uLabel}Request): Promise<${uLabel}Response> {
-    return ${generateLabelName(component, false)}.call(thisComponent(), "${name}", params) as any;
+        this.body += `export async function ${label}(params: ${uLabel}Request, signal?: AbortSignal): Promise<${uLabel}Response> {
+    return ${generateLabelName(component, false)}.call(thisComponent(), "${name}", params, signal) as any;
 }
 `;
     }
@@ -1045,7 +1045,7 @@ type ComponentObject = {
     typeId: string;
     name: string;
     impl: object;
-    call(caller: ComponentRef, method: string, params: Json | undefined): Promise<Json | void> | Json | void;
+    call(caller: ComponentRef, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void> | Json | void;
     notify(caller: ComponentRef, method: string, params: Json | undefined): void | Promise<void>;
     dispose(): void | Promise<void>;
 };
@@ -1115,16 +1115,17 @@ export function emit${label}Event(params: ${label}Event) {
         const label = generateComponentLabelName(component, name, false);
         const uLabel = generateComponentLabelName(component, name, true);
         this.body += `
-export async function call${uLabel}(caller: ComponentRef, params: ${uLabel}Request): Promise<${uLabel}Response> {
-    return impl.${method.handler}(caller, params);
+export async function call${uLabel}(caller: ComponentRef, params: ${uLabel}Request, signal?: AbortSignal): Promise<${uLabel}Response> {
+    const handler: (caller: ComponentRef, params: ${uLabel}Request, signal?: AbortSignal) => ${uLabel}Response | Promise<${uLabel}Response> = impl.${method.handler};
+    return handler(caller, params, signal);
 }
 
-export async function ${label}(params: ${uLabel}Request): Promise<${uLabel}Response> {
-    return impl.${method.handler}(thisComponent().view, params);
+export async function ${label}(params: ${uLabel}Request, signal?: AbortSignal): Promise<${uLabel}Response> {
+    return call${uLabel}(thisComponent().view, params, signal);
 }
 `;
         // FIXME: implement type validation
-        this.callBody += `        case "${name}": return call${uLabel}(caller, params as ${uLabel}Request);\n`;
+        this.callBody += `        case "${name}": return call${uLabel}(caller, params as ${uLabel}Request, signal);\n`;
     }
 
     generateNotification(component: string, notification: object, name: string) {
@@ -1222,7 +1223,7 @@ type ComponentObject = {
     typeId: string;
     name: string;
     impl: object;
-    call(caller: ComponentRef, method: string, params: Json | undefined): Promise<Json | void> | Json | void;
+    call(caller: ComponentRef, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void> | Json | void;
     notify(caller: ComponentRef, method: string, params: Json | undefined): void | Promise<void>;
     dispose(): void | Promise<void>;
 };
@@ -1245,8 +1246,8 @@ export function ownObjects() {
     return Object.values(objects);
 }
 
-export async function call(caller: ComponentRef, method: string, params: Json | undefined): Promise<Json | void> {
-    void caller, params;
+export async function call(caller: ComponentRef, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void> {
+    void caller, params, signal;
 
     switch (method) {
 ${this.callBody}
@@ -1254,7 +1255,8 @@ ${this.callBody}
             if (params && isJsonObject(params) && typeof params.method == "string" && typeof params.object == 'number') {
                 if (params.object in objects) {
                     return objects[params.object].call(caller, params.method,
-                        "params" in params ? params.params as any : undefined
+                        "params" in params ? params.params as any : undefined,
+                        signal
                     );
                 }
 
@@ -1802,8 +1804,8 @@ class ${componentLabel}ComponentImpl implements IComponentImpl {
         }
     }
 
-    async call(caller: ComponentRef, method: string, params?: Json) {
-        return await api.call(caller, method, params);
+    async call(caller: ComponentRef, method: string, params?: Json, signal?: AbortSignal) {
+        return await api.call(caller, method, params, signal);
     }
 
     async notify(caller: ComponentRef, notification: string, params?: Json) {
@@ -20,9 +20,9 @@ export type IComponentImpl = IDisposable & {
     initialize(eventEmitter: (event: string, params: Json) => void): void | Promise<void>;
     activate(context: ComponentContext, settings: Json, signal?: AbortSignal): void | Promise<void>;
     deactivate(context: ComponentContext): void | Promise<void>;
-    call?(caller: ComponentRef, method: string, params: Json | undefined): Promise<Json | void>;
+    call?(caller: ComponentRef, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void>;
     notify?(caller: ComponentRef, notification: string, params: Json | undefined): Promise<void>;
-    objectCall?(caller: ComponentRef, object: number, method: string, params: Json | undefined): Promise<Json | void>;
+    objectCall?(caller: ComponentRef, object: number, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void>;
     objectNotify?(caller: ComponentRef, object: number, notification: string, params: Json | undefined): Promise<void>;
     objectDestroy?(caller: ComponentRef, object: number, interfaceName: string): Promise<void>;
     getPid?(): number;
@@ -213,7 +213,7 @@ export class ComponentInstance implements ComponentContext {
     }
 
 
-    async objectCall(caller: ComponentInstance, objectId: number, method: string, params: Json | undefined): Promise<Json | void> {
+    async objectCall(caller: ComponentInstance, objectId: number, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void> {
         if (!this.isActivated()) {
             throw createError(ErrorCode.InvalidRequest, `${caller.getId()}: component ${this.getName()} is not active`);
         }
@@ -223,14 +223,14 @@ export class ComponentInstance implements ComponentContext {
         }
 
         if (this.impl.objectCall) {
-            return this.impl.objectCall(this.createCallerView(caller), objectId, method, params);
+            return this.impl.objectCall(this.createCallerView(caller), objectId, method, params, signal);
         }
 
         return await this.impl.call(this.createCallerView(caller), `$/object/call`, {
             object: objectId,
             method,
             params: params ?? {}
-        });
+        }, signal);
     }
 
     async objectNotify(caller: ComponentInstance, objectId: number, notification: string, params: Json | undefined): Promise<void> {
@@ -272,7 +272,7 @@ export class ComponentInstance implements ComponentContext {
         });
     }
 
-    async call(caller: ComponentInstance, method: string, params: Json | undefined): Promise<Json | void> {
+    async call(caller: ComponentInstance, method: string, params: Json | undefined, signal?: AbortSignal): Promise<Json | void> {
         if (!this.isActivated()) {
             throw createError(ErrorCode.InvalidRequest, `${caller.getId()}: component ${this.getName()} is not active`);
         }
@@ -281,7 +281,7 @@ export class ComponentInstance implements ComponentContext {
             throw createError(ErrorCode.InvalidParams, `${caller.getId()}: component ${this.getName()} has no method ${method}`);
         }
 
-        return await this.impl.call(this.createCallerView(caller), method, params);
+        return await this.impl.call(this.createCallerView(caller), method, params, signal);
     }
 
     async notify(caller: ComponentInstance, notification: string, params: Json | undefined) {
@@ -65,14 +65,14 @@ export async function createObject(caller: ComponentRef, objectName: string, int
             deactivate: (_context: ComponentContext) => {
                 return externalComponent.deactivate();
             },
-            call: (_caller: ComponentRef, method: string, params: Json | undefined) => {
-                return externalComponent.call({ method, params: params ?? null });
+            call: (_caller: ComponentRef, method: string, params: Json | undefined, signal?: AbortSignal) => {
+                return externalComponent.call({ method, params: params ?? null }, signal);
             },
             notify: async (_caller: ComponentRef, notification: string, params: Json | undefined) => {
                 await externalComponent.notify({ method: notification, params: params ?? null });
             },
-            objectCall: (_caller: ComponentRef, object: number, method: string, params: Json | undefined) => {
-                return externalComponent.objectCall({ object, method, params: params ?? null });
+            objectCall: (_caller: ComponentRef, object: number, method: string, params: Json | undefined, signal?: AbortSignal) => {
+                return externalComponent.objectCall({ object, method, params: params ?? null }, signal);
             },
             objectNotify: async (_caller: ComponentRef, object: number, notification: string, params: Json | undefined) => {
                 await externalComponent.objectNotify({ object, method: notification, params: params ?? null });
@@ -139,7 +139,7 @@ export function getName(objectId: number) {
     return objectInstance.objectName;
 }
 
-export function call(caller: ComponentRef, objectId: number, method: string, params: Json) {
+export function call(caller: ComponentRef, objectId: number, method: string, params: Json, signal?: AbortSignal) {
     const instance = objects[objectId];
 
     if (!instance) {
@@ -156,7 +156,7 @@ export function call(caller: ComponentRef, objectId: number, method: string, par
         throw createError(ErrorCode.InvalidRequest, "Cannot find object component");
     }
 
-    return component.objectCall(callerComponent, objectId, method, params);
+    return component.objectCall(callerComponent, objectId, method, params, signal);
 }
 
 export function notify(caller: ComponentRef, objectId: number, notification: string, params: Json) {
@@ -233,8 +233,8 @@ export async function handleObjectGetList(_caller: ComponentRef, request: Object
     };
 }
 
-export async function handleObjectCall(caller: ComponentRef, request: ObjectCallRequest): Promise<ObjectCallResponse> {
-    return await objects.call(caller, request.object, request.method, request.params) ?? {}
+export async function handleObjectCall(caller: ComponentRef, request: ObjectCallRequest, signal?: AbortSignal): Promise<ObjectCallResponse> {
+    return await objects.call(caller, request.object, request.method, request.params, signal) ?? {}
 }
 
 export async function handleObjectNotify(caller: ComponentRef, request: ObjectNotifyRequest) {
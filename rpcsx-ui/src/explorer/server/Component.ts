@@ -33,8 +33,20 @@ export class ExplorerComponent implements IDisposable {
         this.items = [];
     }
 
-    private async tryDescribe(paths: string[], describers: self.Describer[]) {
-        const described = await Promise.all(describers.map(d => d.describe({ uris: paths })));
+    // Aborting refresh cancels in-flight describe requests, whatever they
+    // still return is dropped instead of being added
+    private async tryDescribe(paths: string[], describers: self.Describer[], abortSignal: AbortSignal) {
+        const described = await Promise.all(describers.map(d => d.describe({ uris: paths }, abortSignal))).catch(e => {
+            if (abortSignal.aborted) {
+                return undefined;
+            }
+
+            throw e;
+        });
+
+        if (!described || abortSignal.aborted) {
+            return [];
+        }
 
         const items = described.map(item => {
             return item.results.map(result => {
@@ -77,8 +89,8 @@ export class ExplorerComponent implements IDisposable {
             while (workList.length > 0) {
                 const notDescribedLocations: string[] = [];
 
-                while (workList.length > 0) {
-                    notDescribedLocations.push(...await this.tryDescribe(workList.slice(0, 10), describers));
+                while (workList.length > 0 && !abortSignal.aborted) {
+                    notDescribedLocations.push(...await this.tryDescribe(workList.slice(0, 10), describers, abortSignal));
                     workList = workList.slice(10);
                 }
 
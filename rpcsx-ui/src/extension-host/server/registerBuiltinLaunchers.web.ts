@@ -5,6 +5,7 @@ import { fork, spawn } from "child_process";
 import { Duplex, Readable, Writable } from "stream";
 import { EventEmitter } from "events";
 import { fileURLToPath } from "url";
+import * as zlib from "zlib";
 import * as self from "$";
 import * as core from "$core";
 import packageJson from '../../../../package.json' with { type: "json" };
@@ -29,12 +30,58 @@ type ResponseError = {
 type Response = ResponseValue | ResponseError | void;
 type ErrorHandler = (error: ResponseError) => void;
 
+type FrameDecoder = (body: Buffer) => Buffer;
+
+// frame body encodings this host can decode, in order of preference
+const frameDecoders: { [encoding: string]: FrameDecoder } = {};
+
+if ("zstdDecompressSync" in zlib && typeof zlib.zstdDecompressSync == 'function') {
+    const zstdDecompressSync = zlib.zstdDecompressSync as FrameDecoder;
+    frameDecoders["zstd"] = body => zstdDecompressSync(body);
+}
+
+frameDecoders["deflate"] = body => zlib.inflateSync(body);
+
 const clientInfo: ClientInfo = Object.freeze({
     name: packageJson.name,
     version: packageJson.version,
-    capabilities: {}
+    capabilities: {
+        frameEncodings: Object.keys(frameDecoders)
+    }
 });
 
+type FrameHeader = {
+    contentLength: number;
+    contentEncoding?: string;
+};
+
+function parseFrameHeader(header: string): FrameHeader | undefined {
+    let contentLength: number | undefined;
+    let contentEncoding: string | undefined;
+
+    for (const line of header.split('\r\n')) {
+        const separator = line.indexOf(':');
+        if (separator < 0) {
+            continue;
+        }
+
+        const name = line.substring(0, separator).trim().toLowerCase();
+        const value = line.substring(separator + 1).trim();
+
+        if (name == "content-length") {
+            contentLength = parseInt(value, 10);
+        } else if (name == "content-encoding") {
+            contentEncoding = value;
+        }
+    }
+
+    if (contentLength === undefined || isNaN(contentLength)) {
+        return undefined;
+    }
+
+    return { contentLength, contentEncoding };
+}
+
 class JsonRpcProtocol implements ExternalComponentInterface {
     private alive = true;
     private expectedResponses: {
@@ -47,7 +94,7 @@ class JsonRpcProtocol implements ExternalComponentInterface {
 
     private nextMessageId = 1;
     private errorHandlers: ErrorHandler[] = [];
-    private messageBuffer = "";
+    private messageBuffer = Buffer.alloc(0);
     private processingQueue: (() => Promise<void>)[] = [];
     private responseWatchdog: NodeJS.Timeout | null = null;
     private exitController = new AbortController();
@@ -63,7 +110,7 @@ class JsonRpcProtocol implements ExternalComponentInterface {
             version: manifest.version,
         };
 
-        extensionProcess.stdout.on('data', (message: string) => {
+        extensionProcess.stdout.on('data', (message: Buffer | string) => {
             this.receive(message);
         });
 
@@ -183,8 +230,8 @@ class JsonRpcProtocol implements ExternalComponentInterface {
         }
     }
 
-    objectCall(_caller: ComponentRef, request: ExternalComponentObjectCallRequest): ExternalComponentObjectCallResponse | Promise<ExternalComponentObjectCallResponse> {
-        return this.callMethod("$/object/call", request);
+    objectCall(_caller: ComponentRef, request: ExternalComponentObjectCallRequest, signal?: AbortSignal): ExternalComponentObjectCallResponse | Promise<ExternalComponentObjectCallResponse> {
+        return this.callMethod("$/object/call", request, signal);
     }
 
     objectDestroy(_caller: ComponentRef, request: ExternalComponentObjectDestroyRequest): void | Promise<void> {
@@ -229,11 +276,11 @@ class JsonRpcProtocol implements ExternalComponentInterface {
     }
 
     async sendNotify(notification: string, params?: Json) {
-        this.send({ jsonrpc: "2.0", notification, params });
+        this.send({ jsonrpc: "2.0", method: notification, params });
     }
 
-    call(_caller: ComponentRef, params: ExternalComponentCallRequest): Promise<ExternalComponentCallResponse> {
-        return this.callMethod(params.method, params.params);
+    call(_caller: ComponentRef, params: ExternalComponentCallRequest, signal?: AbortSignal): Promise<ExternalComponentCallResponse> {
+        return this.callMethod(params.method, params.params, signal);
     }
 
     notify(_caller: ComponentRef, params: ExternalComponentNotifyRequest) {
@@ -255,8 +302,8 @@ class JsonRpcProtocol implements ExternalComponentInterface {
         };
     }
 
-    private async receive(message: string) {
-        this.messageBuffer += message;
+    private async receive(message: Buffer | string) {
+        this.messageBuffer = Buffer.concat([this.messageBuffer, typeof message == "string" ? Buffer.from(message) : message]);
 
         await this.processQueue();
 
@@ -265,42 +312,52 @@ class JsonRpcProtocol implements ExternalComponentInterface {
         }
 
         const headerEndMark = "\r\n\r\n";
-        const contentLengthText = 'Content-Length:';
 
         while (true) {
-            const contentLengthPos = this.messageBuffer.indexOf(contentLengthText);
-            if (contentLengthPos < 0) {
-                break;
-            }
-
-            const headerEndPos = this.messageBuffer.indexOf(headerEndMark, contentLengthPos + contentLengthText.length);
+            const headerEndPos = this.messageBuffer.indexOf(headerEndMark);
 
             if (headerEndPos < 0) {
                 break;
             }
 
             const headerSize = headerEndPos + headerEndMark.length;
+            const header = parseFrameHeader(this.messageBuffer.toString('latin1', 0, headerEndPos));
 
-            const contentLengthEndPos = this.messageBuffer.indexOf('\r\n', contentLengthPos + contentLengthText.length);
-            const contentLengthString = this.messageBuffer.substring(contentLengthPos + contentLengthText.length, contentLengthEndPos).trim();
-            const contentLength = parseInt(contentLengthString, 10);
-
-            let rawBuffer = Buffer.from(this.messageBuffer);
+            if (!header) {
+                this.messageBuffer = this.messageBuffer.subarray(headerSize);
+                continue;
+            }
 
-            if (rawBuffer.length < headerSize + contentLength) {
+            if (this.messageBuffer.length < headerSize + header.contentLength) {
                 break;
             }
 
-            rawBuffer = rawBuffer.subarray(headerSize);
+            let rawBody = this.messageBuffer.subarray(headerSize, headerSize + header.contentLength);
+            this.messageBuffer = this.messageBuffer.subarray(headerSize + header.contentLength);
+
+            if (header.contentEncoding !== undefined && header.contentEncoding != "identity") {
+                const decoder = frameDecoders[header.contentEncoding];
+
+                if (!decoder) {
+                    this.debugLog(`unsupported frame encoding ${header.contentEncoding}`);
+                    continue;
+                }
+
+                try {
+                    rawBody = decoder(rawBody);
+                } catch (e) {
+                    this.debugLog(`failed to decode ${header.contentEncoding} frame: ${e}`);
+                    continue;
+                }
+            }
 
-            const body = rawBuffer.subarray(0, contentLength).toString('utf8');
-            this.messageBuffer = rawBuffer.subarray(contentLength).toString('utf8');
+            const body = rawBody.toString('utf8');
 
             this.debugLog(`<==== ${body}`);
 
             try {
                 const bodyObject = JSON.parse(body);
-                this.processingQueue.push(() => this.receiveObject(bodyObject));
+                this.processingQueue.push(() => this.receiveMessage(bodyObject));
             } catch {
                 continue;
             }
@@ -320,7 +377,38 @@ class JsonRpcProtocol implements ExternalComponentInterface {
         }
     }
 
-    private async receiveObject(message: object) {
+    private async receiveMessage(message: unknown) {
+        if (!Array.isArray(message)) {
+            const response = await this.receiveObject(message);
+
+            if (response) {
+                this.send(response);
+            }
+
+            return;
+        }
+
+        // members of batch are handled concurrently, their responses are sent
+        // back as one batch
+        if (message.length == 0) {
+            this.send({ jsonrpc: "2.0", id: null, error: { code: ErrorCode.InvalidRequest } });
+            return;
+        }
+
+        const responses = await Promise.all(message.map(item => this.receiveObject(item)));
+        const batch = responses.filter(response => response !== undefined);
+
+        if (batch.length > 0) {
+            this.send(batch);
+        }
+    }
+
+    // Returns response to request, if message is one
+    private async receiveObject(message: unknown): Promise<object | undefined> {
+        if (typeof message != "object" || message === null) {
+            return { jsonrpc: "2.0", id: null, error: { code: ErrorCode.InvalidRequest } };
+        }
+
         const id = "id" in message ? message["id"] as number | null : null;
 
         if ("error" in message) {
@@ -361,9 +449,9 @@ class JsonRpcProtocol implements ExternalComponentInterface {
             if (id !== null) {
                 try {
                     const result = await core.componentCall({ caller: this.manifest.name[0].text, method, params });
-                    this.send({ jsonrpc: "2.0", id, result });
+                    return { jsonrpc: "2.0", id, result };
                 } catch (error) {
-                    this.send({ jsonrpc: "2.0", id, error });
+                    return { jsonrpc: "2.0", id, error };
                 }
             } else {
                 core.componentNotify({ caller: this.manifest.name[0].text, notification: method, params }).catch(error => {
@@ -429,7 +517,6 @@ class NativeLauncher implements LauncherInterface {
             stdio: 'pipe'
         });
 
-        newProcess.stdout.setEncoding('utf8');
         newProcess.stderr.setEncoding('utf8');
         const pid = newProcess.pid ?? 0;
 
@@ -474,7 +561,6 @@ class NodeLauncher implements LauncherInterface {
             cwd: dirname(path),
         });
 
-        newProcess.stdout!.setEncoding('utf8');
         newProcess.stderr!.setEncoding('utf8');
         const pid = newProcess.pid ?? 0;
 